@@ -0,0 +1,437 @@
+#ifndef PROGRAM_GENERATOR_H
+#define PROGRAM_GENERATOR_H
+
+#include<algorithm>
+#include<cstdint>
+#include<exception>
+#include<filesystem>
+#include<fstream>
+#include<functional>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include"../include/Token.h"
+using namespace std;
+
+// 按种子生成合法的测试程序，规模和形状由GeneratorOptions控制，供benchmark测量编译器随输入规模的变化
+// 随机数用splitmix64并自己取模，同一种子在任何平台、任何标准库上都生成同样的程序
+// 函数只调用在它之前定义的函数，所以没有递归；程序只保证能通过编译，执行时间随调用扇出指数增长，不适合拿来执行
+// runnable时生成可以执行的程序：循环次数为不超过8的常数，循环中不调用函数，不调用会引起过多调用的函数
+
+struct GeneratorOptions {
+	uint64_t seed = 1;
+	int functions = 100; // 函数个数
+	uint64_t targetBytes = 0; // 非0时忽略functions，一直生成函数直到源码达到这个大小
+	int expressionDepth = 3; // 表达式树的最大深度
+	int nestingDepth = 3; // for/if的最大嵌套层数
+	int statementsPerBlock = 4; // 每个语句块最多几条语句
+	int variablesPerScope = 3; // 每个作用域最多声明几个局部变量
+	int callFanOut = 2; // 每个函数调用前面的函数的次数（前面有函数时）
+	int maxParameters = 3;
+	int globals = 4;
+	int arrays = 2; // 全局数组个数，常数次数的循环中会逐元素给它们赋值
+	int arraySize = 64;
+	bool runnable = false; // 生成执行时间有界的程序，用于比较VM、JIT、本机代码的结果（见上）
+};
+
+class ProgramGenerator {
+		GeneratorOptions options;
+		uint64_t state;
+		vector<int> arity; // 已生成的函数的形参个数，下标即函数编号
+		vector<uint64_t> calls; // 调用各函数一次引起的调用次数（包括这一次），runnable时使用
+		vector<string> scope; // 当前可见的变量：全局变量、形参、外层的局部变量和循环变量
+		string arrayIndex; // 最内层的、次数不超过数组大小的循环的循环变量，可以做数组下标；没有时为空
+		int nameCounter; // 局部变量、循环变量的编号，每个函数从0开始
+		int callsLeft; // 当前函数还可以生成几次调用
+		uint64_t callsMade; // 当前函数执行一次引起的调用次数
+		int loops; // 当前所在的循环层数
+		string out;
+		
+		static const uint64_t RUNNABLE_CALL_LIMIT = 100; // runnable时只调用引起的调用次数不超过这个数的函数，否则改调f0
+		
+		uint64_t next() {
+			uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+		
+		// [low, high]中的整数
+		int range(int low, int high) {
+			return low + (int)(next() % (uint64_t)(high - low + 1));
+		}
+		
+		bool chance(int percent) {
+			return range(0, 99) < percent;
+		}
+		
+		void indent(int depth) {
+			out.append(depth, '\t');
+		}
+		
+		// runnable时循环中不调用函数
+		bool canCall() const {
+			return callsLeft > 0 && !arity.empty() && !(options.runnable && loops > 0);
+		}
+		
+		void call() {
+			callsLeft--;
+			int callee = range(0, (int)arity.size() - 1);
+			
+			if (options.runnable && calls[callee] > RUNNABLE_CALL_LIMIT)
+				callee = 0;
+				
+			callsMade += calls[callee];
+			out += "f" + to_string(callee) + "(";
+			
+			for (int k = 0; k < arity[callee]; k++) {
+				out += k ? ", " : "";
+				expression(1);
+			}
+			
+			out += ")";
+		}
+		
+		void expression(int depth) {
+			int r = range(0, 99);
+			
+			if (depth <= 0 || r < 25) {
+				if (!scope.empty() && chance(70))
+					out += scope[range(0, (int)scope.size() - 1)];
+				else
+					out += to_string(range(0, 99));
+					
+				return;
+			}
+			
+			if (r < 35 && canCall()) {
+				call();
+				return;
+			}
+			
+			if (r < 42) {
+				out += "!(";
+				expression(depth - 1);
+				out += ")";
+				return;
+			}
+			
+			if (r < 48 && options.arrays > 0) {
+				out += "A" + to_string(range(0, options.arrays - 1)) + "[";
+				
+				if (!arrayIndex.empty())
+					out += arrayIndex;
+				else
+					out += to_string(range(0, options.arraySize - 1));
+					
+				out += "]";
+				return;
+			}
+			
+			static const char* const operators[] = {"+", "-", "*", "/", "+", "*", "<", ">", "<=", ">=", "==", "!=", "&&", "||"};
+			const char* op = operators[range(0, sizeof(operators) / sizeof(operators[0]) - 1)];
+			out += "(";
+			expression(depth - 1);
+			out += " ";
+			out += op;
+			out += " ";
+			
+			if (op[0] == '/') // 除数用正的常数，执行时不会除以0
+				out += to_string(range(1, 9));
+			else
+				expression(depth - 1);
+				
+			out += ")";
+		}
+		
+		void block(int nesting, int depth) {
+			size_t scopeSize = scope.size();
+			int statements = range(1, options.statementsPerBlock), declared = 0;
+			
+			for (int s = 0; s < statements; s++) {
+				int r = range(0, 99);
+				indent(depth);
+				
+				if (r < 30 && declared < options.variablesPerScope) {
+					string name = "v" + to_string(nameCounter++);
+					out += "int " + name + " = ";
+					expression(options.expressionDepth);
+					out += ";\n";
+					scope.push_back(name);
+					declared++;
+				}
+				else if (r < 55 && nesting < options.nestingDepth) {
+					out += "if (";
+					expression(options.expressionDepth);
+					out += ") {\n";
+					block(nesting + 1, depth + 1);
+					indent(depth);
+					out += "}\n";
+					
+					if (chance(30)) {
+						indent(depth);
+						out += "else if (";
+						expression(options.expressionDepth);
+						out += ") {\n";
+						block(nesting + 1, depth + 1);
+						indent(depth);
+						out += "}\n";
+					}
+					
+					if (chance(40)) {
+						indent(depth);
+						out += "else {\n";
+						block(nesting + 1, depth + 1);
+						indent(depth);
+						out += "}\n";
+					}
+				}
+				else if (r < 75 && nesting < options.nestingDepth) {
+					string name = "i" + to_string(nameCounter++), outerIndex = arrayIndex;
+					bool constantBound = scope.empty() || options.runnable || chance(60);
+					int maxBound = options.runnable ? min(8, options.arraySize) : options.arraySize;
+					string bound = constantBound ? to_string(range(1, maxBound)) : scope[range(0, (int)scope.size() - 1)];
+					out += "for (int " + name + " = 0; " + name + " < " + bound + "; " + name + "++;) {\n";
+					scope.push_back(name);
+					arrayIndex = constantBound ? name : "";
+					loops++;
+					block(nesting + 1, depth + 1);
+					loops--;
+					arrayIndex = outerIndex;
+					scope.pop_back();
+					indent(depth);
+					out += "}\n";
+				}
+				else if (r < 87 && !arrayIndex.empty() && options.arrays > 0) {
+					out += "A" + to_string(range(0, options.arrays - 1)) + "[" + arrayIndex + "] = ";
+					expression(options.expressionDepth);
+					out += ";\n";
+				}
+				else if (r < 92 && canCall()) {
+					call();
+					out += ";\n";
+				}
+				else {
+					// runnable时不给循环变量加1：加过后它可能等于循环次数，做数组下标时越界
+					string name = scope.empty() ? "" : scope[range(0, (int)scope.size() - 1)];
+					
+					if (!name.empty() && !(options.runnable && name[0] == 'i'))
+						out += name + "++;\n";
+					else
+						out += "int v" + to_string(nameCounter++) + " = " + to_string(range(0, 99)) + ";\n";
+				}
+			}
+			
+			scope.resize(scopeSize);
+		}
+		
+		void globalScope() {
+			scope.clear();
+			
+			for (int g = 0; g < options.globals; g++) {
+				scope.push_back("g" + to_string(g));
+			}
+		}
+		
+	public:
+		explicit ProgramGenerator(const GeneratorOptions& options) : options(options), state(options.seed), nameCounter(0),
+			callsLeft(0), callsMade(0), loops(0) {
+			if (options.arraySize < 1 || options.statementsPerBlock < 1)
+				throw invalid_argument("arraySize and statementsPerBlock must be positive");
+		}
+		
+		// 全局变量和全局数组
+		string prologue() {
+			out.clear();
+			
+			for (int g = 0; g < options.globals; g++) {
+				out += "int g" + to_string(g) + " = " + to_string(range(0, 99)) + ";\n";
+			}
+			
+			for (int a = 0; a < options.arrays; a++) {
+				out += "int A" + to_string(a) + "[" + to_string(options.arraySize) + "];\n";
+			}
+			
+			return move(out);
+		}
+		
+		// 下一个函数：形参、函数体，最后返回一个表达式加上还没用完的调用
+		string function() {
+			out.clear();
+			int index = (int)arity.size(), parameters = range(0, options.maxParameters);
+			globalScope();
+			nameCounter = 0;
+			callsLeft = options.callFanOut;
+			callsMade = 1;
+			arrayIndex.clear();
+			out += "int f" + to_string(index) + "(";
+			
+			for (int p = 0; p < parameters; p++) {
+				out += (p ? ", int p" : "int p") + to_string(p);
+				scope.push_back("p" + to_string(p));
+			}
+			
+			out += ") {\n";
+			block(0, 1);
+			out += "\treturn ";
+			expression(options.expressionDepth);
+			
+			while (canCall()) {
+				out += " + ";
+				call();
+			}
+			
+			out += ";\n}\n";
+			arity.push_back(parameters);
+			calls.push_back(callsMade);
+			return move(out);
+		}
+		
+		// 顶层语句：给数组赋初值，返回最后几个函数的调用结果之和
+		string epilogue() {
+			out.clear();
+			globalScope();
+			nameCounter = 0;
+			callsLeft = 0;
+			
+			if (options.arrays > 0) {
+				out += "for (int i = 0; i < " + to_string(options.arraySize) + "; i++;) {\n";
+				
+				for (int a = 0; a < options.arrays; a++) {
+					out += "\tA" + to_string(a) + "[i] = i * " + to_string(a + 2) + ";\n";
+				}
+				
+				out += "}\n";
+			}
+			
+			out += options.globals > 0 ? "return g0" : "return 0";
+			
+			for (int f = max(0, (int)arity.size() - 3); f < (int)arity.size(); f++) {
+				out += " + f" + to_string(f) + "(";
+				
+				for (int k = 0; k < arity[f]; k++) {
+					out += (k ? ", " : "") + to_string(range(0, 9));
+				}
+				
+				out += ")";
+			}
+			
+			out += ";\n";
+			return move(out);
+		}
+		
+		// 整个程序，按options的functions或targetBytes决定函数个数
+		string generate() {
+			string program = prologue();
+			
+			while (!targetReached(program.size())) {
+				program += function();
+			}
+			
+			return program + epilogue();
+		}
+		
+		// 逐个函数生成并写入文件，不在内存中保留整个程序（GB级的输入也可以生成），返回写入的字节数
+		uint64_t writeFile(const string& path) {
+			ofstream file(path, ios::binary);
+			string chunk = prologue();
+			uint64_t bytes = 0;
+			
+			while (!targetReached(bytes + chunk.size())) {
+				chunk += function();
+				
+				if (chunk.size() >= (1 << 20)) {
+					file.write(chunk.data(), chunk.size());
+					bytes += chunk.size();
+					chunk.clear();
+				}
+			}
+			
+			chunk += epilogue();
+			file.write(chunk.data(), chunk.size());
+			bytes += chunk.size();
+			
+			if (!file)
+				throw runtime_error("Cannot write " + path);
+				
+			return bytes;
+		}
+		
+		bool targetReached(uint64_t bytes) const {
+			return options.targetBytes ? bytes >= options.targetBytes : (int)arity.size() >= options.functions;
+		}
+		
+		size_t getFunctionCount() const {
+			return arity.size();
+		}
+};
+
+// 按种子在较小的范围内选择各参数，用于在大量形状不同的程序上做正确性检查（见各benchmark的--check）
+GeneratorOptions variedOptions(uint64_t seed) {
+	static const int arraySizes[] = {16, 24, 64, 100};
+	GeneratorOptions options;
+	options.seed = seed;
+	options.functions = 1 + seed % 12;
+	options.expressionDepth = seed / 3 % 5;
+	options.nestingDepth = seed / 7 % 4;
+	options.statementsPerBlock = 1 + seed / 11 % 5;
+	options.variablesPerScope = 1 + seed / 13 % 3;
+	options.callFanOut = seed / 17 % 4;
+	options.maxParameters = seed / 19 % 4;
+	options.globals = seed / 23 % 4;
+	options.arrays = seed / 29 % 3;
+	options.arraySize = arraySizes[seed / 31 % 4];
+	return options;
+}
+
+// 命令行为"--check [程序数]"时返回true，programs为程序数（默认300）
+bool checkRequested(int argc, char** argv, int& programs) {
+	if (argc < 2 || string(argv[1]) != "--check")
+		return false;
+		
+	programs = argc > 2 ? stoi(argv[2]) : 300;
+	return true;
+}
+
+// --check用的临时目录：系统临时目录下的name，清空后重新创建
+filesystem::path checkDirectory(const string& name) {
+	filesystem::path dir = filesystem::temp_directory_path() / name;
+	filesystem::remove_all(dir);
+	filesystem::create_directories(dir);
+	return dir;
+}
+
+// makeFile()返回的File（构造时已完成编译）优化前和优化后的汇编；编译出错时为"error: "加错误信息
+template<typename MakeFile>
+string compileOutput(MakeFile makeFile) {
+	try {
+		auto file = makeFile();
+		string output = file.getAssembly();
+		file.optimize();
+		return output + file.getAssembly();
+	}
+	catch (exception& e) {
+		return string("error: ") + e.what();
+	}
+}
+
+bool isCompileError(const string& output) {
+	return output.compare(0, 7, "error: ") == 0;
+}
+
+// 对seed = 1..programs按variedOptions(seed)（runnable时再加上runnable）生成程序交给checkProgram，每个程序的符号检查完后撤销
+// checkProgram发现不一致时打印原因并返回false，这时停止并返回1，全部通过时返回0（都可以直接作为main的返回值）
+int checkGeneratedPrograms(int programs, bool runnable, const function<bool(int seed, const string& source)>& checkProgram) {
+	for (int seed = 1; seed <= programs; seed++) {
+		SymbolScope symbols;
+		GeneratorOptions options = variedOptions(seed);
+		options.runnable = runnable;
+		
+		if (!checkProgram(seed, ProgramGenerator(options).generate()))
+			return 1;
+	}
+	
+	return 0;
+}
+
+#endif /*PROGRAM_GENERATOR_H*/
@@ -0,0 +1,176 @@
+// AST布局基准：每个节点占用的内存，以及整棵树的遍历耗时
+// 编译：g++ -std=c++2a -O2 benchmark/ast_layout_bench.cpp -o ast_layout_bench
+// 运行：./ast_layout_bench [源码大小MB]
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+using namespace std;
+
+// 统计解析期间节点之外的堆分配（子节点数组、属性表等）
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static size_t heapBytes = 0;
+static size_t heapCount = 0;
+
+void* operator new(size_t size) {
+	heapBytes += size;
+	heapCount++;
+	
+	if (void* p = malloc(size ? size : 1)) {
+		return p;
+	}
+	
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+string makeSource(size_t targetBytes) {
+	string src = "int global_var;\n\n";
+	int id = 0;
+	
+	while (src.size() < targetBytes) {
+		string f = "f" + to_string(id++);
+		src += "int " + f + "(int x, int y) {\n";
+		src += "\tint a = (x + 12) * y - 7 / 3;\n";
+		src += "\tif (a >= 10 && !(y == 3) || x != 2) {\n";
+		src += "\t\treturn a;\n";
+		src += "\t}\n";
+		src += "\tfor (int i = 0; i < 100; i++;) {\n";
+		src += "\t\tglobal_var++;\n";
+		src += "\t}\n";
+		src += "\treturn " + f + "(a, y);\n";
+		src += "}\n\n";
+	}
+	
+	return src;
+}
+
+// 显式栈遍历整棵树，按节点类型计数并累加符号编号（防止被优化掉）
+size_t walk(ASTBaseNode* root, size_t* countByType) {
+	size_t checksum = 0;
+	vector<ASTBaseNode*> stack = {root};
+	
+	while (!stack.empty()) {
+		ASTBaseNode* node = stack.back();
+		stack.pop_back();
+		
+		if (!node) {
+			continue;
+		}
+		
+		countByType[node->getNodeType()]++;
+		
+		switch (node->getNodeType()) {
+			case ASTBaseNode::EXPRESSION: {
+					Expression* expr = static_cast<Expression*>(node);
+					checksum += expr->value;
+					
+					if (expr->exprType == Expression::FUNC_CALL) {
+						for (Expression* param : static_cast<FunctionCall*>(expr)->parameters) {
+							stack.push_back(param);
+						}
+					}
+					else if (expr->exprType == Expression::UNARY_OPERATOR) {
+						stack.push_back(expr->operand);
+					}
+					else {
+						stack.push_back(expr->left);
+						stack.push_back(expr->right);
+					}
+					
+					break;
+				}
+				
+			case ASTBaseNode::VAR_DECL: {
+					VariableDeclaration* var = static_cast<VariableDeclaration*>(node);
+					checksum += var->varName;
+					stack.push_back(var->initExpr);
+					break;
+				}
+				
+			case ASTBaseNode::FUNC_DECL:
+				checksum += static_cast<FunctionDeclaration*>(node)->funcName;
+				break;
+				
+			case ASTBaseNode::IF_STATEMENT: {
+					IfStatement* ifStmt = static_cast<IfStatement*>(node);
+					stack.push_back(ifStmt->condition);
+					stack.push_back(ifStmt->thenBlock);
+					stack.push_back(ifStmt->elseBlock);
+					break;
+				}
+				
+			case ASTBaseNode::FOR_STATEMENT: {
+					ForStatement* forStmt = static_cast<ForStatement*>(node);
+					stack.push_back(forStmt->initStmt);
+					stack.push_back(forStmt->condition);
+					stack.push_back(forStmt->updateStmt);
+					stack.push_back(forStmt->body);
+					break;
+				}
+				
+			default:
+				break;
+		}
+		
+		for (ASTBaseNode* child : node->getAllChildren()) {
+			stack.push_back(child);
+		}
+	}
+	
+	return checksum;
+}
+
+int main(int argc, char** argv) {
+	size_t mb = argc > 1 ? stoul(argv[1]) : 16;
+	string source = makeSource(mb << 20);
+	Lexer lexer(source);
+	vector<Token> tokens = lexer.getAllToken();
+	
+	ASTContext* context = new ASTContext();
+	AST ast(tokens, *context);
+	size_t heapBytes0 = heapBytes, heapCount0 = heapCount;
+	auto t0 = chrono::steady_clock::now();
+	ASTBaseNode* root = ast.buildAST();
+	auto t1 = chrono::steady_clock::now();
+	size_t parseHeapBytes = heapBytes - heapBytes0, parseHeapCount = heapCount - heapCount0;
+	size_t arenaBytes = context->getTotalBytes();
+	
+	size_t countByType[16] = {};
+	size_t nodes = 0, checksum = 0;
+	double best = 1e100;
+	
+	for (int round = 0; round < 5; round++) {
+		fill(begin(countByType), end(countByType), 0);
+		auto w0 = chrono::steady_clock::now();
+		checksum = walk(root, countByType);
+		auto w1 = chrono::steady_clock::now();
+		best = min(best, chrono::duration<double, milli>(w1 - w0).count());
+	}
+	
+	for (size_t c : countByType) {
+		nodes += c;
+	}
+	
+	auto d0 = chrono::steady_clock::now();
+	delete context;
+	auto d1 = chrono::steady_clock::now();
+	
+	printf("input: %.2f MB, %zu tokens, %zu nodes (checksum %zu)\n",
+	       source.size() / 1048576.0, tokens.size(), nodes, checksum);
+	printf("parse    : %.1f ms\n", chrono::duration<double, milli>(t1 - t0).count());
+	printf("memory   : %.1f bytes/node in arena + %.1f bytes/node heap (%zu heap allocs)\n",
+	       (double)arenaBytes / nodes, (double)parseHeapBytes / nodes, parseHeapCount);
+	printf("traverse : %.1f ms (%.1f ns/node)\n", best, best * 1e6 / nodes);
+	printf("teardown : %.3f ms\n", chrono::duration<double, milli>(d1 - d0).count());
+	return 0;
+}
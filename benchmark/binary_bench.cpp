@@ -0,0 +1,203 @@
+// 二进制模块：同一个程序分别从源码编译（词法+语法+生成IR）、mmap打开二进制模块、打开后取出IR、打开后重建AST，比较耗时
+// --check：ProgramGenerator生成的程序优化前后分别写成模块，取出的IR、重建的AST再生成的IR须与编译结果完全相同；
+// 再随机改坏模块中IR的操作数，loadIR须拒绝，或者得到的IR交给VM和x86后端时只会报告错误（用-fsanitize=address编译可以查出越界访问）
+// 编译：g++ -std=c++2a -O2 benchmark/binary_bench.cpp -o binary_bench
+// 运行：./binary_bench [函数数] [轮数]，或./binary_bench --check [程序数]（源文件和模块写在系统临时目录下的myg_binary_bench中）
+#include<bits/stdc++.h>
+#include"../include/File.h"
+#include"./ProgramGenerator.h"
+using namespace std;
+
+// 和cache_bench一样的函数：两层循环加条件分支，调用前一个函数
+string makeSource(int functions) {
+	string source = "int total = 0;\n";
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string(f % 13 + 2);
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tfor (int j = 0; j < n; j++;) {\n"
+		          "\t\t\tif (i * j / " + k + " > j || i == j) {\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t\telse if (j * " + k + " < i + total) {\n"
+		          "\t\t\t\tint d = (i - j) * (i + " + k + ") / (j + 1);\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t}\n"
+		          "\t}\n";
+		source += f > 0 ? "\treturn c + f" + to_string(f - 1) + "(n - 1);\n}\n" : "\treturn c;\n}\n";
+	}
+	
+	return source + "return f" + to_string(functions - 1) + "(6);\n";
+}
+
+template<typename F>
+double timeMs(F f) {
+	auto start = chrono::steady_clock::now();
+	f();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+bool sameIR(const vector<IRInstr>& x, const vector<IRInstr>& y) {
+	return x.size() == y.size() && memcmp(x.data(), y.data(), x.size() * sizeof(IRInstr)) == 0;
+}
+
+// 模块取出的IR和重建AST再生成的IR（只对未优化的模块有意义）是否与expected相同
+bool roundTrips(const string& modulePath, const vector<IRInstr>& expected, bool checkAST) {
+	BinaryModule module(modulePath);
+	
+	if (!sameIR(module.loadIR(), expected))
+		return false;
+		
+	if (!checkAST)
+		return true;
+		
+	ASTContext context;
+	vector<IRInstr> rebuilt = getIRFromAST(module.loadAST(context));
+	peephole(rebuilt);
+	return sameIR(rebuilt, expected);
+}
+
+// 改坏模块中1到3条IR的某个操作数，返回loadIR是否接受；接受时VM和x86后端最多抛出runtime_error
+bool loadsCorrupted(const string& bytes, const string& corruptPath, mt19937& random) {
+	static const int values[] = {-1, 0, 1, 2, 7, 8, 64, 1000, INT_MAX, INT_MIN};
+	BinaryHeader header;
+	memcpy(&header, bytes.data(), sizeof(header));
+	const BinarySection& section = header.sections[SECTION_IR];
+	size_t count = section.size / sizeof(IRInstr);
+	string corrupt = bytes;
+	
+	for (int k = 0, n = 1 + random() % 3; k < n && count > 0; k++) {
+		int value = random() % 2 ? values[random() % 10] : (int)(random() % 100);
+		memcpy(&corrupt[section.offset + random() % count * sizeof(IRInstr) + 4 * (1 + random() % 3)], &value, 4);
+	}
+	
+	ofstream(corruptPath, ios::binary) << corrupt;
+	BinaryModule module(corruptPath);
+	vector<IRInstr> IR;
+	
+	try {
+		IR = module.loadIR();
+	}
+	catch (runtime_error&) {
+		return false;
+	}
+	
+	try {
+		VM vm(IR);
+	}
+	catch (runtime_error&) {}
+	
+	try {
+		X86Backend(IR).generate();
+	}
+	catch (runtime_error&) {}
+	
+	return true;
+}
+
+int check(int programs) {
+	filesystem::path dir = checkDirectory("myg_binary_bench");
+	string path = (dir / "source.txt").string(), modulePath = (dir / "source.myb").string();
+	string corruptPath = (dir / "corrupt.myb").string();
+	mt19937 random(1);
+	int accepted = 0, rejected = 0;
+	int status = checkGeneratedPrograms(programs, false, [&](int seed, const string& source) {
+		ofstream(path, ios::binary) << source;
+		File file(path, false);
+		
+		for (int optimized = 0; optimized < 2; optimized++) {
+			if (optimized)
+				file.optimize();
+				
+			file.saveBinary(modulePath);
+			
+			if (!roundTrips(modulePath, file.getIR(), !optimized)) {
+				printf("seed %d: module does not reproduce the %s IR\n", seed, optimized ? "optimized" : "compiled");
+				return false;
+			}
+		}
+		
+		ifstream in(modulePath, ios::binary);
+		string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		
+		for (int k = 0; k < 10; k++) {
+			loadsCorrupted(bytes, corruptPath, random) ? accepted++ : rejected++;
+		}
+		
+		return true;
+	});
+	
+	if (status != 0)
+		return status;
+		
+	printf("%d programs: modules reproduce the IR before and after optimization; %d corrupted modules rejected, %d loaded safely\n",
+	       programs, rejected, accepted);
+	filesystem::remove_all(dir);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int programs;
+	
+	if (checkRequested(argc, argv, programs))
+		return check(programs);
+		
+	int functions = argc > 1 ? stoi(argv[1]) : 400;
+	int reps = argc > 2 ? stoi(argv[2]) : 10;
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_binary_bench";
+	filesystem::create_directories(dir);
+	string path = (dir / "source.txt").string(), modulePath = (dir / "source.myb").string();
+	string source = makeSource(functions);
+	ofstream(path, ios::binary) << source;
+	
+	File reference(path, false);
+	reference.saveBinary(modulePath);
+	const vector<IRInstr>& expected = reference.getIR();
+	bool same = true;
+	double parse = 1e30, open = 1e30, loadIR = 1e30, loadAST = 1e30;
+	size_t nodes = 0, strings = 0;
+	
+	// 各种情形轮流执行，每种取最快的一次，减少机器负载变化的影响
+	for (int r = 0; r < reps; r++) {
+		parse = min(parse, timeMs([&] {
+			File file(path, false);
+		}));
+		
+		open = min(open, timeMs([&] {
+			BinaryModule module(modulePath);
+			nodes = module.nodeCount();
+		}));
+		
+		vector<IRInstr> IR;
+		loadIR = min(loadIR, timeMs([&] {
+			BinaryModule module(modulePath);
+			IR = module.loadIR();
+		}));
+		same = same && sameIR(IR, expected);
+		
+		// 重建的AST再生成一遍IR，应与从源码编译的相同（不计入时间）
+		ASTContext context;
+		ASTBaseNode* root = nullptr;
+		loadAST = min(loadAST, timeMs([&] {
+			BinaryModule module(modulePath);
+			root = module.loadAST(context);
+			strings = module.stringCount();
+		}));
+		vector<IRInstr> rebuilt = getIRFromAST(root);
+		peephole(rebuilt);
+		same = same && sameIR(rebuilt, expected);
+	}
+	
+	printf("%d functions, %.1f KB of source, %.1f KB of module (%zu nodes, %zu strings, IR %zu)\n", functions,
+	       source.size() / 1024.0, filesystem::file_size(modulePath) / 1024.0, nodes, strings, expected.size());
+	printf("%-22s %10s %10s\n", "", "ms", "vs source");
+	printf("%-22s %10.3f %9.2fx\n", "compile from source", parse, 1.0);
+	printf("%-22s %10.3f %9.2fx\n", "open module", open, parse / open);
+	printf("%-22s %10.3f %9.2fx\n", "open + load IR", loadIR, parse / loadIR);
+	printf("%-22s %10.3f %9.2fx\n", "open + load AST", loadAST, parse / loadAST);
+	printf("output %s\n", same ? "identical" : "MISMATCH");
+	return same ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// 编译缓存：同一个源文件分别不用缓存、缓存为空、缓存全部命中、只改动一个函数时编译，比较耗时
+// 只改动一个函数时的额外开销应接近单个函数的编译时间（不用缓存的时间 / 函数个数）
+// --check：在ProgramGenerator生成的程序及其各种改动（删掉全局变量、数组、函数，改变形参个数，改动函数体）上，
+// 比较用缓存与不用缓存的输出（优化前后的汇编，或编译错误信息）是否完全相同
+// 编译：g++ -std=c++2a -O2 benchmark/cache_bench.cpp -o cache_bench
+// 运行：./cache_bench [函数数] [轮数]，或./cache_bench --check [程序数]（源文件和缓存目录在系统临时目录下的myg_cache_bench中）
+#include<bits/stdc++.h>
+#include"../include/File.h"
+#include"./ProgramGenerator.h"
+using namespace std;
+
+// 每个函数两层循环加条件分支并调用前一个函数，edited号函数中的常数换成change
+string makeSource(int functions, int edited, int change) {
+	string source = "int total = 0;\n";
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string(f == edited ? change : f % 13 + 2);
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tfor (int j = 0; j < n; j++;) {\n"
+		          "\t\t\tif (i * j / " + k + " > j || i == j) {\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t\telse if (j * " + k + " < i + total) {\n"
+		          "\t\t\t\tint d = (i - j) * (i + " + k + ") / (j + 1);\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t}\n"
+		          "\t}\n";
+		source += f > 0 ? "\treturn c + f" + to_string(f - 1) + "(n - 1);\n}\n" : "\treturn c;\n}\n";
+	}
+	
+	return source + "return f" + to_string(functions - 1) + "(6);\n";
+}
+
+template<typename F>
+double timeMs(F f) {
+	auto start = chrono::steady_clock::now();
+	f();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// 删掉source中从第一个pattern开始到end为止（含）的部分，找不到时不改
+string removeFirst(const string& source, const string& pattern, const string& end) {
+	size_t begin = source.find(pattern);
+	
+	if (begin == string::npos)
+		return source;
+		
+	size_t stop = source.find(end, begin);
+	return source.substr(0, begin) + source.substr(stop == string::npos ? source.size() : stop + end.size());
+}
+
+// 原程序和各种改动：删掉第一个全局变量、第一个数组、f0，给f0加一个形参，在最后一个函数体开头加一条语句
+vector<string> makeEdits(const string& source) {
+	vector<string> edits = {source, removeFirst(source, "int g", ";\n"), removeFirst(source, "int A", ";\n"),
+	                        removeFirst(source, "int f0(", "\n}\n")
+	                       };
+	size_t f0 = source.find("int f0(");
+	
+	if (f0 != string::npos) {
+		bool noParameters = source.compare(f0 + 7, 1, ")") == 0;
+		edits.push_back(source.substr(0, f0 + 7) + (noParameters ? "int extra" : "int extra, ") + source.substr(f0 + 7));
+	}
+	
+	size_t body = source.rfind(") {\n");
+	
+	if (body != string::npos)
+		edits.push_back(source.substr(0, body + 4) + "\tint edited = 1;\n" + source.substr(body + 4));
+		
+	return edits;
+}
+
+// 每个程序先用缓存编译一遍（写入缓存），再对原程序和每种改动分别比较：不用缓存、用缓存、再用一次缓存（改动后的缓存项已写入）
+int check(int programs) {
+	filesystem::path dir = checkDirectory("myg_cache_bench");
+	string path = (dir / "source.txt").string();
+	CompileCache cache((dir / "cache").string());
+	int compared = 0, errors = 0;
+	auto output = [&](CompileCache* cache) {
+		return compileOutput([&] {
+			return File(path, false, cache);
+		});
+	};
+	int status = checkGeneratedPrograms(programs, false, [&](int seed, const string& original) {
+		ofstream(path, ios::binary) << original;
+		output(&cache);
+		
+		for (const string& source : makeEdits(original)) {
+			ofstream(path, ios::binary) << source;
+			string expected = output(nullptr);
+			
+			for (int pass = 0; pass < 2; pass++) {
+				if (output(&cache) != expected) {
+					printf("seed %d: cached output differs from uncached (pass %d)\n%s", seed, pass, source.c_str());
+					return false;
+				}
+			}
+			
+			compared++;
+			errors += isCompileError(expected);
+			ofstream(path, ios::binary) << original;
+			output(&cache);
+		}
+		
+		return true;
+	});
+	
+	if (status != 0)
+		return status;
+		
+	printf("%d programs, %d variants (%d with compile errors): cached output identical, %zu hits, %zu misses\n", programs,
+	       compared, errors, cache.getHits(), cache.getMisses());
+	filesystem::remove_all(dir);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int programs;
+	
+	if (checkRequested(argc, argv, programs))
+		return check(programs);
+		
+	int functions = argc > 1 ? stoi(argv[1]) : 400;
+	int reps = argc > 2 ? stoi(argv[2]) : 10;
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_cache_bench";
+	filesystem::remove_all(dir);
+	filesystem::create_directories(dir);
+	string path = (dir / "source.txt").string(), coldDir = (dir / "cold").string();
+	string original = makeSource(functions, -1, 0);
+	ofstream(path, ios::binary) << original;
+	
+	File reference(path, false);
+	string expected = reference.getAssembly();
+	CompileCache cache((dir / "cache").string());
+	bool same = true;
+	double plain = 1e30, cold = 1e30, warm = 1e30, edited = 1e30;
+	size_t editMisses = 0;
+	
+	// 各种情形轮流执行，每种取最快的一次，减少机器负载变化的影响
+	for (int r = 0; r < reps; r++) {
+		ofstream(path, ios::binary) << original;
+		File(path, false, &cache); // 缓存恢复为原来的源码
+		
+		plain = min(plain, timeMs([&] {
+			File file(path, false);
+		}));
+		
+		// 从空的缓存开始：完整编译并写入全部缓存项
+		filesystem::remove_all(coldDir);
+		CompileCache coldCache(coldDir);
+		cold = min(cold, timeMs([&] {
+			File file(path, false, &coldCache);
+		}));
+		
+		warm = min(warm, timeMs([&] {
+			File file(path, false, &cache);
+		}));
+		same = same && File(path, false, &cache).getAssembly() == expected;
+		
+		// 改动中间的一个函数（每次换一个新的常数，保证不命中）
+		ofstream(path, ios::binary) << makeSource(functions, functions / 2, 1000 + r);
+		size_t misses = cache.getMisses();
+		edited = min(edited, timeMs([&] {
+			File file(path, false, &cache);
+		}));
+		editMisses = cache.getMisses() - misses;
+	}
+	
+	printf("%d functions, %.1f KB of source, IR %zu\n", functions, original.size() / 1024.0, reference.getIR().size());
+	printf("%-22s %10s %10s\n", "", "ms", "vs plain");
+	printf("%-22s %10.3f %9.2fx\n", "no cache", plain, 1.0);
+	printf("%-22s %10.3f %9.2fx\n", "cold cache", cold, plain / cold);
+	printf("%-22s %10.3f %9.2fx\n", "warm cache", warm, plain / warm);
+	printf("%-22s %10.3f %9.2fx\n", "one function edited", edited, plain / edited);
+	printf("one function's compile time ~%.3f ms, edit costs %.3f ms over warm (%zu misses per edit)\n", plain / functions,
+	       edited - warm, editMisses);
+	printf("output %s\n", same ? "identical" : "MISMATCH");
+	return same ? 0 : 1;
+}
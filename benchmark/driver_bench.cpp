@@ -0,0 +1,87 @@
+// 并行编译：生成一批源文件，分别用1、2、4……个线程编译（含优化和生成汇编），比较吞吐量和相对单线程的加速比
+// 编译：g++ -std=c++2a -O2 -pthread benchmark/driver_bench.cpp -o driver_bench
+// 运行：./driver_bench [文件数] [每个文件的函数数]（源文件和.s写在系统临时目录下的myg_driver_bench中）
+#include<bits/stdc++.h>
+#include"../include/Driver.h"
+using namespace std;
+
+// 和pass_bench一样的函数：两层循环加条件分支，顶层语句调用全部函数并求和
+string makeSource(int seed, int functions) {
+	string source;
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string((seed + f) % 13 + 2);
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tfor (int j = 0; j < n; j++;) {\n"
+		          "\t\t\tif (i * j / " + k + " > j || i == j) {\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t}\n"
+		          "\t}\n"
+		          "\treturn c;\n"
+		          "}\n";
+	}
+	
+	source += "int s = 0";
+	
+	for (int f = 0; f < functions; f++) {
+		source += " + f" + to_string(f) + "(" + to_string(f % 7 + 3) + ")";
+	}
+	
+	return source + ";\nreturn s;\n";
+}
+
+int main(int argc, char** argv) {
+	int fileCount = argc > 1 ? stoi(argv[1]) : 400;
+	int functions = argc > 2 ? stoi(argv[2]) : 40;
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_driver_bench";
+	filesystem::create_directories(dir);
+	vector<string> inputs;
+	size_t bytes = 0;
+	
+	for (int i = 0; i < fileCount; i++) {
+		string path = (dir / ("f" + to_string(i) + ".txt")).string();
+		string source = makeSource(i, functions);
+		ofstream(path, ios::binary) << source;
+		inputs.push_back(path);
+		bytes += source.size();
+	}
+	
+	unsigned cores = max(1u, thread::hardware_concurrency());
+	vector<size_t> jobs = {1};
+	
+	for (size_t j = 2; j < cores; j *= 2) {
+		jobs.push_back(j);
+	}
+	
+	if (cores > 1)
+		jobs.push_back(cores);
+		
+	printf("%d files, %.2f MB of source, %u hardware threads\n", fileCount, bytes / 1048576.0, cores);
+	printf("%-6s %10s %12s %8s %11s\n", "jobs", "ms", "files/s", "speedup", "efficiency");
+	double baseMs = 0;
+	
+	for (size_t j : jobs) {
+		DriverOptions options;
+		options.jobs = j;
+		auto start = chrono::steady_clock::now();
+		vector<CompileResult> results = compileFiles(inputs, options);
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		
+		for (const CompileResult& result : results) {
+			if (!result.ok) {
+				printf("%s: %s\n", result.input.c_str(), result.error.c_str());
+				return 1;
+			}
+		}
+		
+		if (j == 1)
+			baseMs = ms;
+			
+		printf("%-6zu %10.1f %12.1f %7.2fx %10.0f%%\n", j, ms, fileCount * 1000 / ms, baseMs / ms, baseMs / ms / j * 100);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,65 @@
+// 测试程序生成器的命令行入口：按种子和参数生成一个合法的程序，写到文件或标准输出
+// 编译：g++ -std=c++2a -O2 benchmark/gen_program.cpp -o gen_program
+// 运行：./gen_program [--seed=N] [--functions=N] [--size=KB] [--depth=N] [--nesting=N] [--statements=N]
+//                     [--vars=N] [--fanout=N] [--params=N] [--globals=N] [--arrays=N] [--array-size=N] [--runnable] [-o 文件]
+//   --size 按源码大小（KB）生成，给出时忽略--functions；--depth 表达式深度；--nesting for/if嵌套层数
+//   --statements 每个语句块的最多语句数；--vars 每个作用域的最多局部变量数；--fanout 每个函数调用其他函数的次数
+//   --runnable 生成执行时间有界、可以拿来执行的程序
+#include<bits/stdc++.h>
+#include"./ProgramGenerator.h"
+using namespace std;
+
+int main(int argc, char** argv) {
+	GeneratorOptions options;
+	string output;
+	vector<pair<string, int*>> knobs = {
+		{"--functions=", &options.functions}, {"--depth=", &options.expressionDepth}, {"--nesting=", &options.nestingDepth},
+		{"--statements=", &options.statementsPerBlock}, {"--vars=", &options.variablesPerScope},
+		{"--fanout=", &options.callFanOut}, {"--params=", &options.maxParameters}, {"--globals=", &options.globals},
+		{"--arrays=", &options.arrays}, {"--array-size=", &options.arraySize}
+	};
+	
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool matched = false;
+		
+		for (auto& knob : knobs) {
+			if (arg.compare(0, knob.first.size(), knob.first) == 0) {
+				*knob.second = stoi(arg.substr(knob.first.size()));
+				matched = true;
+			}
+		}
+		
+		if (matched)
+			continue;
+			
+		if (arg.compare(0, 7, "--seed=") == 0) {
+			options.seed = stoull(arg.substr(7));
+		}
+		else if (arg.compare(0, 7, "--size=") == 0) {
+			options.targetBytes = stoull(arg.substr(7)) * 1024;
+		}
+		else if (arg == "--runnable") {
+			options.runnable = true;
+		}
+		else if (arg == "-o" && i + 1 < argc) {
+			output = argv[++i];
+		}
+		else {
+			cerr << "Unknown option: " << arg << endl;
+			return 2;
+		}
+	}
+	
+	ProgramGenerator generator(options);
+	
+	if (!output.empty()) {
+		uint64_t bytes = generator.writeFile(output);
+		cerr << output << ": " << bytes << " bytes, " << generator.getFunctionCount() << " functions" << endl;
+	}
+	else {
+		cout << generator.generate();
+	}
+	
+	return 0;
+}
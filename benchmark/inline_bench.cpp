@@ -0,0 +1,95 @@
+// 内联：热循环里反复调用小函数，比较不内联和内联时虚拟机执行的指令数、虚拟机和JIT的运行时间
+// 编译：g++ -std=c++2a -O2 benchmark/inline_bench.cpp -o inline_bench
+// 运行：./inline_bench [循环次数]（JIT一栏需要x86-64）
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/Opt/Pipeline.h"
+#include"../include/VM/VM.h"
+#include"../include/CodeGen/JIT.h"
+using namespace std;
+
+// 和code.txt中的add()一样的小函数，在两层循环里被调用；scale的第二个实参是字面量，内联后可以特化
+string makeProgram(int n) {
+	return "int add(int a, int b) {\n"
+	       "\treturn a + b;\n"
+	       "}\n"
+	       "int scale(int x, int k) {\n"
+	       "\tif (k == 0) {\n"
+	       "\t\treturn 0;\n"
+	       "\t}\n"
+	       "\treturn x * k;\n"
+	       "}\n"
+	       "int count(int n) {\n"
+	       "\tint c = 0;\n"
+	       "\tfor (int i = 0; i < n; i++;) {\n"
+	       "\t\tfor (int j = 0; j < n; j++;) {\n"
+	       "\t\t\tif (add(scale(i, 3), j) > add(j, 100)) {\n"
+	       "\t\t\t\tc++;\n"
+	       "\t\t\t}\n"
+	       "\t\t}\n"
+	       "\t}\n"
+	       "\treturn c;\n"
+	       "}\n"
+	       "return count(" + to_string(n) + ");\n";
+}
+
+template<typename F>
+double timeMs(F f) {
+	auto start = chrono::steady_clock::now();
+	f();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int n = argc > 1 ? stoi(argv[1]) : 1000;
+	string source = makeProgram(n);
+	Lexer lexer(source);
+	vector<Token> tokens = lexer.getAllToken();
+	ASTContext context;
+	AST ast(tokens, context);
+	vector<IRInstr> original = getIRFromAST(ast.buildAST());
+	
+	InlineOptions noInline;
+	noInline.maxCalleeSize = -1;
+	noInline.constantArgBonus = 0;
+	struct Config {
+		const char* name;
+		InlineOptions options;
+	};
+	vector<Config> configs = {{"no inlining", noInline}, {"inlining", InlineOptions()}};
+	int expected = VM(original).run();
+	
+	printf("%-12s %8s %14s %10s %10s\n", "config", "IR", "VM instrs", "VM ms", "JIT ms");
+	
+	for (const Config& config : configs) {
+		vector<IRInstr> IR = original;
+		PassManager passes;
+		addStandardPasses(passes, config.options);
+		passes.run(IR);
+		
+		VM vm(IR);
+		uint64_t executed = 0;
+		int result = vm.run(executed);
+		double vmMs = timeMs([&] {
+			result = vm.run();
+		});
+		
+		JIT jit(IR);
+		int jitResult = 0;
+		double jitMs = timeMs([&] {
+			jitResult = jit.run();
+		});
+		
+		if (result != expected || jitResult != expected) {
+			printf("%s: result mismatch (expected %d, VM %d, JIT %d)\n", config.name, expected, result, jitResult);
+			return 1;
+		}
+		
+		printf("%-12s %8zu %14llu %10.2f %10.2f\n", config.name, IR.size(), (unsigned long long)executed, vmMs, jitMs);
+	}
+	
+	printf("result %d\n", expected);
+	return 0;
+}
@@ -0,0 +1,220 @@
+// JIT端到端时间：从源代码到结果（词法、语法、IR、生成机器码、执行）的总耗时，与虚拟机和cc汇编链接的方式对比
+// --check：ProgramGenerator按runnable生成的程序，优化前后的IR分别在VM、JIT（SSE2，CPU支持时还有AVX2）和cc汇编链接的
+// 本机程序上执行，结果须与未优化IR在VM上的结果相同
+// 编译：g++ -std=c++2a -O2 benchmark/jit_bench.cpp -o jit_bench
+// 运行：./jit_bench [重复次数]，或./jit_bench --check [程序数]（需要Linux x86-64；cc一栏和本机程序还需要系统的cc）
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/Opt/Pipeline.h"
+#include"../include/VM/VM.h"
+#include"../include/CodeGen/X86Backend.h"
+#include"../include/CodeGen/JIT.h"
+#include"./ProgramGenerator.h"
+using namespace std;
+
+struct Program {
+	const char* name;
+	string source;
+};
+
+vector<Program> makePrograms() {
+	return {
+		{
+			"tiny",
+			"int add(int a, int b) {\n"
+			"\treturn a + b;\n"
+			"}\n"
+			"return add(40, 2);\n"
+		},
+		{
+			"nested loops",
+			"int count(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tfor (int j = 0; j < n; j++;) {\n"
+			"\t\t\tif (i * j / 7 > j || i == j) {\n"
+			"\t\t\t\tc++;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c;\n"
+			"}\n"
+			"return count(2000);\n"
+		},
+		{
+			"recursion",
+			"int fib(int n) {\n"
+			"\tif (n < 2) {\n"
+			"\t\treturn n;\n"
+			"\t}\n"
+			"\treturn fib(n - 1) + fib(n - 2);\n"
+			"}\n"
+			"return fib(27);\n"
+		},
+		{
+			"division by -1", // INT_MIN / -1回绕，与VM一致，不崩溃
+			"int m(int a, int b) {\n"
+			"\treturn a / b;\n"
+			"}\n"
+			"return m(2147483648, 0 - 1) + m(7, 0 - 1);\n"
+		}
+	};
+}
+
+// 前端：源代码 -> IR
+vector<IRInstr> frontEnd(const string& source) {
+	Lexer lexer(source);
+	vector<Token> tokens = lexer.getAllToken();
+	ASTContext context;
+	AST ast(tokens, context);
+	return getIRFromAST(ast.buildAST());
+}
+
+template<typename F>
+double bestOf(int rounds, F f) {
+	double best = 1e100;
+	
+	for (int round = 0; round < rounds; round++) {
+		auto t0 = chrono::steady_clock::now();
+		f();
+		auto t1 = chrono::steady_clock::now();
+		best = min(best, chrono::duration<double, milli>(t1 - t0).count());
+	}
+	
+	return best;
+}
+
+// 输出myg_top的返回值的C驱动，--check中用来得到本机程序完整的结果（退出码只有低8位）
+const char* DRIVER =
+    "#include <stdio.h>\n"
+    "int myg_top(void);\n"
+    "int main(void) {\n"
+    "\tprintf(\"%d\\n\", myg_top());\n"
+    "\treturn 0;\n"
+    "}\n";
+
+int runNative(const vector<IRInstr>& IR, const string& dir) {
+	ofstream(dir + "/check.s") << X86Backend(IR, false).generate();
+	string build = "cc -o " + dir + "/check " + dir + "/driver.o " + dir + "/check.s";
+	
+	if (system(build.c_str()) != 0)
+		throw runtime_error("assembling/linking failed");
+		
+	FILE* pipe = popen((dir + "/check").c_str(), "r");
+	int result;
+	bool ok = pipe && fscanf(pipe, "%d", &result) == 1;
+	
+	if (!pipe || pclose(pipe) != 0 || !ok)
+		throw runtime_error("running the native program failed");
+		
+	return result;
+}
+
+int check(int programs) {
+	string dir = checkDirectory("myg_jit_bench").string();
+	ofstream(dir + "/driver.c") << DRIVER;
+	bool haveCC = system(("cc -c -o " + dir + "/driver.o " + dir + "/driver.c > /dev/null 2>&1").c_str()) == 0;
+	bool avx2 = JIT::hostSupportsAvx2();
+	int status = checkGeneratedPrograms(programs, true, [&](int seed, const string& source) {
+		vector<IRInstr> compiled = frontEnd(source), optimized = compiled;
+		PassManager passes;
+		addStandardPasses(passes);
+		passes.run(optimized);
+		VM reference(compiled);
+		int expected = reference.run();
+		vector<pair<string, int>> results;
+		
+		for (const vector<IRInstr>* IR : {&compiled, &optimized}) {
+			string prefix = IR == &optimized ? "optimized, " : "";
+			VM vm(*IR);
+			results.emplace_back(prefix + "vm", vm.run());
+			results.emplace_back(prefix + "jit sse2", JIT(*IR, false).run());
+			
+			if (avx2)
+				results.emplace_back(prefix + "jit avx2", JIT(*IR, true).run());
+				
+			if (haveCC)
+				results.emplace_back(prefix + "native", runNative(*IR, dir));
+		}
+		
+		for (const auto& [name, result] : results) {
+			if (result != expected) {
+				printf("seed %d: %s returned %d, vm %d\n%s", seed, name.c_str(), result, expected, source.c_str());
+				return false;
+			}
+		}
+		
+		return true;
+	});
+	
+	if (status != 0)
+		return status;
+		
+	printf("%d programs: vm, jit (sse2%s)%s agree before and after optimization\n", programs, avx2 ? ", avx2" : "",
+	       haveCC ? " and native" : "");
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int programs;
+	
+	if (checkRequested(argc, argv, programs))
+		return check(programs);
+		
+	int rounds = argc > 1 ? stoi(argv[1]) : 5;
+	string dir = "/tmp/myg_jit_bench";
+	system(("mkdir -p " + dir).c_str());
+	bool haveCC = system("cc --version > /dev/null 2>&1") == 0;
+	printf("%-14s %-10s %12s %12s %12s %12s\n", "program", "result", "front end", "jit total", "vm total", "cc total");
+	
+	for (const Program& program : makePrograms()) {
+		int jitResult = 0, vmResult = 0, ccResult = 0;
+		double frontMs = bestOf(rounds, [&] {
+			frontEnd(program.source);
+		});
+		double jitMs = bestOf(rounds, [&] {
+			JIT jit(frontEnd(program.source));
+			jitResult = jit.run();
+		});
+		double vmMs = bestOf(rounds, [&] {
+			VM vm(frontEnd(program.source));
+			vmResult = vm.run();
+		});
+		
+		if (jitResult != vmResult) {
+			printf("%s: result mismatch (jit %d, vm %d)\n", program.name, jitResult, vmResult);
+			return 1;
+		}
+		
+		// cc方式：生成汇编、汇编链接为可执行文件、运行并读取退出码（只比较低8位）
+		double ccMs = 0;
+		
+		if (haveCC) {
+			ccMs = bestOf(rounds, [&] {
+				ofstream(dir + "/program.s") << X86Backend(frontEnd(program.source)).generate();
+				string build = "cc -o " + dir + "/program " + dir + "/program.s";
+				
+				if (system(build.c_str()) != 0)
+					ccResult = -1;
+				else
+					ccResult = WEXITSTATUS(system((dir + "/program").c_str()));
+			});
+			
+			if (ccResult != (vmResult & 0xFF)) {
+				printf("%s: result mismatch (cc exit code %d, vm %d)\n", program.name, ccResult, vmResult);
+				return 1;
+			}
+		}
+		
+		printf("%-14s %-10d %9.3f ms %9.3f ms %9.3f ms ", program.name, vmResult, frontMs, jitMs, vmMs);
+		
+		if (haveCC)
+			printf("%9.3f ms\n", ccMs);
+		else
+			printf("%12s\n", "n/a");
+	}
+	
+	return 0;
+}
@@ -0,0 +1,157 @@
+// 词法分析吞吐量对比：旧的 format()+temp.txt 往返 vs mmap+单遍Lexer
+// 编译：g++ -std=c++2a -O2 benchmark/lexer_bench.cpp -o lexer_bench
+// 运行：./lexer_bench [源码大小MB]
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/SourceBuffer.h"
+using namespace std;
+
+// 生成测试源码：重复若干个带表达式、if、for的函数
+string makeSource(size_t targetBytes) {
+	string src = "int global_var;\n\n";
+	int id = 0;
+	
+	while (src.size() < targetBytes) {
+		string f = "f" + to_string(id++);
+		src += "int " + f + "(int x, int y) {\n";
+		src += "\tint a = (x + 12) * y - 7 / 3;\n";
+		src += "\tif (a >= 10 && !(y == 3) || x != 2) {\n";
+		src += "\t\treturn a;\n";
+		src += "\t}\n";
+		src += "\tfor (int i = 0; i < 100; i++;) {\n";
+		src += "\t\tglobal_var++;\n";
+		src += "\t}\n";
+		src += "\treturn " + f + "(a, y);\n";
+		src += "}\n\n";
+	}
+	
+	return src;
+}
+
+// 旧实现：逐行插入空格写入temp.txt，再用>>读回
+namespace legacy {
+	const string symbolList = "+-*/=(){}[];,&|!><";
+	
+	bool issymbol(char c) {
+		return symbolList.find(c) != symbolList.npos;
+	}
+	
+	bool islitter(char c) {
+		return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+	}
+	
+	// 旧Token持有自己的字符串，这里用deque保存内容以保持string_view有效
+	vector<Token> tokenize(const string& fileName, const string& tempName, deque<string>& contents) {
+		fstream codeFile(fileName);
+		fstream tempFile(tempName, ios::out | ios::in | ios::trunc);
+		string line = "";
+		
+		while (getline(codeFile, line)) {
+			for (size_t i = 0; i < line.size(); i++) {
+				tempFile << line[i];
+				bool isMultiCharOp = false;
+				
+				if (i + 1 < line.size()) {
+					string twoChars = string(1, line[i]) + string(1, line[i + 1]);
+					
+					if (twoChars == "&&" || twoChars == "||" ||
+					twoChars == "==" || twoChars == "!=" ||
+					twoChars == ">=" || twoChars == "<=" ||
+					twoChars == "++") {
+						isMultiCharOp = true;
+					}
+				}
+				
+				if (issymbol(line[i])) {
+					if ((i + 1 < line.size()) && isdigit(line[i + 1]) && !isMultiCharOp) {
+						tempFile << " ";
+					}
+					
+					if ((i + 1 < line.size()) && islitter(line[i + 1]) && !isMultiCharOp) {
+						tempFile << " ";
+					}
+					
+					if ((i + 1 < line.size()) && issymbol(line[i + 1]) && !isMultiCharOp) {
+						tempFile << " ";
+					}
+				}
+				
+				if (isdigit(line[i])) {
+					if ((i + 1 < line.size()) && issymbol(line[i + 1])) {
+						tempFile << " ";
+					}
+				}
+				
+				if (islitter(line[i])) {
+					if ((i + 1 < line.size()) && issymbol(line[i + 1])) {
+						tempFile << " ";
+					}
+				}
+			}
+			
+			tempFile << "\n";
+		}
+		
+		tempFile.seekg(0, std::ios::beg);
+		vector<Token> tokens;
+		string content = "";
+		int c = 0;
+		
+		while (tempFile >> content) {
+			contents.push_back(content);
+			tokens.push_back({contents.back(), (size_t)c});
+			c += content.size() + 1;
+		}
+		
+		return tokens;
+	}
+}
+
+// 新实现：mmap源文件后单遍扫描
+size_t lexFile(const string& fileName) {
+	SourceBuffer source;
+	source.open(fileName);
+	Lexer lexer(source.view());
+	return lexer.getAllToken().size();
+}
+
+template<typename F>
+double timeIt(F f, int rounds) {
+	double best = 1e100;
+	
+	for (int i = 0; i < rounds; i++) {
+		auto t0 = chrono::steady_clock::now();
+		f();
+		auto t1 = chrono::steady_clock::now();
+		best = min(best, chrono::duration<double>(t1 - t0).count());
+	}
+	
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t mb = argc > 1 ? stoul(argv[1]) : 8;
+	string source = makeSource(mb << 20);
+	const string fileName = "lexer_bench_input.txt";
+	const string tempName = "lexer_bench_temp.txt";
+	ofstream(fileName, ios::binary) << source;
+	
+	size_t legacyCount = 0, lexerCount = 0;
+	double legacyTime = timeIt([&]() {
+		deque<string> contents;
+		legacyCount = legacy::tokenize(fileName, tempName, contents).size();
+	}, 3);
+	double lexerTime = timeIt([&]() {
+		lexerCount = lexFile(fileName);
+	}, 3);
+	
+	double sizeMB = source.size() / 1048576.0;
+	printf("input: %.2f MB\n", sizeMB);
+	printf("format()+temp.txt : %zu tokens, %.3f s, %.1f MB/s\n", legacyCount, legacyTime, sizeMB / legacyTime);
+	printf("Lexer (mmap)      : %zu tokens, %.3f s, %.1f MB/s\n", lexerCount, lexerTime, sizeMB / lexerTime);
+	printf("speedup: %.2fx\n", legacyTime / lexerTime);
+	
+	remove(fileName.c_str());
+	remove(tempName.c_str());
+	return legacyCount == lexerCount ? 0 : 1;
+}
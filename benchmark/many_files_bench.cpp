@@ -0,0 +1,69 @@
+// 大量源文件的编译：每个文件声明几百个别的文件中没有的全局变量，单线程依次编译500、1000、2000……个文件
+// 每个文件的符号在编译完后撤销（SymbolScope），每个文件的耗时应与文件数无关；再与各文件用相同名字的情况比较
+// 编译：g++ -std=c++2a -O2 -pthread benchmark/many_files_bench.cpp -o many_files_bench
+// 运行：./many_files_bench [最多文件数] [每个文件的全局变量数]（源文件和.s写在系统临时目录下的myg_many_files_bench中）
+#include<bits/stdc++.h>
+#include"../include/Driver.h"
+using namespace std;
+
+// prefix为空时各文件的名字相同
+string makeSource(const string& prefix, int globals) {
+	string source, sum = "return 0";
+	
+	for (int g = 0; g < globals; g++) {
+		string name = prefix + "g" + to_string(g);
+		source += "int " + name + " = " + to_string(g % 97) + ";\n";
+		
+		if (g % 10 == 0)
+			sum += " + " + name;
+	}
+	
+	source += "int f(int n) {\n\treturn n + " + prefix + "g0;\n}\n";
+	return source + sum + " + f(3);\n";
+}
+
+// 单线程编译，返回总毫秒数
+double compileAll(const vector<string>& inputs) {
+	DriverOptions options;
+	options.jobs = 1;
+	auto start = chrono::steady_clock::now();
+	vector<CompileResult> results = compileFiles(inputs, options);
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	
+	for (const CompileResult& result : results) {
+		if (!result.ok)
+			throw runtime_error(result.input + ": " + result.error);
+	}
+	
+	return ms;
+}
+
+int main(int argc, char** argv) {
+	int maxFiles = argc > 1 ? stoi(argv[1]) : 4000;
+	int globals = argc > 2 ? stoi(argv[2]) : 300;
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_many_files_bench";
+	filesystem::create_directories(dir);
+	vector<string> distinct, shared;
+	
+	for (int i = 0; i < maxFiles; i++) {
+		string path = (dir / ("d" + to_string(i) + ".txt")).string();
+		ofstream(path, ios::binary) << makeSource("m" + to_string(i) + "_", globals);
+		distinct.push_back(path);
+		path = (dir / ("s" + to_string(i) + ".txt")).string();
+		ofstream(path, ios::binary) << makeSource("", globals);
+		shared.push_back(path);
+	}
+	
+	printf("%d globals per file, single thread\n", globals);
+	printf("%-8s %14s %14s %16s %16s\n", "files", "distinct ms", "shared ms", "distinct us/file", "shared us/file");
+	
+	for (int files = min(500, maxFiles); files <= maxFiles; files *= 2) {
+		vector<string> d(distinct.begin(), distinct.begin() + files), s(shared.begin(), shared.begin() + files);
+		double distinctMs = compileAll(d), sharedMs = compileAll(s);
+		printf("%-8d %14.1f %14.1f %16.1f %16.1f\n", files, distinctMs, sharedMs, distinctMs * 1000 / files,
+		       sharedMs * 1000 / files);
+	}
+	
+	filesystem::remove_all(dir);
+	return 0;
+}
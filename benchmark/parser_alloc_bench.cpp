@@ -0,0 +1,105 @@
+// 语法分析分配计数：统计解析约1MB源码时的堆分配次数与字节数
+// 编译：g++ -std=c++2a -O2 benchmark/parser_alloc_bench.cpp -o parser_alloc_bench
+// 运行：./parser_alloc_bench [源码大小KB]
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+using namespace std;
+
+// 全局分配计数（仅在counting为真时累计）
+// 替换全局operator new/delete，GCC会把内联后的free误报为不匹配
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static bool counting = false;
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+void* operator new(size_t size) {
+	if (counting) {
+		allocCount++;
+		allocBytes += size;
+	}
+	
+	if (void* p = malloc(size ? size : 1)) {
+		return p;
+	}
+	
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+string makeSource(size_t targetBytes) {
+	string src = "int global_var;\n\n";
+	int id = 0;
+	
+	while (src.size() < targetBytes) {
+		string f = "f" + to_string(id++);
+		src += "int " + f + "(int x, int y) {\n";
+		src += "\tint a = (x + 12) * y - 7 / 3;\n";
+		src += "\tif (a >= 10 && !(y == 3) || x != 2) {\n";
+		src += "\t\treturn a;\n";
+		src += "\t}\n";
+		src += "\tfor (int i = 0; i < 100; i++;) {\n";
+		src += "\t\tglobal_var++;\n";
+		src += "\t}\n";
+		src += "\treturn " + f + "(a, y);\n";
+		src += "}\n\n";
+	}
+	
+	return src;
+}
+
+// 统计f执行期间的分配
+template<typename F>
+pair<size_t, size_t> countAllocs(F f) {
+	allocCount = allocBytes = 0;
+	counting = true;
+	f();
+	counting = false;
+	return {allocCount, allocBytes};
+}
+
+int main(int argc, char** argv) {
+	size_t kb = argc > 1 ? stoul(argv[1]) : 1024;
+	string source = makeSource(kb << 10);
+	Lexer lexer(source);
+	vector<Token> tokens = lexer.getAllToken();
+	
+	ASTContext context;
+	AST* ast = nullptr;
+	ASTBaseNode* root = nullptr;
+	auto ctor = countAllocs([&]() {
+		ast = new AST(tokens, context);
+	});
+	ctor.first--; // 扣除new AST本身
+	ctor.second -= sizeof(AST);
+	
+	auto t0 = chrono::steady_clock::now();
+	auto parse = countAllocs([&]() {
+		root = ast->buildAST();
+	});
+	auto t1 = chrono::steady_clock::now();
+	
+	// 作为参照：旧构造函数整体拷贝Token数组的开销
+	auto copy = countAllocs([&]() {
+		vector<Token> copied(tokens);
+	});
+	
+	double ms = chrono::duration<double, milli>(t1 - t0).count();
+	printf("input: %.2f MB, %zu tokens, parse %.1f ms\n", source.size() / 1048576.0, tokens.size(), ms);
+	printf("AST(tokens)      : %zu allocs, %zu bytes\n", ctor.first, ctor.second);
+	printf("buildAST()       : %zu allocs, %zu bytes, %.3f allocs/token\n",
+	       parse.first, parse.second, (double)parse.first / tokens.size());
+	printf("ASTContext       : %zu nodes, %zu bytes in nodes, %zu bytes reserved\n",
+	       context.getObjectCount(), context.getTotalBytes(), context.getReservedBytes());
+	printf("(old token copy) : %zu allocs, %zu bytes\n", copy.first, copy.second);
+	return root ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// 优化流水线：生成含大量函数的程序，测量SSA构造/退出及各pass的耗时，并比较优化前后虚拟机执行的指令数和结果
+// 编译：g++ -std=c++2a -O2 benchmark/pass_bench.cpp -o pass_bench
+// 运行：./pass_bench [函数个数]
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/IR/PassManager.h"
+#include"../include/Opt/Pipeline.h"
+#include"../include/VM/VM.h"
+using namespace std;
+
+// 每个函数是两层循环加条件分支，顶层语句调用全部函数并求和
+// 和code.txt一样夹带死代码：从未读取的局部变量和全局变量，以及每隔几个函数一个从未被调用的函数
+string makeProgram(int functions) {
+	string source = "int unused_global;\n";
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string(f % 13 + 2);
+		
+		if (f % 4 == 0) {
+			source += "int dead" + to_string(f) + "(int n) {\n"
+			          "\tint a;\n"
+			          "\tint b;\n"
+			          "\treturn n * " + k + ";\n"
+			          "}\n";
+		}
+		
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint a;\n"
+		          "\tint b = n * 2;\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tfor (int j = 0; j < n; j++;) {\n"
+		          "\t\t\tif (i * j / " + k + " > j || i == j) {\n"
+		          "\t\t\t\tc++;\n"
+		          "\t\t\t}\n"
+		          "\t\t\telse {\n"
+		          "\t\t\t\tif (j - i > " + k + " && !(i == 0)) {\n"
+		          "\t\t\t\t\tc++;\n"
+		          "\t\t\t\t}\n"
+		          "\t\t\t}\n"
+		          "\t\t}\n"
+		          "\t}\n"
+		          "\treturn c;\n"
+		          "}\n";
+	}
+	
+	source += "int s = 0";
+	
+	for (int f = 0; f < functions; f++) {
+		source += " + f" + to_string(f) + "(" + to_string(f % 7 + 3) + ")";
+	}
+	
+	return source + ";\nreturn s;\n";
+}
+
+int main(int argc, char** argv) {
+	int functions = argc > 1 ? stoi(argv[1]) : 2000;
+	string source = makeProgram(functions);
+	Lexer lexer(source);
+	vector<Token> tokens = lexer.getAllToken();
+	ASTContext context;
+	AST ast(tokens, context);
+	vector<IRInstr> IR = getIRFromAST(ast.buildAST());
+	uint64_t executedBefore = 0, executedAfter = 0;
+	int expected = VM(IR).run(executedBefore);
+	
+	// 只做窥孔优化（File不调用optimize()时的情形）
+	size_t rawSize = IR.size();
+	vector<IRInstr> peepholeIR = IR;
+	uint64_t executedPeephole = 0;
+	auto start = chrono::steady_clock::now();
+	peephole(peepholeIR);
+	double peepholeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	int peepholeResult = VM(peepholeIR).run(executedPeephole);
+	
+	PassManager passes(true); // 每个pass之后检查SSA形式
+	addStandardPasses(passes);
+	passes.run(IR);
+	int result = VM(IR).run(executedAfter);
+	
+	printf("%d functions, %zu bytes of source\n", functions, source.size());
+	passes.printTiming();
+	
+	if (result != expected || peepholeResult != expected) {
+		printf("result mismatch (before %d, peephole only %d, after %d)\n", expected, peepholeResult, result);
+		return 1;
+	}
+	
+	printf("peephole only: %.3f ms, IR instructions %zu -> %zu, executed IR instructions %llu -> %llu\n", peepholeMs,
+	       rawSize, peepholeIR.size(), (unsigned long long)executedBefore, (unsigned long long)executedPeephole);
+	printf("result %d, executed IR instructions %llu -> %llu\n", result, (unsigned long long)executedBefore,
+	       (unsigned long long)executedAfter);
+	return 0;
+}
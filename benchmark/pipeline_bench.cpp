@@ -0,0 +1,162 @@
+// 流水线式词法/语法分析：同一个大源文件分别先完整词法分析再解析、词法线程与解析线程流水线进行，比较编译耗时和峰值内存
+// 每种方式在单独的子进程中编译，峰值内存取子进程的最大常驻集（wait4），互不影响；耗时取各轮中最快的一次
+// 词法与解析真正重叠需要至少两个核；单核上的差别来自不再构造和遍历整个Token序列
+// --check：ProgramGenerator生成的程序及其截断、插入坏字符或多余Token后的版本，流水线与先词法后解析的IR、汇编
+// 或报错信息须完全相同
+// 编译：g++ -std=c++2a -O2 -pthread benchmark/pipeline_bench.cpp -o pipeline_bench
+// 运行：./pipeline_bench [函数数] [轮数]，或./pipeline_bench --check [程序数]（源文件写在系统临时目录下的myg_pipeline_bench中）
+#include<bits/stdc++.h>
+#include<sys/resource.h>
+#include<sys/wait.h>
+#include<unistd.h>
+#include"../include/File.h"
+#include"./ProgramGenerator.h"
+using namespace std;
+
+// 每个函数一层循环加条件分支并调用前一个函数
+string makeSource(int functions) {
+	string source = "int total = 0;\n";
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string(f % 13 + 2);
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tif (i * " + k + " > n || i == " + k + ") {\n"
+		          "\t\t\tc++;\n"
+		          "\t\t}\n"
+		          "\t}\n";
+		source += f > 0 ? "\treturn c + f" + to_string(f - 1) + "(n - 1);\n}\n" : "\treturn c;\n}\n";
+	}
+	
+	return source + "return f" + to_string(functions - 1) + "(6);\n";
+}
+
+struct Measurement {
+	double ms;
+	long peakKB;
+	size_t instructions;
+};
+
+// 在子进程中编译一次，耗时和IR条数经管道传回
+Measurement measure(const string& path, bool pipelined) {
+	int fds[2];
+	
+	if (pipe(fds) != 0)
+		throw runtime_error("pipe failed");
+		
+	pid_t pid = fork();
+	
+	if (pid == 0) {
+		close(fds[0]);
+		auto start = chrono::steady_clock::now();
+		File file(path, false, nullptr, pipelined);
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		size_t instructions = file.getIR().size();
+		ssize_t written = write(fds[1], &ms, sizeof(ms)) + write(fds[1], &instructions, sizeof(instructions));
+		_exit(written == sizeof(ms) + sizeof(instructions) ? 0 : 1);
+	}
+	
+	close(fds[1]);
+	Measurement result = {0, 0, 0};
+	bool ok = read(fds[0], &result.ms, sizeof(result.ms)) == sizeof(result.ms) &&
+	          read(fds[0], &result.instructions, sizeof(result.instructions)) == sizeof(result.instructions);
+	close(fds[0]);
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	
+	if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		throw runtime_error("compile failed in child process");
+		
+	result.peakKB = usage.ru_maxrss;
+	return result;
+}
+
+// 原程序和改坏的版本：在随机位置截断、插入词法分析不认识的字符、插入多余的Token
+vector<string> makeVariants(const string& source, mt19937& random) {
+	static const char* const inserts[] = {"@", "$", ")", "{", "int", ";", "return", "0x"};
+	vector<string> variants = {source};
+	
+	for (int k = 0; k < 3; k++) {
+		variants.push_back(source.substr(0, random() % source.size()));
+	}
+	
+	for (const char* insert : inserts) {
+		string variant = source;
+		variants.push_back(variant.insert(random() % source.size(), insert));
+	}
+	
+	return variants;
+}
+
+int check(int programs) {
+	filesystem::path dir = checkDirectory("myg_pipeline_bench");
+	string path = (dir / "source.txt").string();
+	mt19937 random(1);
+	int compared = 0, errors = 0;
+	auto output = [&](bool pipelined) {
+		return compileOutput([&] {
+			return File(path, false, nullptr, pipelined);
+		});
+	};
+	int status = checkGeneratedPrograms(programs, false, [&](int seed, const string& original) {
+		for (const string& source : makeVariants(original, random)) {
+			ofstream(path, ios::binary) << source;
+			string expected = output(false);
+			
+			if (output(true) != expected) {
+				printf("seed %d: pipelined output differs from sequential\n%s", seed, source.c_str());
+				return false;
+			}
+			
+			compared++;
+			errors += isCompileError(expected);
+		}
+		
+		return true;
+	});
+	
+	if (status != 0)
+		return status;
+		
+	printf("%d programs, %d variants (%d with errors): pipelined output identical\n", programs, compared, errors);
+	filesystem::remove_all(dir);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int programs;
+	
+	if (checkRequested(argc, argv, programs))
+		return check(programs);
+		
+	int functions = argc > 1 ? stoi(argv[1]) : 100000;
+	int reps = argc > 2 ? stoi(argv[2]) : 3;
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_pipeline_bench";
+	filesystem::create_directories(dir);
+	string path = (dir / "source.txt").string();
+	string source = makeSource(functions);
+	ofstream(path, ios::binary) << source;
+	
+	Measurement sequential = {1e30, 0, 0}, pipelined = {1e30, 0, 0};
+	
+	// 两种方式轮流执行，每种取最快的一次，减少机器负载变化的影响
+	for (int r = 0; r < reps; r++) {
+		Measurement s = measure(path, false), p = measure(path, true);
+		sequential = {min(sequential.ms, s.ms), max(sequential.peakKB, s.peakKB), s.instructions};
+		pipelined = {min(pipelined.ms, p.ms), max(pipelined.peakKB, p.peakKB), p.instructions};
+	}
+	
+	printf("%d functions, %.1f MB of source, %u hardware threads\n", functions, source.size() / 1048576.0,
+	       thread::hardware_concurrency());
+	printf("%-22s %10s %12s %10s\n", "", "ms", "peak RSS MB", "IR");
+	printf("%-22s %10.1f %12.1f %10zu\n", "lex, then parse", sequential.ms, sequential.peakKB / 1024.0, sequential.instructions);
+	printf("%-22s %10.1f %12.1f %10zu\n", "pipelined", pipelined.ms, pipelined.peakKB / 1024.0, pipelined.instructions);
+	printf("speedup %.2fx, peak memory %.1f%% of sequential\n", sequential.ms / pipelined.ms,
+	       100.0 * pipelined.peakKB / sequential.peakKB);
+	bool same = sequential.instructions == pipelined.instructions;
+	printf("output %s\n", same ? "identical" : "MISMATCH");
+	filesystem::remove(path);
+	return same ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// 编译器随输入规模的变化：用ProgramGenerator生成从16KB起每次乘4、直到给定大小的程序，逐个完整编译（词法、语法、
+// 常量折叠、生成IR、优化、x86代码生成），输出每个阶段的耗时和按源码字节、Token、AST节点计的吞吐量，以及峰值内存
+// 每个大小在单独的子进程中编译，峰值内存取子进程的最大常驻集（wait4）；编译器的内存随输入线性增长，GB级的输入需要相应的内存
+// 编译：g++ -std=c++2a -O2 -pthread benchmark/scale_bench.cpp -o scale_bench
+// 运行：./scale_bench [最大MB] [--pipeline] [--seed=N]（默认64MB；源文件写在系统临时目录下的myg_scale_bench中）
+#include<bits/stdc++.h>
+#include<sys/resource.h>
+#include<sys/wait.h>
+#include<unistd.h>
+#include"../include/File.h"
+#include"./ProgramGenerator.h"
+using namespace std;
+
+struct Measurement {
+	double ms;
+	uint64_t tokens;
+	uint64_t nodes;
+	long peakKB;
+};
+
+uint64_t counter(const CompileStats& stats, const string& name) {
+	for (const auto& c : stats.getCounters()) {
+		if (c.first == name)
+			return c.second;
+	}
+	
+	return 0;
+}
+
+// 在子进程中编译一次并打印各阶段的表格，总耗时和计数经管道传回
+Measurement measure(const string& path, uint64_t bytes, bool pipelined) {
+	int fds[2];
+	
+	if (pipe(fds) != 0)
+		throw runtime_error("pipe failed");
+		
+	fflush(stdout);
+	pid_t pid = fork();
+	
+	if (pid == 0) {
+		close(fds[0]);
+		File file(path, false, nullptr, pipelined);
+		file.optimize();
+		file.getAssembly();
+		const CompileStats& stats = file.getStats();
+		Measurement result = {stats.totalMs(), counter(stats, "tokens"), counter(stats, "AST nodes"), 0};
+		double mb = bytes / 1048576.0;
+		
+		for (const PhaseStats& p : stats.getPhases()) {
+			double s = p.ms / 1000;
+			printf("  %-30s %10.1f %10.1f %10.2f %10.2f\n", p.name.c_str(), p.ms, mb / s, result.tokens / s / 1e6,
+			       result.nodes / s / 1e6);
+		}
+		
+		double s = result.ms / 1000;
+		printf("  %-30s %10.1f %10.1f %10.2f %10.2f\n", "total", result.ms, mb / s, result.tokens / s / 1e6,
+		       result.nodes / s / 1e6);
+		fflush(stdout);
+		bool ok = !file.getAssembly().empty() && write(fds[1], &result, sizeof(result)) == sizeof(result);
+		_exit(ok ? 0 : 1);
+	}
+	
+	close(fds[1]);
+	Measurement result = {0, 0, 0, 0};
+	bool ok = read(fds[0], &result, sizeof(result)) == sizeof(result);
+	close(fds[0]);
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	
+	if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		throw runtime_error("compile failed in child process");
+		
+	result.peakKB = usage.ru_maxrss;
+	return result;
+}
+
+int main(int argc, char** argv) {
+	uint64_t maxBytes = 64ull << 20;
+	bool pipelined = false;
+	GeneratorOptions options;
+	
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		
+		if (arg == "--pipeline")
+			pipelined = true;
+		else if (arg.compare(0, 7, "--seed=") == 0)
+			options.seed = stoull(arg.substr(7));
+		else
+			maxBytes = stoull(arg) << 20;
+	}
+	
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_scale_bench";
+	filesystem::create_directories(dir);
+	string path = (dir / "source.txt").string();
+	vector<pair<uint64_t, Measurement>> results;
+	
+	for (uint64_t target = 16 << 10; target <= maxBytes; target *= 4) {
+		options.targetBytes = target;
+		ProgramGenerator generator(options);
+		uint64_t bytes = generator.writeFile(path);
+		printf("%.2f MB, %zu functions%s\n", bytes / 1048576.0, generator.getFunctionCount(), pipelined ? ", pipelined" : "");
+		printf("  %-30s %10s %10s %10s %10s\n", "phase", "ms", "MB/s", "Mtok/s", "Mnodes/s");
+		Measurement m = measure(path, bytes, pipelined);
+		printf("  peak RSS %.1f MB (%.1f bytes per source byte)\n\n", m.peakKB / 1024.0, m.peakKB * 1024.0 / bytes);
+		results.emplace_back(bytes, m);
+	}
+	
+	// 各大小的汇总：吞吐量基本不变、峰值内存与源码大小成正比时，编译器对输入规模是线性的
+	printf("%12s %12s %10s %10s %10s %12s\n", "source MB", "tokens", "ms", "MB/s", "Mnodes/s", "peak RSS MB");
+	
+	for (const auto& [bytes, m] : results) {
+		printf("%12.2f %12llu %10.1f %10.1f %10.2f %12.1f\n", bytes / 1048576.0, (unsigned long long)m.tokens, m.ms,
+		       bytes / 1048576.0 / (m.ms / 1000), m.nodes / (m.ms / 1000) / 1e6, m.peakKB / 1024.0);
+	}
+	
+	filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,131 @@
+// 编译计量的开销：计数的operator new/delete与不计数的同样实现（即标准库中的版本）的每次差价、一对PhaseTimer的耗时，
+// 再按一次实际编译中的分配次数和阶段数估算计量占编译时间的比例
+// 编译：g++ -std=c++2a -O2 benchmark/stats_bench.cpp -o stats_bench
+// 运行：./stats_bench [函数数]（源文件写在系统临时目录下的myg_stats_bench中）
+#include<bits/stdc++.h>
+#include"../include/File.h"
+using namespace std;
+
+// 和pipeline_bench一样的函数：一层循环加条件分支，调用前一个函数
+string makeSource(int functions) {
+	string source = "int total = 0;\n";
+	
+	for (int f = 0; f < functions; f++) {
+		string k = to_string(f % 13 + 2);
+		source += "int f" + to_string(f) + "(int n) {\n"
+		          "\tint c = 0;\n"
+		          "\tfor (int i = 0; i < n; i++;) {\n"
+		          "\t\tif (i * " + k + " > n || i == " + k + ") {\n"
+		          "\t\t\tc++;\n"
+		          "\t\t}\n"
+		          "\t}\n";
+		source += f > 0 ? "\treturn c + f" + to_string(f - 1) + "(n - 1);\n}\n" : "\treturn c;\n}\n";
+	}
+	
+	return source + "return f" + to_string(functions - 1) + "(6);\n";
+}
+
+// 标准库中operator new/delete的做法，不计数，作为比较的基准
+[[gnu::noinline]] void* plainNew(size_t size) {
+	void* p;
+	
+	while (!(p = malloc(size ? size : 1))) {
+		new_handler handler = get_new_handler();
+		
+		if (!handler)
+			throw bad_alloc();
+			
+		handler();
+	}
+	
+	return p;
+}
+
+[[gnu::noinline]] void plainDelete(void* p, size_t) noexcept {
+	free(p);
+}
+
+// 每次操作的纳秒数，取5轮中最快的一轮
+template<typename F>
+double nsPerOp(size_t ops, F f) {
+	double best = 1e30;
+	
+	for (int r = 0; r < 5; r++) {
+		auto start = chrono::steady_clock::now();
+		f();
+		best = min(best, chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops);
+	}
+	
+	return best;
+}
+
+int main(int argc, char** argv) {
+	int functions = argc > 1 ? stoi(argv[1]) : 5000;
+	const size_t ops = 1 << 20;
+	vector<void*> blocks(64);
+	vector<size_t> sizes(64, 0);
+	
+	// 同时保持64个块，大小在16到1024字节之间变化，接近编译器中vector、string的分配模式
+	double counted = nsPerOp(ops, [&] {
+		for (size_t i = 0; i < ops; i++) {
+			size_t k = i & 63;
+			
+			if (blocks[k])
+				::operator delete(blocks[k], sizes[k]);
+				
+			sizes[k] = 16 + (i * 40) % 1009;
+			blocks[k] = ::operator new(sizes[k]);
+		}
+	});
+	double plain = nsPerOp(ops, [&] {
+		for (size_t i = 0; i < ops; i++) {
+			size_t k = i & 63;
+			
+			if (blocks[k])
+				plainDelete(blocks[k], sizes[k]);
+				
+			sizes[k] = 16 + (i * 40) % 1009;
+			blocks[k] = plainNew(sizes[k]);
+		}
+	});
+	
+	for (void*& block : blocks) {
+		free(block);
+		block = nullptr;
+	}
+	
+	PhaseStats phase("bench");
+	double timer = nsPerOp(ops, [&] {
+		for (size_t i = 0; i < ops; i++) {
+			PhaseTimer t(phase);
+		}
+	});
+	
+	filesystem::path dir = filesystem::temp_directory_path() / "myg_stats_bench";
+	filesystem::create_directories(dir);
+	string path = (dir / "source.txt").string();
+	ofstream(path, ios::binary) << makeSource(functions);
+	
+	auto start = chrono::steady_clock::now();
+	File file(path, false);
+	file.optimize();
+	file.getAssembly();
+	double compileMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	uint64_t allocations = 0, timers = 0;
+	
+	for (const PhaseStats& p : file.getStats().getPhases()) {
+		timers += p.runs;
+		
+		if (p.name.find('/') == string::npos)
+			allocations += p.allocations;
+	}
+	
+	double overheadMs = (allocations * max(0.0, counted - plain) + timers * timer) / 1e6;
+	printf("new + delete: %.1f ns counted, %.1f ns uncounted (%.1f ns extra)\n", counted, plain, counted - plain);
+	printf("PhaseTimer start + stop: %.1f ns\n", timer);
+	printf("compile of %d functions: %.1f ms, %llu allocations, %llu phase timers\n", functions, compileMs,
+	       (unsigned long long)allocations, (unsigned long long)timers);
+	printf("estimated instrumentation cost: %.3f ms (%.2f%% of the compile)\n", overheadMs, 100 * overheadMs / compileMs);
+	filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,104 @@
+// getTokenType 微基准：旧的 unordered_map 两次查找 vs 编译期完美哈希
+// 编译：g++ -std=c++2a -O2 benchmark/token_type_bench.cpp -o token_type_bench
+// 运行：./token_type_bench [Token数量(百万)]
+#include<bits/stdc++.h>
+#include"../include/Token.h"
+using namespace std;
+
+// 旧实现（原样保留用于对比）
+namespace legacy {
+	unordered_map<string, TokenType> StringToTokenType = {
+		{"int", Keywords}, {"return", Keywords},
+		{"if", Keywords}, {"else", Keywords},
+		{"for", Keywords},
+		{"+", Operators}, {"-", Operators},
+		{"*", Operators}, {"/", Operators},
+		{"&&", Operators}, {"||", Operators}, {"!", Operators},
+		{">", Operators}, {"<", Operators}, {"==", Operators},
+		{"!=", Operators}, {">=", Operators}, {"<=", Operators},
+		{"++", Operators}, {"=", Operators},
+		{"(", Punctuators}, {")", Punctuators},
+		{"[", Punctuators}, {"]", Punctuators},
+		{"{", Punctuators}, {"}", Punctuators},
+		{";", Punctuators}, {",", Punctuators}
+	};
+	
+	bool isStringDigit(const string& str) {
+		for (const char& c : str) {
+			if (!isdigit(c)) {
+				return 0;
+			}
+		}
+		
+		return 1;
+	}
+	
+	TokenType getTokenType(const string& str) {
+		if (StringToTokenType.find(str) != StringToTokenType.end()) {
+			return StringToTokenType[str];
+		}
+		else if (isStringDigit(str)) {
+			return Literals;
+		}
+		
+		return Identifiers;
+	}
+}
+
+// 按典型源码的比例混合关键字、标识符、数字和符号
+vector<string> makeLexemes(size_t count) {
+	const vector<string> pool = {
+		"int", "x", "=", "(", "a", "+", "12", ")", "*", "y", ";",
+		"if", "(", "counter", ">=", "10", "&&", "!", "flag", ")", "{",
+		"return", "value", ";", "}", "for", "(", "int", "i", "=", "0", ";",
+		"i", "<", "100", ";", "i", "++", ";", ")", "global_var", "++",
+		"add", "(", "a", ",", "b", ")", "else", "==", "!=", "<=", "||",
+		"some_long_identifier_name", "-", "/", "[", "]", "1234567"
+	};
+	mt19937 rng(12345);
+	vector<string> lexemes;
+	lexemes.reserve(count);
+	
+	for (size_t i = 0; i < count; i++) {
+		lexemes.push_back(pool[rng() % pool.size()]);
+	}
+	
+	return lexemes;
+}
+
+int main(int argc, char** argv) {
+	size_t millions = argc > 1 ? stoul(argv[1]) : 10;
+	vector<string> lexemes = makeLexemes(millions * 1000000);
+	vector<string_view> views(lexemes.begin(), lexemes.end());
+	
+	// 先验证两种实现分类一致
+	for (size_t i = 0; i < lexemes.size(); i++) {
+		if (legacy::getTokenType(lexemes[i]) != getTokenType(views[i])) {
+			printf("mismatch on \"%s\"\n", lexemes[i].c_str());
+			return 1;
+		}
+	}
+	
+	size_t checksum = 0;
+	auto t0 = chrono::steady_clock::now();
+	
+	for (const string& s : lexemes) {
+		checksum += legacy::getTokenType(s);
+	}
+	
+	auto t1 = chrono::steady_clock::now();
+	
+	for (string_view s : views) {
+		checksum += getTokenType(s);
+	}
+	
+	auto t2 = chrono::steady_clock::now();
+	double before = chrono::duration<double>(t1 - t0).count();
+	double after = chrono::duration<double>(t2 - t1).count();
+	double n = (double)lexemes.size();
+	printf("tokens: %zu (checksum %zu)\n", lexemes.size(), checksum);
+	printf("unordered_map : %.1f M tokens/s\n", n / before / 1e6);
+	printf("perfect hash  : %.1f M tokens/s\n", n / after / 1e6);
+	printf("speedup: %.2fx\n", before / after);
+	return 0;
+}
@@ -0,0 +1,114 @@
+// 向量化：数组上逐元素运算的循环分别按标量、SSE2（两个xmm）和AVX2（一个ymm）执行，每次处理VECTOR_WIDTH个元素
+// 比较虚拟机执行的指令数，以及JIT的运行时间和相对标量的加速比
+// 编译：g++ -std=c++2a -O2 benchmark/vectorize_bench.cpp -o vectorize_bench
+// 运行：./vectorize_bench [重复次数]（需要x86-64，AVX2一栏需要CPU支持）
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/Opt/Pipeline.h"
+#include"../include/VM/VM.h"
+#include"../include/CodeGen/JIT.h"
+using namespace std;
+
+struct Program {
+	const char* name;
+	string source;
+};
+
+// 数组先由标量循环填好（归纳变量参与运算，不向量化），再把kernel重复执行reps次
+string makeProgram(const string& kernel, int reps) {
+	return "int a[4096];\n"
+	       "int b[4096];\n"
+	       "int c[4096];\n"
+	       "int kernel(int n, int k) {\n"
+	       "\tfor (int i = 0; i < n; i++;) {\n"
+	       "\t\t" + kernel + "\n"
+	       "\t}\n"
+	       "\treturn c[n - 1];\n"
+	       "}\n"
+	       "for (int i = 0; i < 4096; i++;) {\n"
+	       "\ta[i] = i * 7 - 3000;\n"
+	       "\tb[i] = 5 - i * i;\n"
+	       "}\n"
+	       "for (int r = 0; r < " + to_string(reps) + "; r++;) {\n"
+	       "\tint last = kernel(4093, r);\n"
+	       "}\n"
+	       "return c[0] + c[100] + c[4091];\n";
+}
+
+vector<Program> makePrograms(int reps) {
+	return {
+		{"a * k + b", makeProgram("c[i] = a[i] * k + b[i];", reps)},
+		{"polynomial", makeProgram("c[i] = (a[i] * a[i] - b[i] * 3) * a[i] + b[i] * k - 11;", reps)},
+		// 只读的数组可以按不同的下标读
+		{"stencil", makeProgram("c[i] = a[i] + a[i + 1] * 2 + a[i + 2] - b[i + 1];", reps)}
+	};
+}
+
+template<typename F>
+double timeMs(F f) {
+	auto start = chrono::steady_clock::now();
+	f();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int reps = argc > 1 ? stoi(argv[1]) : 2000;
+	LoopOptions scalar;
+	scalar.vectorize = false;
+	struct Config {
+		const char* name;
+		LoopOptions options;
+		bool avx2;
+	};
+	vector<Config> configs = {{"scalar", scalar, false}, {"sse2", LoopOptions(), false}};
+	
+	if (JIT::hostSupportsAvx2())
+		configs.push_back({"avx2", LoopOptions(), true});
+		
+	for (const Program& program : makePrograms(reps)) {
+		Lexer lexer(program.source);
+		vector<Token> tokens = lexer.getAllToken();
+		ASTContext context;
+		AST ast(tokens, context);
+		vector<IRInstr> original = getIRFromAST(ast.buildAST());
+		int expected = VM(original).run();
+		double scalarMs = 0;
+		
+		printf("== %s ==\n", program.name);
+		printf("%-8s %6s %14s %10s %8s\n", "config", "IR", "VM instrs", "JIT ms", "speedup");
+		
+		for (const Config& config : configs) {
+			vector<IRInstr> IR = original;
+			PassManager passes;
+			addStandardPasses(passes, InlineOptions(), config.options);
+			passes.run(IR);
+			
+			VM vm(IR);
+			uint64_t executed = 0;
+			int result = vm.run(executed);
+			
+			JIT jit(IR, config.avx2);
+			int jitResult = jit.run(); // 预热
+			double jitMs = timeMs([&] {
+				jitResult = jit.run();
+			});
+			
+			if (result != expected || jitResult != expected) {
+				printf("%s: result mismatch (expected %d, VM %d, JIT %d)\n", config.name, expected, result, jitResult);
+				return 1;
+			}
+			
+			if (scalarMs == 0)
+				scalarMs = jitMs;
+				
+			printf("%-8s %6zu %14llu %10.2f %7.2fx\n", config.name, IR.size(), (unsigned long long)executed, jitMs,
+			       scalarMs / jitMs);
+		}
+		
+		printf("result %d\n\n", expected);
+	}
+	
+	return 0;
+}
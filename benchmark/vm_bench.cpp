@@ -0,0 +1,110 @@
+// 虚拟机执行速度：若干以for循环为主的程序，报告每秒执行的IR指令数
+// 编译：g++ -std=c++2a -O2 benchmark/vm_bench.cpp -o vm_bench
+// 运行：./vm_bench [重复次数]
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/VM/VM.h"
+using namespace std;
+
+struct Program {
+	const char* name;
+	string source;
+};
+
+vector<Program> makePrograms() {
+	return {
+		{
+			"nested loops", // 两层循环 + 条件计数
+			"int count(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tfor (int j = 0; j < n; j++;) {\n"
+			"\t\t\tif (i * j / 7 > j || i == j) {\n"
+			"\t\t\t\tc++;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c;\n"
+			"}\n"
+			"return count(2000);\n"
+		},
+		{
+			"calls in loop", // 循环体内调用小函数
+			"int sq(int x) {\n"
+			"\treturn x * x;\n"
+			"}\n"
+			"int sum(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tint t = sq(i) - i;\n"
+			"\t\tif (t > 100 && t / 3 != 5) {\n"
+			"\t\t\tc++;\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c;\n"
+			"}\n"
+			"return sum(3000000);\n"
+		},
+		{
+			"global counter", // 三层循环，最内层读写全局变量
+			"int g;\n"
+			"int run(int n) {\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tfor (int j = 0; j < n; j++;) {\n"
+			"\t\t\tfor (int k = 0; k < n; k++;) {\n"
+			"\t\t\t\tg++;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn g;\n"
+			"}\n"
+			"return run(160);\n"
+		},
+		{
+			"recursion", // 递归调用
+			"int fib(int n) {\n"
+			"\tif (n < 2) {\n"
+			"\t\treturn n;\n"
+			"\t}\n"
+			"\treturn fib(n - 1) + fib(n - 2);\n"
+			"}\n"
+			"return fib(27);\n"
+		}
+	};
+}
+
+int main(int argc, char** argv) {
+	int rounds = argc > 1 ? stoi(argv[1]) : 5;
+	
+	for (const Program& program : makePrograms()) {
+		Lexer lexer(program.source);
+		vector<Token> tokens = lexer.getAllToken();
+		ASTContext context;
+		AST ast(tokens, context);
+		vector<IRInstr> IR = getIRFromAST(ast.buildAST());
+		VM vm(IR);
+		
+		uint64_t executed = 0;
+		int result = vm.run(executed); // 计数运行一次得到指令条数，计时运行不计数
+		double best = 1e100;
+		
+		for (int round = 0; round < rounds; round++) {
+			auto t0 = chrono::steady_clock::now();
+			int value = vm.run();
+			auto t1 = chrono::steady_clock::now();
+			best = min(best, chrono::duration<double>(t1 - t0).count());
+			
+			if (value != result) {
+				printf("%s: result mismatch (%d vs %d)\n", program.name, value, result);
+				return 1;
+			}
+		}
+		
+		printf("%-16s result %-10d %8.1f M instrs  %8.2f ms  %7.1f M instrs/s\n", program.name, result,
+		       executed / 1e6, best * 1e3, executed / best / 1e6);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,175 @@
+// x86-64后端运行时间：以for循环为主的程序编译为汇编，用系统的cc汇编链接后运行，与虚拟机对比
+// 编译：g++ -std=c++2a -O2 benchmark/x86_bench.cpp -o x86_bench
+// 运行：./x86_bench [重复次数]（需要Linux x86-64和cc）
+#include<bits/stdc++.h>
+#include"../include/Lexer.h"
+#include"../include/AST/AST.h"
+#include"../include/IR/IR.h"
+#include"../include/VM/VM.h"
+#include"../include/CodeGen/X86Backend.h"
+using namespace std;
+
+struct Program {
+	const char* name;
+	string source;
+};
+
+vector<Program> makePrograms() {
+	return {
+		{
+			"nested loops",
+			"int count(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tfor (int j = 0; j < n; j++;) {\n"
+			"\t\t\tif (i * j / 7 > j || i == j) {\n"
+			"\t\t\t\tc++;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c;\n"
+			"}\n"
+			"return count(2000);\n"
+		},
+		{
+			"calls in loop",
+			"int sq(int x) {\n"
+			"\treturn x * x;\n"
+			"}\n"
+			"int sum(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tint t = sq(i) - i;\n"
+			"\t\tif (t > 100 && t / 3 != 5) {\n"
+			"\t\t\tc++;\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c;\n"
+			"}\n"
+			"return sum(3000000);\n"
+		},
+		{
+			"global counter",
+			"int g;\n"
+			"int run(int n) {\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tfor (int j = 0; j < n; j++;) {\n"
+			"\t\t\tfor (int k = 0; k < n; k++;) {\n"
+			"\t\t\t\tg++;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn g;\n"
+			"}\n"
+			"return run(160);\n"
+		},
+		{
+			"recursion",
+			"int fib(int n) {\n"
+			"\tif (n < 2) {\n"
+			"\t\treturn n;\n"
+			"\t}\n"
+			"\treturn fib(n - 1) + fib(n - 2);\n"
+			"}\n"
+			"return fib(27);\n"
+		},
+		{
+			// INT_MIN / -1回绕为INT_MIN（与VM一致），不能让idiv触发SIGFPE
+			"division by -1",
+			"int m(int a, int b) {\n"
+			"\treturn a / b;\n"
+			"}\n"
+			"int run(int n) {\n"
+			"\tint c = 0;\n"
+			"\tfor (int i = 0; i < n; i++;) {\n"
+			"\t\tif (m(2147483648 + i, 0 - 1) < 0) {\n"
+			"\t\t\tc++;\n"
+			"\t\t}\n"
+			"\t\tif (m(i, 0 - 1) < 0) {\n"
+			"\t\t\tc++;\n"
+			"\t\t}\n"
+			"\t}\n"
+			"\treturn c + m(2147483648, 0 - 1);\n"
+			"}\n"
+			"return run(3000000);\n"
+		}
+	};
+}
+
+// C驱动：重复调用myg_top，输出第一次的结果（全局变量只在进程启动时为0）和最短耗时（纳秒）
+const char* DRIVER =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <time.h>\n"
+    "int myg_top(void);\n"
+    "int main(int argc, char** argv) {\n"
+    "\tint rounds = argc > 1 ? atoi(argv[1]) : 5, result = 0;\n"
+    "\tdouble best = 1e300;\n"
+    "\tfor (int r = 0; r < rounds; r++) {\n"
+    "\t\tstruct timespec t0, t1;\n"
+    "\t\tclock_gettime(CLOCK_MONOTONIC, &t0);\n"
+    "\t\tint value = myg_top();\n"
+    "\t\tclock_gettime(CLOCK_MONOTONIC, &t1);\n"
+    "\t\tdouble ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);\n"
+    "\t\tif (r == 0) result = value;\n"
+    "\t\tif (ns < best) best = ns;\n"
+    "\t}\n"
+    "\tprintf(\"%d %.0f\\n\", result, best);\n"
+    "\treturn 0;\n"
+    "}\n";
+
+int main(int argc, char** argv) {
+	int rounds = argc > 1 ? stoi(argv[1]) : 5;
+	string dir = "/tmp/myg_x86_bench";
+	system(("mkdir -p " + dir).c_str());
+	ofstream(dir + "/driver.c") << DRIVER;
+	
+	for (const Program& program : makePrograms()) {
+		Lexer lexer(program.source);
+		vector<Token> tokens = lexer.getAllToken();
+		ASTContext context;
+		AST ast(tokens, context);
+		vector<IRInstr> IR = getIRFromAST(ast.buildAST());
+		
+		VM vm(IR);
+		int vmResult = vm.run();
+		double vmBest = 1e100;
+		
+		for (int round = 0; round < rounds; round++) {
+			auto t0 = chrono::steady_clock::now();
+			vm.run();
+			auto t1 = chrono::steady_clock::now();
+			vmBest = min(vmBest, chrono::duration<double, milli>(t1 - t0).count());
+		}
+		
+		X86Backend backend(IR, false);
+		ofstream(dir + "/program.s") << backend.generate();
+		string build = "cc -O2 -o " + dir + "/program " + dir + "/driver.c " + dir + "/program.s";
+		
+		if (system(build.c_str()) != 0) {
+			printf("%s: assembling/linking failed\n", program.name);
+			return 1;
+		}
+		
+		FILE* pipe = popen((dir + "/program " + to_string(rounds)).c_str(), "r");
+		int nativeResult = 0;
+		double nativeNs = 0;
+		
+		if (!pipe || fscanf(pipe, "%d %lf", &nativeResult, &nativeNs) != 2) {
+			printf("%s: running the native program failed\n", program.name);
+			return 1;
+		}
+		
+		pclose(pipe);
+		
+		if (nativeResult != vmResult) {
+			printf("%s: result mismatch (native %d, vm %d)\n", program.name, nativeResult, vmResult);
+			return 1;
+		}
+		
+		printf("%-16s result %-10d vm %8.2f ms   native %8.2f ms   speedup %5.1fx\n", program.name, vmResult,
+		       vmBest, nativeNs / 1e6, vmBest / (nativeNs / 1e6));
+	}
+	
+	return 0;
+}
@@ -1,212 +1,351 @@
+#ifndef AST_H
+#define AST_H
+
 #include "../Token.h"
 #include "./ASTnode.h"
+#include "./ASTContext.h"
+#include <functional>
 #include <vector>
+#include <span>
 #include <stdexcept>
 using namespace std;
 
 class AST {
 	private:
-		vector<Token> tokens;
+		span<const Token> tokens; // 只引用调用方的Token缓冲区，不做拷贝
 		size_t currentPos;
+		function<bool(vector<Token>&)> feed; // 流式输入：向缓冲区追加下一批Token，没有更多时返回false；为空表示tokens就是全部输入
+		vector<Token> window; // 流式输入时tokens指向这里
+		Token endToken; // 越界时返回的空Token
+		ASTContext& context; // 节点内存池，生命周期由调用方管理
+		vector<ASTBaseNode*> nodeScratch; // 收集子节点的临时栈，解析完一组后整体复制进context
+		vector<Expression*> exprScratch; // 同上，用于函数调用实参
+		vector<pair<Symbol, Symbol >> paramScratch; // 同上，用于函数形参
+		
+		// 表达式解析栈上的一项：尚未归约的二元运算符、逻辑非、左括号、函数调用或数组下标
+		struct OpFrame {
+			enum FrameKind : uint8_t { BINARY, NOT, PAREN, CALL, INDEX };
+			FrameKind kind;
+			int precedence;
+			Symbol op; // INDEX：数组名
+			FunctionCall* call; // CALL：正在收集实参的调用节点
+			size_t argStart; // CALL：第一个实参在操作数栈中的位置
+		};
+		
+		vector<OpFrame> opStack; // 运算符栈
+		vector<Expression*> operandStack; // 操作数栈
+		
+		// 按节点标签判断是否为表达式，代替dynamic_cast
+		static Expression* asExpression(ASTBaseNode* node) {
+			if (node && node->getNodeType() == ASTBaseNode::EXPRESSION)
+				return static_cast<Expression*>(node);
+				
+			return nullptr;
+		}
 		
-		// 辅助工具函数：检查当前Token是否匹配目标字符串
-		bool match(const string& target) {
+		// 把临时栈中从start开始的节点复制为context中的连续数组，并弹出
+		NodeList<ASTBaseNode*> takeNodes(size_t start) {
+			NodeList<ASTBaseNode*> list = context.makeList<ASTBaseNode*>(nodeScratch.begin() + start, nodeScratch.end());
+			nodeScratch.resize(start);
+			return list;
+		}
+		
+		// 辅助工具函数：检查当前Token是否匹配目标符号（整数比较）
+		bool match(Symbol target) {
 			if (isAtEnd())
 				return false;
 				
-			auto [type, content] = peek().getToken();
-			return content == target;
+			return peek().getSymbol() == target;
 		}
 		
-		// 辅助工具函数：消费当前Token并返回
-		Token consume() {
-			if (!isAtEnd())
-				currentPos++;
+		// 流式输入时tokens读完（或向后看的Token不在其中）后取下一批：未读的Token（至多几个）挪到开头，再追加新的一批
+		// 会使之前peek/consume返回的引用失效，所以解析函数中需要保留的Token都按值复制
+		bool refill() {
+			if (!feed)
+				return false;
+				
+			window.erase(window.begin(), window.begin() + min(currentPos, window.size()));
+			currentPos = 0;
+			bool more = feed(window);
+			
+			if (!more)
+				feed = nullptr;
 				
-			return tokens[currentPos - 1];
+			tokens = window;
+			return more;
+		}
+		
+		// 辅助工具函数：消费当前Token并返回其引用
+		const Token& consume() {
+			if (isAtEnd())
+				return endToken;
+				
+			return tokens[currentPos++];
 		}
 		
 		// 辅助工具函数：预览当前Token
-		Token peek() {
+		const Token& peek() {
+			if (isAtEnd())
+				return endToken;
+				
 			return tokens[currentPos];
 		}
 		
 		// 辅助工具函数：判断是否是否到达Token末尾
 		bool isAtEnd() {
-			return currentPos >= tokens.size();
+			return currentPos >= tokens.size() && !refill();
 		}
 		
 		// 辅助工具函数：期望特定Token，不匹配则抛出异常
-		Token expect(const string& target) {
+		const Token& expect(Symbol target) {
 			if (match(target))
 				return consume();
 				
-			auto [type, content] = peek().getToken();
-			throw runtime_error("Unexpected token: " + content + ", expected: " + target);
+			throw runtime_error("Unexpected token: " + string(peek().getContent()) + ", expected: " + string(symbolName(target)));
 		}
 		
 		// 在AST类中添加参数解析函数
-		vector<pair<string, string >> parseParameters() {
-			vector<pair<string, string >> params;
+		NodeList<pair<Symbol, Symbol >> parseParameters() {
+			vector<pair<Symbol, Symbol >>& params = paramScratch;
+			params.clear();
 			
 			// 解析第一个参数
-			if (peek().getToken().second == "int") {
-				string type = consume().getToken().second;
-				string name = consume().getToken().second;
+			if (peek().getSymbol() == SYM_INT) {
+				Symbol type = consume().getSymbol();
+				Symbol name = consume().getSymbol();
 				params.emplace_back(type, name);
 				
 				// 解析后续参数（逗号分隔）
-				while (match(",")) {
+				while (match(SYM_COMMA)) {
 					consume(); // 消耗逗号
 					
-					if (peek().getToken().second != "int") {
+					if (peek().getSymbol() != SYM_INT) {
 						throw runtime_error("Expected int type for parameter");
 					}
 					
-					type = consume().getToken().second;
-					name = consume().getToken().second;
+					type = consume().getSymbol();
+					name = consume().getSymbol();
 					params.emplace_back(type, name);
 				}
 			}
-			return params;
+			return context.makeList<pair<Symbol, Symbol >>(params.begin(), params.end());
 		}
 		
 		// 解析语句块（用{}包裹的语句集合）
 		ASTBaseNode* parseStatementBlock() {
-			StatementBlock* block = new StatementBlock();
-			expect("{"); // 消耗左花括号
+			StatementBlock* block = context.create<StatementBlock>();
+			expect(SYM_LBRACE); // 消耗左花括号
+			
+			size_t start = nodeScratch.size();
 			
 			// 解析块内所有语句直到右花括号
-			while (!match("}") && !isAtEnd()) {
+			while (!match(SYM_RBRACE) && !isAtEnd()) {
 				ASTBaseNode* stmt = parseStatement();
 				
 				if (stmt)
-					block->addChild(stmt);
+					nodeScratch.push_back(stmt);
 			}
 			
-			expect("}"); // 消耗右花括号
+			expect(SYM_RBRACE); // 消耗右花括号
+			block->setChildren(takeNodes(start));
 			return block;
 		}
 		
-		// 解析逻辑或（||），优先级最低
-		ASTBaseNode* parseLogicalOr() {
-			ASTBaseNode* node = parseLogicalAnd(); // 先解析逻辑与
-			
-			while (match("||")) {
-				string op = consume().getToken().second;
-				Expression* right = dynamic_cast<Expression*>(parseLogicalAnd());
-				node = new Expression(Expression::BINARY_OPERATOR, op,
-				                      dynamic_cast<Expression*>(node), right);
-			}
-			
-			return node;
-		}
-		
-		// 解析逻辑与（&&），优先级高于||，低于比较运算符
-		ASTBaseNode* parseLogicalAnd() {
-			ASTBaseNode* node = parseComparison(); // 改为先解析比较表达式
-			
-			while (match("&&")) {
-				string op = consume().getToken().second;
-				Expression* right = dynamic_cast<Expression*>(parseComparison()); // 右操作数也是比较表达式
-				node = new Expression(Expression::BINARY_OPERATOR, op,
-				                      dynamic_cast<Expression*>(node), right);
-			}
-			
-			return node;
-		}
-		
-		// 解析比较运算符（==, !=, >, <, >=, <=），优先级低于算术表达式，高于逻辑与
-		ASTBaseNode* parseComparison() {
-			ASTBaseNode* node = parseExpression(); // 先解析算术表达式（+ -）
-			
-			while (match("==") || match("!=") ||
-			       match(">") || match("<") ||
-			       match(">=") || match("<=")) {
-				string op = consume().getToken().second;
-				Expression* right = dynamic_cast<Expression*>(parseExpression()); // 右操作数也是算术表达式
-				node = new Expression(Expression::BINARY_OPERATOR, op,
-				                      dynamic_cast<Expression*>(node), right);
+		// 二元运算符优先级（数值越大结合越紧），0表示不是二元运算符
+		static int binaryPrecedence(Symbol op) {
+			switch (op) {
+				case SYM_OR:
+					return 1;
+					
+				case SYM_AND:
+					return 2;
+					
+				case SYM_EQ:
+				case SYM_NE:
+				case SYM_GT:
+				case SYM_LT:
+				case SYM_GE:
+				case SYM_LE:
+					return 3;
+					
+				case SYM_ADD:
+				case SYM_SUB:
+					return 4;
+					
+				case SYM_MUL:
+				case SYM_DIV:
+					return 5;
+					
+				default:
+					return 0;
 			}
-			
-			return node;
 		}
 		
-		// 解析表达式（处理 + - 运算，优先级较低）
-		ASTBaseNode* parseExpression() {
-			ASTBaseNode* node = parseTerm(); // 先解析高优先级的项
-			
-			// 循环处理连续的 + 或 -
-			while (match("+") || match("-")) {
-				string op = consume().getToken().second;
-				Expression* right = dynamic_cast<Expression*>(parseTerm());
-				node = new Expression(Expression::BINARY_OPERATOR, op,
-				                      dynamic_cast<Expression*>(node), right);
+		// 归约栈顶的一个二元运算符或逻辑非
+		void reduceTop() {
+			OpFrame frame = opStack.back();
+			opStack.pop_back();
+			Expression* right = operandStack.back();
+			operandStack.pop_back();
+			
+			if (frame.kind == OpFrame::NOT) {
+				operandStack.push_back(context.create<Expression>(Expression::BINARY_OPERATOR, SYM_NOT, nullptr, right));
+				return;
 			}
 			
-			return node;
+			Expression* left = operandStack.back();
+			operandStack.back() = context.create<Expression>(Expression::BINARY_OPERATOR, frame.op, left, right);
 		}
 		
-		// 解析项（处理 * / 运算，优先级中等）
-		ASTBaseNode* parseTerm() {
-			ASTBaseNode* node = parseFactor(); // 先解析因子
-			
-			// 循环处理连续的 * 或 /
-			while (match("*") || match("/")) {
-				string op = consume().getToken().second;
-				Expression* right = dynamic_cast<Expression*>(parseFactor());
-				node = new Expression(Expression::BINARY_OPERATOR, op,
-				                      dynamic_cast<Expression*>(node), right);
+		// 归约所有待处理的运算符，直到遇到括号/函数调用帧（或本次解析的栈底）
+		void reduceOperators(size_t opBase) {
+			while (opStack.size() > opBase &&
+			       (opStack.back().kind == OpFrame::BINARY || opStack.back().kind == OpFrame::NOT)) {
+				reduceTop();
 			}
-			
-			return node;
 		}
 		
-		// 解析因子（处理原子表达式：字面量、标识符、函数调用、括号表达式）
-		ASTBaseNode* parseFactor() {
-			Token token = peek();
-			auto [type, content] = token.getToken();
-			
-			// 处理单目逻辑非!，等级最高
-			if (content == "!") {
-				consume(); // 消耗!
-				Expression* operand = dynamic_cast<Expression*>(parseFactor()); // 解析操作数
-				return new Expression(Expression::BINARY_OPERATOR, "!", nullptr, operand);
-			}
-			
-			// 处理括号表达式
-			if (content == "(") {
-				consume(); // 消耗 '('
-				ASTBaseNode* expr = parseLogicalOr(); // 递归解析括号内的表达式（改为最后处理||）
-				expect(")"); // 消耗 ')'
-				return expr;
-			}
-			
-			// 处理字面量
-			if (type == Literals) {
-				consume();
-				return new Expression(Expression::LITERAL, content);
-			}
-			
-			// 处理标识符或函数调用
-			if (type == Identifiers) {
-				consume();
+		// 解析表达式：表驱动的优先级爬升，括号、!、函数调用和数组下标都放在显式栈上，不递归
+		// 优先级从低到高：|| < && < 比较运算符 < + - < * / < !
+		Expression* parseExpression() {
+			size_t opBase = opStack.size();
+			size_t operandBase = operandStack.size();
+			bool expectOperand = true; // 下一个Token应为操作数（否则应为运算符）
+			
+			while (true) {
+				Token token = peek();
+				Symbol symbol = token.getSymbol();
 				
-				if (match("(")) {
-					return parseFunctionCall(content); // 函数调用
+				if (expectOperand) {
+					// 处理单目逻辑非!，等级最高
+					if (symbol == SYM_NOT) {
+						consume();
+						opStack.push_back({OpFrame::NOT, 0, SYM_NOT, nullptr, 0});
+						continue;
+					}
+					
+					// 处理括号表达式
+					if (symbol == SYM_LPAREN) {
+						consume();
+						opStack.push_back({OpFrame::PAREN, 0, SYM_LPAREN, nullptr, 0});
+						continue;
+					}
+					
+					// 处理字面量
+					if (token.getType() == Literals && !isAtEnd()) {
+						consume();
+						operandStack.push_back(context.create<Expression>(Expression::LITERAL, symbol));
+						expectOperand = false;
+						continue;
+					}
+					
+					// 处理标识符、数组元素或函数调用
+					if (token.getType() == Identifiers) {
+						consume();
+						
+						if (match(SYM_LBRACKET)) { // 下标留在操作数栈上，遇到 ']' 时归约为数组元素
+							consume();
+							opStack.push_back({OpFrame::INDEX, 0, symbol, nullptr, 0});
+							continue;
+						}
+						
+						if (!match(SYM_LPAREN)) {
+							operandStack.push_back(context.create<Expression>(Expression::IDENTIFIER, symbol)); // 普通标识符
+							expectOperand = false;
+							continue;
+						}
+						
+						consume(); // 消耗 '('
+						FunctionCall* call = context.create<FunctionCall>(symbol);
+						
+						if (match(SYM_RPAREN)) { // 无参调用
+							consume();
+							operandStack.push_back(call);
+							expectOperand = false;
+						}
+						else { // 实参依次留在操作数栈上，遇到 ')' 时收集
+							opStack.push_back({OpFrame::CALL, 0, symbol, call, operandStack.size()});
+						}
+						
+						continue;
+					}
+					
+					throw runtime_error("Unexpected token in factor: " + string(token.getContent()));
+				}
+				
+				if (isAtEnd())
+					break;
+					
+				// 二元运算符：先归约栈上优先级不低于它的运算符（左结合）
+				if (int precedence = binaryPrecedence(symbol)) {
+					while (opStack.size() > opBase &&
+					       (opStack.back().kind == OpFrame::NOT ||
+					        (opStack.back().kind == OpFrame::BINARY && opStack.back().precedence >= precedence))) {
+						reduceTop();
+					}
+					
+					consume();
+					opStack.push_back({OpFrame::BINARY, precedence, symbol, nullptr, 0});
+					expectOperand = true;
+					continue;
+				}
+				
+				// ')'、',' 或 ']' 只有在本次解析内有未闭合的括号/调用/下标时才属于表达式，否则交给调用方
+				if (symbol != SYM_RPAREN && symbol != SYM_COMMA && symbol != SYM_RBRACKET)
+					break;
+					
+				reduceOperators(opBase);
+				
+				if (opStack.size() == opBase)
+					break;
+					
+				OpFrame& frame = opStack.back();
+				
+				if (symbol == SYM_COMMA) {
+					if (frame.kind != OpFrame::CALL)
+						break;
+						
+					consume(); // 下一个实参
+					expectOperand = true;
+					continue;
+				}
+				
+				if ((symbol == SYM_RBRACKET) != (frame.kind == OpFrame::INDEX)) // 括号不配对，留给下面报错
+					break;
+					
+				consume(); // 消耗 ')' 或 ']'
+				
+				if (frame.kind == OpFrame::INDEX) {
+					Expression* index = operandStack.back();
+					operandStack.back() = context.create<Expression>(Expression::ARRAY_ELEMENT, frame.op, index, nullptr);
+				}
+				else if (frame.kind == OpFrame::CALL) {
+					FunctionCall* call = frame.call;
+					call->setParameters(context.makeList<Expression*>(operandStack.begin() + frame.argStart, operandStack.end()));
+					operandStack.resize(frame.argStart);
+					operandStack.push_back(call);
 				}
 				
-				return new Expression(Expression::IDENTIFIER, content); // 普通标识符
+				opStack.pop_back();
+			}
+			
+			reduceOperators(opBase);
+			
+			if (opStack.size() > opBase) { // 还有未闭合的括号、函数调用或下标
+				throw runtime_error("Unexpected token: " + string(peek().getContent()) + ", expected: " +
+				                    (opStack.back().kind == OpFrame::INDEX ? "]" : ")"));
 			}
 			
-			throw runtime_error("Unexpected token in factor: " + content);
+			Expression* result = operandStack.back();
+			operandStack.resize(operandBase);
+			return result;
 		}
 		
 		ASTBaseNode* parseVariableDeclaration() {
-			Token typeToken = expect("int");
-			string varType = typeToken.getToken().second;
+			Symbol varType = expect(SYM_INT).getSymbol();
 			Token nameToken = peek();
-			auto [nameType, varName] = nameToken.getToken();
+			TokenType nameType = nameToken.getType();
+			Symbol varName = nameToken.getSymbol();
 			
 			if (nameType != Identifiers) {
 				throw runtime_error("Expected identifier for variable name");
@@ -214,12 +353,27 @@ class AST {
 			
 			consume(); // 消耗变量名
 			Expression* initExpr = nullptr; // 初始化表达式指针
+			Expression* arraySize = nullptr;
+			
+			// 数组声明：int a[N]; 长度必须是字面量，不能有初始化
+			if (match(SYM_LBRACKET)) {
+				consume(); // 消耗 '['
+				
+				if (peek().getType() != Literals) {
+					throw runtime_error("Expected literal array size");
+				}
+				
+				arraySize = context.create<Expression>(Expression::LITERAL, consume().getSymbol());
+				expect(SYM_RBRACKET);
+				expect(SYM_SEMICOLON);
+				return context.create<VariableDeclaration>(varType, varName, nullptr, arraySize);
+			}
 			
 			// 处理初始化（允许函数调用作为初始化表达式）
-			if (match("=")) {
+			if (match(SYM_ASSIGN)) {
 				consume(); // 消耗 '='
-				ASTBaseNode* exprNode = parseLogicalOr(); // 最后处理||
-				initExpr = dynamic_cast<Expression*>(exprNode);
+				ASTBaseNode* exprNode = parseExpression(); // 最后处理||
+				initExpr = asExpression(exprNode);
 				
 				// 放宽检查条件，允许任何Expression类型（包括函数调用）
 				if (!initExpr) {
@@ -227,24 +381,24 @@ class AST {
 				}
 			}
 			
-			expect(";"); // 消耗分号
+			expect(SYM_SEMICOLON); // 消耗分号
 			// 将 initExpr 传入构造函数
-			return new VariableDeclaration(varType, varName, initExpr);
+			return context.create<VariableDeclaration>(varType, varName, initExpr);
 		}
 		
 		// 解析if语句：if (condition) thenBlock [else elseBlock]
 		ASTBaseNode* parseIfStatement() {
 			consume(); // 消耗"if"关键词
-			expect("("); // 解析左括号
+			expect(SYM_LPAREN); // 解析左括号
 			// 解析条件表达式（支持逻辑运算）
-			ASTBaseNode* condNode = parseLogicalOr();
-			Expression* condition = dynamic_cast<Expression*>(condNode);
+			ASTBaseNode* condNode = parseExpression();
+			Expression* condition = asExpression(condNode);
 			
 			if (!condition) {
 				throw runtime_error("Invalid condition in if statement");
 			}
 			
-			expect(")"); // 解析右括号
+			expect(SYM_RPAREN); // 解析右括号
 			// 解析then分支（单语句或语句块）
 			ASTBaseNode* thenBlock = parseStatement();
 			
@@ -255,18 +409,18 @@ class AST {
 			// 解析可选的else分支
 			ASTBaseNode* elseBlock = nullptr;
 			
-			if (match("else")) {
+			if (match(SYM_ELSE)) {
 				consume(); // 消耗"else"关键词
 				elseBlock = parseStatement(); // else后的语句或语句块
 			}
 			
-			return new IfStatement(condition, thenBlock, elseBlock);
+			return context.create<IfStatement>(condition, thenBlock, elseBlock);
 		}
 		
 		// 在AST类中添加for循环解析函数
 		ASTBaseNode* parseForStatement() {
 			consume(); // 消耗"for"关键字
-			expect("("); // 解析左括号
+			expect(SYM_LPAREN); // 解析左括号
 			// 解析初始化语句
 			ASTBaseNode* initStmt = parseStatement();
 			
@@ -274,16 +428,16 @@ class AST {
 				throw runtime_error("Missing initialization statement in for loop");
 			}
 			
-			// expect(";"); // 消耗分号（这里不用断言，因为在parseStatement中已经断言）
+			// expect(SYM_SEMICOLON); // 消耗分号（这里不用断言，因为在parseStatement中已经断言）
 			// 解析条件表达式
-			ASTBaseNode* condNode = parseLogicalOr();
-			Expression* condition = dynamic_cast<Expression*>(condNode);
+			ASTBaseNode* condNode = parseExpression();
+			Expression* condition = asExpression(condNode);
 			
 			if (!condition) {
 				throw runtime_error("Invalid condition in for loop");
 			}
 			
-			expect(";"); // 消耗分号（这里需要断言，用于跳过分隔符）
+			expect(SYM_SEMICOLON); // 消耗分号（这里需要断言，用于跳过分隔符）
 			// 解析更新语句
 			ASTBaseNode* updateStmt = parseStatement();
 			
@@ -291,7 +445,7 @@ class AST {
 				throw runtime_error("Missing update statement in for loop");
 			}
 			
-			expect(")"); // 解析右括号
+			expect(SYM_RPAREN); // 解析右括号
 			// 解析循环体
 			ASTBaseNode* body = parseStatement();
 			
@@ -299,55 +453,59 @@ class AST {
 				throw runtime_error("Missing body in for loop");
 			}
 			
-			// expect(";"); // 消耗分号（这里不用断言，因为在parseStatement中已经断言）
-			return new ForStatement(initStmt, condition, updateStmt, body);
+			// expect(SYM_SEMICOLON); // 消耗分号（这里不用断言，因为在parseStatement中已经断言）
+			return context.create<ForStatement>(initStmt, condition, updateStmt, body);
 		}
 		
 		// 修改parseFunctionDeclaration函数(形如：func(int amint b))
 		ASTBaseNode* parseFunctionDeclaration() {
 			// 解析返回类型
-			Token returnTypeToken = expect("int");
-			string returnType = returnTypeToken.getToken().second;
+			Symbol returnType = expect(SYM_INT).getSymbol();
 			// 解析函数名
 			Token nameToken = peek();
-			auto [nameType, funcName] = nameToken.getToken();
+			TokenType nameType = nameToken.getType();
+			Symbol funcName = nameToken.getSymbol();
 			
 			if (nameType != Identifiers) {
 				throw runtime_error("Expected function name identifier");
 			}
 			
 			consume(); // 消耗函数名
-			expect("("); // 消耗左括号
-			vector<pair<string, string >> params = parseParameters(); // 解析参数列表
-			expect(")"); // 消耗右括号
+			expect(SYM_LPAREN); // 消耗左括号
+			NodeList<pair<Symbol, Symbol >> params = parseParameters(); // 解析参数列表
+			expect(SYM_RPAREN); // 消耗右括号
 			// 解析函数体
 			ASTBaseNode* body = parseStatementBlock();
-			FunctionDeclaration* func = new FunctionDeclaration(returnType, funcName, params);
-			func->addChild(body);
+			FunctionDeclaration* func = context.create<FunctionDeclaration>(returnType, funcName, params);
+			func->setChildren(context.makeList<ASTBaseNode*>({body}));
 			return func;
 		}
 		
 		// 解析函数调用
-		ASTBaseNode* parseFunctionCall(const string& funcName) {
-			FunctionCall* call = new FunctionCall(funcName);
-			expect("("); // 消耗左括号
+		ASTBaseNode* parseFunctionCall(Symbol funcName) {
+			FunctionCall* call = context.create<FunctionCall>(funcName);
+			expect(SYM_LPAREN); // 消耗左括号
+			
+			size_t start = exprScratch.size();
 			
 			// 解析参数列表
-			if (!match(")")) {
+			if (!match(SYM_RPAREN)) {
 				do {
-					ASTBaseNode* paramExpr = parseLogicalOr();//最后处理||
-					Expression* param = dynamic_cast<Expression*>(paramExpr);
+					ASTBaseNode* paramExpr = parseExpression();//最后处理||
+					Expression* param = asExpression(paramExpr);
 					
 					if (!param) {
 						throw runtime_error("Invalid parameter in function call");
 					}
 					
-					call->addParameter(param);
+					exprScratch.push_back(param);
 					
-				} while (match(",") && (consume(), true)); // 处理多个参数
+				} while (match(SYM_COMMA) && (consume(), true)); // 处理多个参数
 			}
 			
-			expect(")"); // 消耗右括号
+			expect(SYM_RPAREN); // 消耗右括号
+			call->setParameters(context.makeList<Expression*>(exprScratch.begin() + start, exprScratch.end()));
+			exprScratch.resize(start);
 			return call; // 现在返回的是Expression子类
 		}
 		
@@ -356,101 +514,126 @@ class AST {
 			if (isAtEnd())
 				return nullptr;
 				
-			auto [type, content] = peek().getToken();
+			Token token = peek();
+			TokenType type = token.getType();
+			Symbol symbol = token.getSymbol();
 			
 			// 处理return语句
-			if (content == "return") {
+			if (symbol == SYM_RETURN) {
 				consume(); // 消耗return关键字
-				Statement* returnStmt = new Statement(Statement::RETURN);
+				Statement* returnStmt = context.create<Statement>(Statement::RETURN);
 				
 				// 解析return后的表达式
-				if (!match(";")) {
-					ASTBaseNode* expr = parseLogicalOr();//最后处理||
-					returnStmt->addChild(expr);
+				if (!match(SYM_SEMICOLON)) {
+					ASTBaseNode* expr = parseExpression();//最后处理||
+					returnStmt->setChildren(context.makeList<ASTBaseNode*>({expr}));
 				}
 				
-				expect(";"); // 消耗分号
+				expect(SYM_SEMICOLON); // 消耗分号
 				return returnStmt;
 			}
 			
 			// 处理if语句（新增）
-			if (content == "if") {
+			if (symbol == SYM_IF) {
 				return parseIfStatement();
 			}
 			
 			// 处理变量声明（以int关键字开头）
-			if (content == "int" && peek(1).getToken().second != "(") {
+			if (symbol == SYM_INT && peek(1).getSymbol() != SYM_LPAREN) {
 				return parseVariableDeclaration();
 			}
 			
 			// 处理for语句
-			if (content == "for") {
+			if (symbol == SYM_FOR) {
 				return parseForStatement();
 			}
 			
 			// 处理语句块
-			if (content == "{") {
+			if (symbol == SYM_LBRACE) {
 				return parseStatementBlock();
 			}
 			
 			// 处理函数调用语句（以标识符开头，后跟()）
-			if (type == Identifiers && peek(1).getToken().second == "(") {
-				string funcName = content;
+			if (type == Identifiers && peek(1).getSymbol() == SYM_LPAREN) {
+				Symbol funcName = symbol;
 				consume(); // 消耗函数名
 				ASTBaseNode* call = parseFunctionCall(funcName);
-				expect(";"); // 函数调用后加分号
+				expect(SYM_SEMICOLON); // 函数调用后加分号
 				return call;
 			}
 			
+			// 处理数组元素赋值 a[i] = x;
+			if (type == Identifiers && peek(1).getSymbol() == SYM_LBRACKET) {
+				Symbol arrayName = symbol;
+				consume(); // 消耗数组名
+				consume(); // 消耗 '['
+				Expression* index = parseExpression();
+				expect(SYM_RBRACKET);
+				expect(SYM_ASSIGN);
+				Expression* value = parseExpression();
+				expect(SYM_SEMICOLON);
+				return context.create<Expression>(Expression::ARRAY_ASSIGN, arrayName, index, value);
+			}
+			
 			// 处理后置自增表达式 i++
-			if (type == Identifiers && peek(1).getToken().second == "++") {
-				string varName = content;
+			if (type == Identifiers && peek(1).getSymbol() == SYM_INC) {
+				Symbol varName = symbol;
 				consume(); // 消耗变量名
 				consume(); // 消耗++
-				expect(";"); // 自增语句以分号结束
+				expect(SYM_SEMICOLON); // 自增语句以分号结束
 				// 创建自增表达式节点
-				Expression* varExpr = new Expression(Expression::IDENTIFIER, varName);
-				return new Expression(Expression::UNARY_OPERATOR, "++", varExpr);
+				Expression* varExpr = context.create<Expression>(Expression::IDENTIFIER, varName);
+				return context.create<Expression>(Expression::UNARY_OPERATOR, SYM_INC, varExpr);
 			}
 			
-			throw runtime_error("Unexpected statement token: " + content);
+			throw runtime_error("Unexpected statement token: " + string(token.getContent()));
 		}
 		
 		// 辅助工具：预览下一个Token（用于判断函数调用）
-		Token peek(int offset) {
-			if (currentPos + offset >= tokens.size()) {
-				return Token("", -1); // 返回空Token表示越界
+		const Token& peek(int offset) {
+			while (currentPos + offset >= tokens.size()) {
+				if (!refill())
+					return endToken; // 返回空Token表示越界
 			}
 			
 			return tokens[currentPos + offset];
 		}
 		
 	public:
-		AST(const vector<Token>& tokenList) : tokens(tokenList), currentPos(0) {}
-		
+		AST(span<const Token> tokenList, ASTContext& context)
+			: tokens(tokenList), currentPos(0), endToken("", -1), context(context) {}
+			
+		// 流式输入：边解析边从feed取Token，每批追加到内部缓冲区末尾，整个Token序列不必同时存在
+		AST(function<bool(vector<Token>&)> feed, ASTContext& context)
+			: currentPos(0), feed(move(feed)), endToken("", -1), context(context) {}
+			
 		// 构建AST根节点
 		ASTBaseNode* buildAST() {
-			StatementBlock* root = new StatementBlock(); // 根节点为语句块
+			StatementBlock* root = context.create<StatementBlock>(); // 根节点为语句块
+			size_t start = nodeScratch.size();
 			
 			// 解析所有顶级语句（函数声明、全局变量等）
 			while (!isAtEnd()) {
-				auto [type, content] = peek().getToken();
+				Symbol symbol = peek().getSymbol();
 				
 				// 解析函数声明（int + 标识符 + (）
-				if (content == "int" && peek(1).getToken().second != ";" &&
-				peek(2).getToken().second == "(") {
+				if (symbol == SYM_INT && peek(1).getSymbol() != SYM_SEMICOLON &&
+				peek(2).getSymbol() == SYM_LPAREN) {
 					ASTBaseNode* func = parseFunctionDeclaration();
-					root->addChild(func);
+					nodeScratch.push_back(func);
 				}
 				else {
 					// 解析其他语句
 					ASTBaseNode* stmt = parseStatement();
 					
 					if (stmt)
-						root->addChild(stmt);
+						nodeScratch.push_back(stmt);
 				}
 			}
 			
+			root->setChildren(takeNodes(start));
 			return root;
 		}
 };
+
+#endif /*AST_H*/
@@ -0,0 +1,187 @@
+#ifndef AST_CONTEXT_H
+#define AST_CONTEXT_H
+
+#include<algorithm>
+#include<cstddef>
+#include<cstdint>
+#include<initializer_list>
+#include<new>
+#include<type_traits>
+#include<utility>
+#include<vector>
+using namespace std;
+
+// 池中的定长数组：数据连续存放在ASTContext里，节点只保存起始位置和长度
+// 平凡可析构，节点释放时无需任何清理
+template<typename T>
+struct NodeList {
+	T* data;
+	uint32_t count;
+	
+	NodeList() : data(nullptr), count(0) {}
+	
+	NodeList(T* data, uint32_t count) : data(data), count(count) {}
+	
+	size_t size() const {
+		return count;
+	}
+	
+	bool empty() const {
+		return count == 0;
+	}
+	
+	T& operator[](size_t i) const {
+		return data[i];
+	}
+	
+	T* begin() const {
+		return data;
+	}
+	
+	T* end() const {
+		return data + count;
+	}
+};
+
+// 一次编译的AST内存池：所有节点从大块内存中顺序分配，编译结束时整体释放
+// 节点之间不再互相delete；节点均为平凡可析构，释放只需归还内存块
+// 若有带非平凡析构成员的对象，则登记到cleanups，释放时顺序析构（无递归）
+class ASTContext {
+		struct Cleanup {
+			void* object;
+			void (*destroy)(void*);
+		};
+		
+		vector<char*> chunks; // 已申请的内存块
+		char* current; // 当前块中下一个可用位置
+		char* limit; // 当前块末尾
+		size_t nextChunkSize;
+		size_t totalBytes; // 已分配给节点的字节数
+		size_t reservedBytes; // 向系统申请的字节数
+		size_t objectCount;
+		vector<Cleanup> cleanups;
+		
+		static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+		static const size_t MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+		static const size_t MAX_NODE_TYPES = 16;
+		
+		size_t nodeTypeCounts[MAX_NODE_TYPES]; // 有getNodeType()的对象按其返回值分类计数
+		
+		void newChunk(size_t minSize) {
+			size_t size = nextChunkSize > minSize ? nextChunkSize : minSize;
+			char* chunk = (char*)::operator new(size); // 经过operator new，计入编译计量的内存统计
+			chunks.push_back(chunk);
+			current = chunk;
+			limit = chunk + size;
+			reservedBytes += size;
+			
+			if (nextChunkSize < MAX_CHUNK_SIZE) {
+				nextChunkSize *= 2;
+			}
+		}
+		
+	public:
+		ASTContext() : current(nullptr), limit(nullptr), nextChunkSize(MIN_CHUNK_SIZE),
+			totalBytes(0), reservedBytes(0), objectCount(0), nodeTypeCounts() {}
+			
+		ASTContext(const ASTContext&) = delete;
+		ASTContext& operator=(const ASTContext&) = delete;
+		
+		// 按对齐要求分配一段原始内存
+		void* allocate(size_t size, size_t align) {
+			uintptr_t p = ((uintptr_t)current + align - 1) & ~(uintptr_t)(align - 1);
+			
+			if (!current || p + size > (uintptr_t)limit) {
+				newChunk(size + align);
+				p = ((uintptr_t)current + align - 1) & ~(uintptr_t)(align - 1);
+			}
+			
+			current = (char*)(p + size);
+			totalBytes += size;
+			return (void*)p;
+		}
+		
+		// 在池中构造一个节点
+		template<typename T, typename... Args>
+		T* create(Args&&... args) {
+			T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			objectCount++;
+			
+			if constexpr (requires { object->getNodeType(); }) {
+				nodeTypeCounts[object->getNodeType()]++;
+			}
+			
+			if constexpr (!is_trivially_destructible_v<T>) {
+				cleanups.push_back({object, [](void* p) {
+					static_cast<T*>(p)->~T();
+				}});
+			}
+			
+			return object;
+		}
+		
+		// 把[first, last)复制成池中的连续数组
+		template<typename T, typename It>
+		NodeList<T> makeList(It first, It last) {
+			static_assert(is_trivially_destructible_v<T>, "NodeList elements are never destroyed");
+			uint32_t count = (uint32_t)(last - first);
+			
+			if (count == 0) {
+				return NodeList<T>();
+			}
+			
+			T* data = (T*)allocate(sizeof(T) * count, alignof(T));
+			
+			for (uint32_t i = 0; i < count; i++, ++first) {
+				new (data + i) T(*first);
+			}
+			
+			return NodeList<T>(data, count);
+		}
+		
+		template<typename T>
+		NodeList<T> makeList(initializer_list<T> items) {
+			return makeList<T>(items.begin(), items.end());
+		}
+		
+		// 析构所有节点并归还内存，之后可继续复用
+		void reset() {
+			for (size_t i = cleanups.size(); i > 0; i--) {
+				cleanups[i - 1].destroy(cleanups[i - 1].object);
+			}
+			
+			for (char* chunk : chunks) {
+				::operator delete(chunk);
+			}
+			
+			cleanups.clear();
+			chunks.clear();
+			current = limit = nullptr;
+			nextChunkSize = MIN_CHUNK_SIZE;
+			totalBytes = reservedBytes = objectCount = 0;
+			fill(begin(nodeTypeCounts), end(nodeTypeCounts), 0);
+		}
+		
+		size_t getTotalBytes() const {
+			return totalBytes;
+		}
+		
+		size_t getReservedBytes() const {
+			return reservedBytes;
+		}
+		
+		size_t getObjectCount() const {
+			return objectCount;
+		}
+		
+		// 创建过的、getNodeType()为type的节点数（包括之后被折叠掉、不再挂在树上的）
+		size_t getNodeCount(size_t type) const {
+			return type < MAX_NODE_TYPES ? nodeTypeCounts[type] : 0;
+		}
+		
+		~ASTContext() {
+			reset();
+		}
+};
+
+#endif /*AST_CONTEXT_H*/
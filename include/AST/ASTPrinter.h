@@ -21,12 +21,12 @@ class ASTPrinter {
 			switch (node->getNodeType()) {
 				// 在FunctionDeclaration的打印分支中添加
 				case ASTBaseNode::FUNC_DECL: {
-						auto* func = dynamic_cast<FunctionDeclaration*>(node);
-						std::cout << "FunctionDeclaration: " << func->returnType << " " << func->funcName << "(";
+						auto* func = static_cast<FunctionDeclaration*>(node);
+						std::cout << "FunctionDeclaration: " << symbolName(func->returnType) << " " << symbolName(func->funcName) << "(";
 						
 						// 打印参数列表
 						for (size_t i = 0; i < func->parameters.size(); ++i) {
-							std::cout << func->parameters[i].first << " " << func->parameters[i].second;
+							std::cout << symbolName(func->parameters[i].first) << " " << symbolName(func->parameters[i].second);
 							
 							if (i != func->parameters.size() - 1) {
 								std::cout << ", ";
@@ -43,7 +43,7 @@ class ASTPrinter {
 					}
 					
 				case ASTBaseNode::STATEMENT: {
-						auto* stmt = dynamic_cast<Statement*>(node);
+						auto* stmt = static_cast<Statement*>(node);
 						
 						if (stmt->getStmtType() == Statement::RETURN) {
 							std::cout << "ReturnStatement" << std::endl;
@@ -56,22 +56,22 @@ class ASTPrinter {
 					}
 					
 				case ASTBaseNode::EXPRESSION: {
-						auto* expr = dynamic_cast<Expression*>(node);
+						auto* expr = static_cast<Expression*>(node);
 						
 						if (expr->exprType == Expression::LITERAL) {
-							std::cout << "LiteralExpression: " << expr->value << std::endl;
+							std::cout << "LiteralExpression: " << symbolName(expr->value) << std::endl;
 						}
 						else if (expr->exprType == Expression::IDENTIFIER) {
-							std::cout << "IdentifierExpression: " << expr->value << std::endl;
+							std::cout << "IdentifierExpression: " << symbolName(expr->value) << std::endl;
 						}
 						else if (expr->exprType == Expression::BINARY_OPERATOR) {
-							std::cout << "BinaryOperator: " << expr->value << std::endl;
+							std::cout << "BinaryOperator: " << symbolName(expr->value) << std::endl;
 							printNode(expr->left, depth + 1);
 							printNode(expr->right, depth + 1);
 						}
 						else if (expr->exprType == Expression::FUNC_CALL) { // 新增函数调用打印
-							auto* call = dynamic_cast<FunctionCall*>(expr);
-							std::cout << "FunctionCall: " << call->funcName << "(";
+							auto* call = static_cast<FunctionCall*>(expr);
+							std::cout << "FunctionCall: " << symbolName(call->funcName) << "(";
 							
 							for (size_t i = 0; i < call->parameters.size(); ++i) {
 								printNode(call->parameters[i], depth + 1);
@@ -84,18 +84,31 @@ class ASTPrinter {
 							std::cout << ")" << std::endl;
 						}
 						else if (expr->exprType == Expression::UNARY_OPERATOR) {
-							std::cout << "UnaryOperator: " << expr->value << std::endl;
+							std::cout << "UnaryOperator: " << symbolName(expr->value) << std::endl;
 							printIndent(depth + 1);
 							std::cout << "Operand:" << std::endl;
 							printNode(expr->operand, depth + 2);
 						}
+						else if (expr->exprType == Expression::ARRAY_ELEMENT) {
+							std::cout << "ArrayElement: " << symbolName(expr->value) << std::endl;
+							printNode(expr->left, depth + 1);
+						}
+						else if (expr->exprType == Expression::ARRAY_ASSIGN) {
+							std::cout << "ArrayAssign: " << symbolName(expr->value) << std::endl;
+							printNode(expr->left, depth + 1);
+							printNode(expr->right, depth + 1);
+						}
 						
 						break;
 					}
 					
 				case ASTBaseNode::VAR_DECL: {
-						auto* var = dynamic_cast<VariableDeclaration*>(node);
-						std::cout << "VariableDeclaration: " << var->varType << " " << var->varName;
+						auto* var = static_cast<VariableDeclaration*>(node);
+						std::cout << "VariableDeclaration: " << symbolName(var->varType) << " " << symbolName(var->varName);
+						
+						if (var->arraySize) {
+							std::cout << "[" << symbolName(var->arraySize->value) << "]";
+						}
 						
 						// 打印初始化表达式（如果存在）
 						if (var->initExpr) {
@@ -111,8 +124,8 @@ class ASTPrinter {
 					}
 					
 				case ASTBaseNode::FUNC_CALL: {
-						auto* call = dynamic_cast<FunctionCall*>(node);
-						std::cout << "FunctionCall: " << call->funcName << "(";
+						auto* call = static_cast<FunctionCall*>(node);
+						std::cout << "FunctionCall: " << symbolName(call->funcName) << "(";
 						
 						// 打印参数列表
 						for (size_t i = 0; i < call->parameters.size(); ++i) {
@@ -128,7 +141,7 @@ class ASTPrinter {
 					}
 					
 				case ASTBaseNode::IF_STATEMENT: {
-						auto* ifStmt = dynamic_cast<IfStatement*>(node);
+						auto* ifStmt = static_cast<IfStatement*>(node);
 						std::cout << "IfStatement" << std::endl;
 						// 打印条件表达式
 						printIndent(depth + 1);
@@ -151,7 +164,7 @@ class ASTPrinter {
 					
 				// 在printNode()函数中添加for循环处理
 				case ASTBaseNode::FOR_STATEMENT: {
-						auto* forStmt = dynamic_cast<ForStatement*>(node);
+						auto* forStmt = static_cast<ForStatement*>(node);
 						std::cout << "ForStatement" << std::endl;
 						// 打印初始化语句
 						printIndent(depth + 1);
@@ -177,7 +190,7 @@ class ASTPrinter {
 			}
 			
 			// 递归打印子节点
-			auto children = node->getAllChildren();
+			NodeList<ASTBaseNode*> children = node->getAllChildren();
 			
 			for (auto child : children) {
 				printNode(child, depth + 1);
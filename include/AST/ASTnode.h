@@ -1,19 +1,17 @@
 #ifndef ASTnode_H
 #define ASTnode_H
 
-#include<vector>
-#include<string>
-#include<unordered_map>
+#include<cstdint>
+#include<utility>
 #include"../Token.h"
+#include"./ASTContext.h"
 using namespace std;
 
-#ifndef NULL_ATTRIBUTE_VALUE
-	#define NULL_ATTRIBUTE_VALUE "NULLATTRIBUTEVALUE"
-#endif
-
+// 节点布局：类型标签 + 定长的类型化字段，没有虚函数和哈希表，全部平凡可析构
+// 子节点以NodeList（池中连续数组的区间）保存；按标签switch后用static_cast取得具体类型
 class ASTBaseNode {
 	public:
-		enum NodeType {
+		enum NodeType : uint8_t {
 			BASE,
 			STATEMENT,
 			STMT_BLOCK,
@@ -25,36 +23,17 @@ class ASTBaseNode {
 			FOR_STATEMENT
 		};
 	protected:
-		vector<ASTBaseNode*> children;
-		unordered_map<string, string> attribute;
+		NodeList<ASTBaseNode*> children;
 		NodeType nodeType;
 	public:
 	
 		ASTBaseNode(): nodeType(BASE) {}
 		
-		virtual ~ASTBaseNode() {
-			for (auto child : children) {
-				delete child;
-			}
-		}
-		
-		void addChild(ASTBaseNode* child) {
-			children.push_back(child);
-		}
-		
-		void addAttribute(string& attributeName, string& attributeNum) {
-			attribute[attributeName] = attributeNum;
-		}
-		
-		string getAttribute(string& attributeName) {
-			if (attribute.find(attributeName) != attribute.end()) {
-				return attribute[attributeName];
-			}
-			
-			return NULL_ATTRIBUTE_VALUE;
+		void setChildren(NodeList<ASTBaseNode*> list) {
+			children = list;
 		}
 		
-		vector<ASTBaseNode*> getAllChildren() {
+		NodeList<ASTBaseNode*> getAllChildren() {
 			return children;
 		}
 		
@@ -63,9 +42,18 @@ class ASTBaseNode {
 		}
 };
 
+// 节点类型的名字，用于编译计量的报告
+const char* nodeTypeName(ASTBaseNode::NodeType type) {
+	static const char* const names[] = {
+		"BASE", "STATEMENT", "STMT_BLOCK", "EXPRESSION", "VAR_DECL", "FUNC_DECL", "FUNC_CALL", "IF_STATEMENT", "FOR_STATEMENT"
+	};
+	
+	return type < sizeof(names) / sizeof(names[0]) ? names[type] : "UNKNOWN";
+}
+
 class Statement: public ASTBaseNode {
 	public:
-		enum StmtType { RETURN, EMPTY };
+		enum StmtType : uint8_t { RETURN, EMPTY };
 		StmtType stmtType;
 		
 		Statement(StmtType type) : stmtType(type) {
@@ -75,8 +63,6 @@ class Statement: public ASTBaseNode {
 		StmtType getStmtType() {
 			return stmtType;
 		}
-		
-		~Statement() {}
 };
 
 class StatementBlock: public ASTBaseNode {
@@ -84,101 +70,84 @@ class StatementBlock: public ASTBaseNode {
 		StatementBlock() {
 			nodeType = STMT_BLOCK;
 		}
-		
-		~StatementBlock() {}
 };
 
 // 在ASTnode.h的Expression类中添加
 class Expression: public ASTBaseNode {
 	public:
-		enum ExprType { LITERAL,
+		enum ExprType : uint8_t { LITERAL,
 		                IDENTIFIER,
 		                BINARY_OPERATOR,// 支持算术运算符、逻辑运算符（+、-、*、/、&&、||等）
 		                FUNC_CALL,
-		                UNARY_OPERATOR
+		                UNARY_OPERATOR,
+		                ARRAY_ELEMENT, // a[i]：value为数组名，left为下标
+		                ARRAY_ASSIGN // a[i] = x;（语句）：value为数组名，left为下标，right为新值
 		              };
 		ExprType exprType;
-		string value; // 用于字面量、标识符或运算符
-		Expression* operand; // 新增：单目运算符的操作数（如自增的变量）
-		Expression* left; // 左操作数（二元运算时）
+		Symbol value; // 用于字面量、标识符或运算符（驻留编号）
+		union {
+			Expression* operand; // 新增：单目运算符的操作数（如自增的变量）
+			Expression* left; // 左操作数（二元运算时）
+		};
 		Expression* right; // 右操作数（二元运算时）
 		
 		// 构造函数：字面量/标识符
-		Expression(ExprType type, const string& val)
+		Expression(ExprType type, Symbol val)
 			: exprType(type), value(val), left(nullptr), right(nullptr) {
 			nodeType = EXPRESSION;
 		}
 		
 		// 构造函数：二元运算符
-		Expression(ExprType type, const string& op, Expression* l, Expression* r)
+		Expression(ExprType type, Symbol op, Expression* l, Expression* r)
 			: exprType(type), value(op), left(l), right(r) {
 			nodeType = EXPRESSION;
 		}
 		
 		// 新增：单目运算符构造函数（自增等）
-		Expression(ExprType type, const string& op, Expression* opnd)
-			: exprType(type), value(op), operand(opnd), left(nullptr), right(nullptr) {
+		Expression(ExprType type, Symbol op, Expression* opnd)
+			: exprType(type), value(op), operand(opnd), right(nullptr) {
 			nodeType = EXPRESSION;
 		}
-		
-		~Expression() {
-			delete left;
-			delete right;
-			delete operand; // 释放单目操作数
-		}
 };
 
 class VariableDeclaration: public ASTBaseNode {
 	public:
-		string varType;
-		string varName;
+		Symbol varType;
+		Symbol varName;
 		Expression* initExpr; // 新增：存储初始化表达式
+		Expression* arraySize; // 数组的长度（字面量），普通变量为nullptr
 		
-		VariableDeclaration(const string& type, const string& name, Expression* init = nullptr)
-			: varType(type), varName(name), initExpr(init) {
+		VariableDeclaration(Symbol type, Symbol name, Expression* init = nullptr, Expression* size = nullptr)
+			: varType(type), varName(name), initExpr(init), arraySize(size) {
 			nodeType = VAR_DECL;
 		}
-		
-		~VariableDeclaration() {
-			delete initExpr; // 释放初始化表达式
-		}
 };
 
 // 在FunctionDeclaration类中添加参数存储
 class FunctionDeclaration: public ASTBaseNode {
 	public:
-		string returnType;
-		string funcName;
-		vector<pair<string, string >> parameters; // 新增：存储参数类型和名称
+		Symbol returnType;
+		Symbol funcName;
+		NodeList<pair<Symbol, Symbol >> parameters; // 新增：存储参数类型和名称
 		
-		FunctionDeclaration(const string& retType, const string& name,
-		                    const vector<pair<string, string >>& params)
+		FunctionDeclaration(Symbol retType, Symbol name,
+		                    NodeList<pair<Symbol, Symbol >> params)
 			: returnType(retType), funcName(name), parameters(params) {
 			nodeType = FUNC_DECL;
 		}
-		
-		~FunctionDeclaration() {}
 };
 
 class FunctionCall: public Expression {
 	public:
-		string funcName;
-		vector<Expression*> parameters; // 新增：存储函数调用参数
+		Symbol funcName;
+		NodeList<Expression*> parameters; // 新增：存储函数调用参数
 		
-		FunctionCall(const string& name)
+		FunctionCall(Symbol name)
 			: Expression(Expression::FUNC_CALL, name), funcName(name) { // 使用新的表达式类型
 		}
 		
-		// 新增：添加参数方法
-		void addParameter(Expression* param) {
-			parameters.push_back(param);
-		}
-		
-		~FunctionCall() {
-			// 释放参数表达式
-			for (auto param : parameters) {
-				delete param;
-			}
+		void setParameters(NodeList<Expression*> params) {
+			parameters = params;
 		}
 };
 
@@ -192,12 +161,6 @@ class IfStatement : public ASTBaseNode {
 			: condition(cond), thenBlock(thenStmt), elseBlock(elseStmt) {
 			nodeType = IF_STATEMENT; // 需要在NodeType中添加枚举值
 		}
-		
-		~IfStatement() {
-			delete condition;
-			delete thenBlock;
-			delete elseBlock;
-		}
 };
 
 // 添加ForStatement类
@@ -212,13 +175,11 @@ class ForStatement : public ASTBaseNode {
 			: initStmt(init), condition(cond), updateStmt(update), body(b) {
 			nodeType = FOR_STATEMENT;
 		}
-		
-		~ForStatement() {
-			delete initStmt;
-			delete condition;
-			delete updateStmt;
-			delete body;
-		}
 };
 
+static_assert(is_trivially_destructible_v<Statement> && is_trivially_destructible_v<StatementBlock> &&
+              is_trivially_destructible_v<FunctionCall> && is_trivially_destructible_v<VariableDeclaration> &&
+              is_trivially_destructible_v<FunctionDeclaration> && is_trivially_destructible_v<IfStatement> &&
+              is_trivially_destructible_v<ForStatement>, "AST nodes are released by ASTContext without destructors");
+
 #endif /*ASTnode_H*/
@@ -0,0 +1,710 @@
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<fstream>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<vector>
+#include"./Token.h"
+#include"./SourceBuffer.h"
+#include"./AST/ASTContext.h"
+#include"./AST/ASTnode.h"
+#include"./IR/IRbase.h"
+using namespace std;
+
+// AST和IR的二进制格式：文件头 + 若干段，段内只用下标和偏移、不含指针，可以直接mmap后使用
+// 名字（标识符、字面量、运算符）都放在去重的字符串表中，按下标引用；Symbol只在产生它的线程中有意义，不写入文件
+// 格式变化时递增BINARY_FORMAT_VERSION，旧版本的文件拒绝加载
+constexpr uint32_t BINARY_FORMAT_VERSION = 1;
+constexpr uint32_t BINARY_BYTE_ORDER = 0x01020304; // 写入时的字节序，读出的值不同说明是另一种字节序的机器写的
+constexpr uint32_t NO_NODE = 0xffffffff; // 没有子节点/没有AST
+constexpr int BINARY_COUNT_LIMIT = 1 << 26; // 加载时寄存器数、标签和全局编号、数组长度的上限：VM和后端按编号分配表、用int算字节偏移
+
+enum BinarySectionKind {
+	SECTION_STRING_OFFSETS, // uint32_t[字符串个数 + 1]，第i个字符串为字符串数据的[offsets[i], offsets[i + 1])
+	SECTION_STRING_DATA, // 所有字符串首尾相接
+	SECTION_NODES, // BinaryNode[]，按先序编号，父节点的编号小于子节点
+	SECTION_LISTS, // uint32_t[]，各节点的子节点列表和形参列表
+	SECTION_IR, // IRInstr[]，FUNC、CALL、GLOBAL、ARRAY的a是字符串下标
+	SECTION_COUNT
+};
+
+struct BinarySection {
+	uint64_t offset; // 相对文件开头的字节偏移，4字节对齐
+	uint64_t size; // 字节数
+};
+
+struct BinaryHeader {
+	char magic[4]; // "MYGB"
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t root; // AST根节点的编号，NO_NODE表示没有AST
+	BinarySection sections[SECTION_COUNT];
+};
+
+// 一个AST节点，各字段按nodeType解释：
+//   STATEMENT   kind=stmtType，children（RETURN的返回值）
+//   STMT_BLOCK  children
+//   EXPRESSION  kind=exprType，name=value，link[0]=left/operand，link[1]=right；FUNC_CALL的实参在params中
+//   VAR_DECL    type=varType，name=varName，link[0]=initExpr，link[1]=arraySize
+//   FUNC_DECL   type=returnType，name=funcName，children（函数体），params中每个形参依次为类型、名字的字符串下标
+//   IF_STATEMENT  link[0..2]=condition、thenBlock、elseBlock
+//   FOR_STATEMENT link[0..3]=initStmt、condition、updateStmt、body
+struct BinaryNode {
+	uint8_t nodeType;
+	uint8_t kind;
+	uint16_t reserved;
+	uint32_t name; // 字符串下标
+	uint32_t type; // 字符串下标
+	uint32_t link[4]; // 子节点编号，NO_NODE表示没有
+	uint32_t children; // 子节点列表在SECTION_LISTS中的起点
+	uint32_t childCount;
+	uint32_t params; // 实参/形参列表在SECTION_LISTS中的起点
+	uint32_t paramCount; // 列表中的元素个数（形参为两倍的形参个数）
+};
+
+static_assert(sizeof(BinaryNode) == 44 && sizeof(BinaryHeader) == 16 + 16 * SECTION_COUNT, "binary records must have a fixed layout");
+
+// IR中保存Symbol的字段（写入文件时换成字符串下标）
+bool irHasSymbol(const IRInstr& instr) {
+	return instr.op == FUNC || instr.op == CALL || instr.op == GLOBAL || instr.op == ARRAY;
+}
+
+// 把AST（可以为nullptr）和IR序列化为一个二进制模块
+class BinaryWriter {
+		vector<uint32_t> stringIndex; // Symbol -> 字符串下标
+		vector<uint32_t> stringOffsets;
+		string stringData;
+		vector<BinaryNode> nodes;
+		vector<uint32_t> lists;
+		
+		// 子节点编号要写到的位置：target >= 0为lists[target]，否则为nodes[parent].link[slot]，编码为-(parent * 4 + slot) - 1
+		struct Pending {
+			ASTBaseNode* node;
+			int64_t target;
+		};
+		
+		vector<Pending> work;
+		
+		uint32_t intern(Symbol symbol) {
+			if (symbol >= stringIndex.size())
+				stringIndex.resize(SymbolTable.size(), NO_NODE);
+				
+			if (stringIndex[symbol] == NO_NODE) {
+				stringIndex[symbol] = (uint32_t)stringOffsets.size() - 1;
+				stringData += symbolName(symbol);
+				stringOffsets.push_back((uint32_t)stringData.size());
+			}
+			
+			return stringIndex[symbol];
+		}
+		
+		void link(uint32_t parent, int slot, ASTBaseNode* child) {
+			if (child)
+				work.push_back({child, -(int64_t)(parent * 4 + slot) - 1});
+		}
+		
+		// 为count个子节点在lists中留出位置，返回起点
+		template<typename T>
+		uint32_t linkList(NodeList<T> items) {
+			uint32_t begin = (uint32_t)lists.size();
+			lists.resize(lists.size() + items.size(), NO_NODE);
+			
+			for (size_t i = 0; i < items.size(); i++) {
+				if (items[i])
+					work.push_back({items[i], (int64_t)(begin + i)});
+			}
+			
+			return begin;
+		}
+		
+		// 显式栈的先序遍历，深层嵌套的表达式不会耗尽调用栈
+		uint32_t writeTree(ASTBaseNode* root) {
+			if (!root)
+				return NO_NODE;
+				
+			work.push_back({root, 0});
+			lists.push_back(NO_NODE); // lists[0]暂存根节点编号
+			
+			while (!work.empty()) {
+				Pending pending = work.back();
+				work.pop_back();
+				ASTBaseNode* node = pending.node;
+				uint32_t index = (uint32_t)nodes.size();
+				
+				if (pending.target >= 0)
+					lists[pending.target] = index;
+				else
+					nodes[(-pending.target - 1) / 4].link[(-pending.target - 1) % 4] = index;
+					
+				BinaryNode record = {node->getNodeType(), 0, 0, NO_NODE, NO_NODE, {NO_NODE, NO_NODE, NO_NODE, NO_NODE}, 0, 0, 0, 0};
+				NodeList<ASTBaseNode*> children = node->getAllChildren();
+				nodes.push_back(record);
+				nodes[index].childCount = (uint32_t)children.size();
+				nodes[index].children = linkList(children);
+				
+				switch (node->getNodeType()) {
+					case ASTBaseNode::STATEMENT:
+						nodes[index].kind = static_cast<Statement*>(node)->stmtType;
+						break;
+						
+					case ASTBaseNode::EXPRESSION: {
+							Expression* expr = static_cast<Expression*>(node);
+							nodes[index].kind = expr->exprType;
+							nodes[index].name = intern(expr->value);
+							
+							if (expr->exprType == Expression::FUNC_CALL) {
+								FunctionCall* call = static_cast<FunctionCall*>(expr);
+								nodes[index].paramCount = (uint32_t)call->parameters.size();
+								nodes[index].params = linkList(call->parameters);
+							}
+							else {
+								link(index, 0, expr->left);
+								link(index, 1, expr->right);
+							}
+							
+							break;
+						}
+						
+					case ASTBaseNode::VAR_DECL: {
+							VariableDeclaration* var = static_cast<VariableDeclaration*>(node);
+							nodes[index].type = intern(var->varType);
+							nodes[index].name = intern(var->varName);
+							link(index, 0, var->initExpr);
+							link(index, 1, var->arraySize);
+							break;
+						}
+						
+					case ASTBaseNode::FUNC_DECL: {
+							FunctionDeclaration* func = static_cast<FunctionDeclaration*>(node);
+							nodes[index].type = intern(func->returnType);
+							nodes[index].name = intern(func->funcName);
+							nodes[index].params = (uint32_t)lists.size();
+							nodes[index].paramCount = (uint32_t)func->parameters.size() * 2;
+							
+							for (const pair<Symbol, Symbol>& param : func->parameters) {
+								uint32_t type = intern(param.first), name = intern(param.second);
+								lists.push_back(type);
+								lists.push_back(name);
+							}
+							
+							break;
+						}
+						
+					case ASTBaseNode::IF_STATEMENT: {
+							IfStatement* stmt = static_cast<IfStatement*>(node);
+							link(index, 0, stmt->condition);
+							link(index, 1, stmt->thenBlock);
+							link(index, 2, stmt->elseBlock);
+							break;
+						}
+						
+					case ASTBaseNode::FOR_STATEMENT: {
+							ForStatement* stmt = static_cast<ForStatement*>(node);
+							link(index, 0, stmt->initStmt);
+							link(index, 1, stmt->condition);
+							link(index, 2, stmt->updateStmt);
+							link(index, 3, stmt->body);
+							break;
+						}
+						
+					default:
+						break;
+				}
+			}
+			
+			return lists[0];
+		}
+		
+		template<typename T>
+		static void appendSection(string& out, BinaryHeader& header, BinarySectionKind kind, const T* data, size_t count) {
+			out.resize((out.size() + 15) & ~(size_t)15, '\0');
+			header.sections[kind] = {out.size(), count * sizeof(T)};
+			out.append((const char*)data, count * sizeof(T));
+		}
+		
+	public:
+		string write(ASTBaseNode* root, const vector<IRInstr>& IR) {
+			stringIndex.clear();
+			stringOffsets.assign(1, 0);
+			stringData.clear();
+			nodes.clear();
+			lists.clear();
+			uint32_t rootIndex = writeTree(root);
+			vector<IRInstr> code(IR);
+			
+			for (IRInstr& instr : code) {
+				if (irHasSymbol(instr))
+					instr.a = (int)intern((Symbol)instr.a);
+			}
+			
+			BinaryHeader header = {{'M', 'Y', 'G', 'B'}, BINARY_FORMAT_VERSION, BINARY_BYTE_ORDER, rootIndex, {}};
+			string out(sizeof(header), '\0');
+			appendSection(out, header, SECTION_STRING_OFFSETS, stringOffsets.data(), stringOffsets.size());
+			appendSection(out, header, SECTION_STRING_DATA, stringData.data(), stringData.size());
+			appendSection(out, header, SECTION_NODES, nodes.data(), nodes.size());
+			appendSection(out, header, SECTION_LISTS, lists.data(), lists.size());
+			appendSection(out, header, SECTION_IR, code.data(), code.size());
+			memcpy(&out[0], &header, sizeof(header));
+			return out;
+		}
+};
+
+// 把AST和IR写成二进制模块文件
+void writeBinaryModule(const string& fileName, ASTBaseNode* root, const vector<IRInstr>& IR) {
+	BinaryWriter writer;
+	string data = writer.write(root, IR);
+	ofstream out(fileName, ios::binary);
+	out.write(data.data(), data.size());
+	
+	if (!out)
+		throw runtime_error("Cannot write binary module: " + fileName);
+}
+
+// 只读的二进制模块：整个文件一次mmap，节点、列表、字符串和IR都直接指向映射的内存，加载时不为单个节点分配内存
+// open只检查文件头和各段的边界，访问节点、列表和字符串时再检查下标
+class BinaryModule {
+		SourceBuffer file;
+		BinaryHeader header;
+		span<const uint32_t> stringOffsets;
+		string_view stringData;
+		span<const BinaryNode> nodes;
+		span<const uint32_t> lists;
+		span<const IRInstr> code;
+		
+		template<typename T>
+		span<const T> section(BinarySectionKind kind) {
+			string_view data = file.view();
+			const BinarySection& s = header.sections[kind];
+			
+			if (s.offset > data.size() || s.size > data.size() - s.offset || s.offset % 4 != 0 || s.size % sizeof(T) != 0)
+				throw runtime_error("Invalid binary module: bad section");
+				
+			return span<const T>((const T*)(data.data() + s.offset), s.size / sizeof(T));
+		}
+		
+	public:
+		// 映射失败或格式不对时抛出异常
+		explicit BinaryModule(const string& fileName) {
+			if (!file.open(fileName))
+				throw runtime_error("Cannot open binary module: " + fileName);
+				
+			string_view data = file.view();
+			
+			if (data.size() < sizeof(header))
+				throw runtime_error("Invalid binary module: " + fileName);
+				
+			memcpy(&header, data.data(), sizeof(header));
+			
+			if (memcmp(header.magic, "MYGB", 4) != 0 || header.byteOrder != BINARY_BYTE_ORDER)
+				throw runtime_error("Invalid binary module: " + fileName);
+				
+			if (header.version != BINARY_FORMAT_VERSION)
+				throw runtime_error("Unsupported binary module version " + to_string(header.version) + ": " + fileName);
+				
+			stringOffsets = section<uint32_t>(SECTION_STRING_OFFSETS);
+			span<const char> chars = section<char>(SECTION_STRING_DATA);
+			stringData = string_view(chars.data(), chars.size());
+			nodes = section<BinaryNode>(SECTION_NODES);
+			lists = section<uint32_t>(SECTION_LISTS);
+			code = section<IRInstr>(SECTION_IR);
+			
+			if (stringOffsets.empty() || (header.root != NO_NODE && header.root >= nodes.size()))
+				throw runtime_error("Invalid binary module: " + fileName);
+		}
+		
+		BinaryModule(const BinaryModule&) = delete;
+		BinaryModule& operator=(const BinaryModule&) = delete;
+		
+		uint32_t root() const {
+			return header.root;
+		}
+		
+		size_t nodeCount() const {
+			return nodes.size();
+		}
+		
+		size_t stringCount() const {
+			return stringOffsets.size() - 1;
+		}
+		
+		const BinaryNode& node(uint32_t index) const {
+			if (index >= nodes.size())
+				throw runtime_error("Invalid binary module: bad node index");
+				
+			return nodes[index];
+		}
+		
+		span<const uint32_t> list(uint32_t begin, uint32_t count) const {
+			if (begin > lists.size() || count > lists.size() - begin)
+				throw runtime_error("Invalid binary module: bad list");
+				
+			return lists.subspan(begin, count);
+		}
+		
+		string_view getString(uint32_t index) const {
+			if (index >= stringCount() || stringOffsets[index] > stringOffsets[index + 1] || stringOffsets[index + 1] > stringData.size())
+				throw runtime_error("Invalid binary module: bad string index");
+				
+			return stringData.substr(stringOffsets[index], stringOffsets[index + 1] - stringOffsets[index]);
+		}
+		
+		// 文件中的IR，FUNC、CALL、GLOBAL、ARRAY的a是字符串下标；未经检查，操作数可能越界
+		span<const IRInstr> getIR() const {
+			return code;
+		}
+		
+		// 逐条检查IR的操作数（名字还是字符串下标）：寄存器小于所在函数的寄存器数，标签在所在函数中定义且只定义一次，
+		// 全局变量和数组已声明，向量寄存器小于VECTOR_REGS，CALL的实参个数等于之前待传的ARG数和被调函数的形参个数
+		// VM和后端信任这些约束，损坏的模块必须在这里拒绝
+		void checkIR(const vector<IRInstr>& IR) const {
+			auto invalid = [](const string& what) {
+				throw runtime_error("Invalid binary module: " + what);
+			};
+			vector<int> parameters(stringCount(), -1); // 字符串下标 -> 同名函数的形参个数
+			vector<bool> globals, arrays; // 编号 -> 是否已声明
+			
+			auto declare = [&](vector<bool>& declared, int index) {
+				if (index < 0 || index >= BINARY_COUNT_LIMIT)
+					invalid("bad global or array number");
+					
+				if ((size_t)index >= declared.size())
+					declared.resize(index + 1, false);
+					
+				if (declared[index])
+					invalid("duplicate global or array number");
+					
+				declared[index] = true;
+			};
+			
+			for (const IRInstr& instr : IR) {
+				int op;
+				memcpy(&op, &instr.op, sizeof(op)); // 文件中的值不一定是合法的IROp
+				
+				if (op < ADD || op > VMUL)
+					invalid("bad IR opcode");
+					
+				if (irHasSymbol(instr) && (uint32_t)instr.a >= stringCount())
+					invalid("bad string index");
+					
+				if (instr.op == GLOBAL) {
+					declare(globals, instr.dst);
+				}
+				else if (instr.op == ARRAY) {
+					declare(arrays, instr.dst);
+					
+					if (instr.b < 0 || instr.b > BINARY_COUNT_LIMIT)
+						invalid("bad array length");
+				}
+				else if (instr.op == FUNC) {
+					if (instr.b < 0 || instr.dst < instr.b || instr.dst > BINARY_COUNT_LIMIT)
+						invalid("bad function header");
+						
+					parameters[instr.a] = instr.b;
+				}
+			}
+			
+			int regCount = -1, pendingArgs = 0; // 不在函数中时regCount为-1
+			vector<int> labels, targets;
+			
+			auto reg = [&](int r) {
+				if (r < 0 || r >= regCount)
+					invalid("bad register");
+			};
+			auto vreg = [&](int v) {
+				if (v < 0 || v >= VECTOR_REGS)
+					invalid("bad vector register");
+			};
+			auto global = [&](int g) {
+				if (g < 0 || (size_t)g >= globals.size() || !globals[g])
+					invalid("bad global number");
+			};
+			auto array = [&](int a) {
+				if (a < 0 || (size_t)a >= arrays.size() || !arrays[a])
+					invalid("bad array number");
+			};
+			auto endFunction = [&] {
+				if (pendingArgs)
+					invalid("ARG without CALL");
+					
+				sort(labels.begin(), labels.end());
+				
+				if (adjacent_find(labels.begin(), labels.end()) != labels.end())
+					invalid("duplicate label");
+					
+				for (int target : targets) {
+					if (!binary_search(labels.begin(), labels.end(), target))
+						invalid("undefined label");
+				}
+				
+				labels.clear();
+				targets.clear();
+			};
+			
+			for (const IRInstr& instr : IR) {
+				if (instr.op == FUNC || instr.op == GLOBAL || instr.op == ARRAY) {
+					if (regCount >= 0)
+						endFunction();
+						
+					regCount = instr.op == FUNC ? instr.dst : -1;
+					continue;
+				}
+				
+				if (regCount < 0)
+					invalid("instruction outside of a function");
+					
+				switch (instr.op) {
+					case LABEL:
+						if (instr.dst < 0 || instr.dst >= BINARY_COUNT_LIMIT)
+							invalid("bad label");
+							
+						labels.push_back(instr.dst);
+						break;
+						
+					case IF_GT:
+						reg(instr.a);
+						reg(instr.b);
+						targets.push_back(instr.dst);
+						break;
+						
+					case Goto:
+						targets.push_back(instr.dst);
+						break;
+						
+					case ARG:
+						reg(instr.a);
+						pendingArgs++;
+						break;
+						
+					case CALL:
+						reg(instr.dst);
+						
+						if (instr.b != pendingArgs || parameters[instr.a] != instr.b)
+							invalid("bad call");
+							
+						pendingArgs = 0;
+						break;
+						
+					case RET:
+						reg(instr.a);
+						break;
+						
+					case LOADG:
+						reg(instr.dst);
+						global(instr.a);
+						break;
+						
+					case STOREG:
+						global(instr.dst);
+						reg(instr.a);
+						break;
+						
+					case LOADA:
+						reg(instr.dst);
+						reg(instr.a);
+						array(instr.b);
+						break;
+						
+					case STOREA:
+						array(instr.dst);
+						reg(instr.a);
+						reg(instr.b);
+						break;
+						
+					case VLOAD:
+						vreg(instr.dst);
+						reg(instr.a);
+						array(instr.b);
+						break;
+						
+					case VSTORE:
+						array(instr.dst);
+						reg(instr.a);
+						vreg(instr.b);
+						break;
+						
+					case VSPLAT:
+						vreg(instr.dst);
+						reg(instr.a);
+						break;
+						
+					case VADD:
+					case VSUB:
+					case VMUL:
+						vreg(instr.dst);
+						vreg(instr.a);
+						vreg(instr.b);
+						break;
+						
+					case PHI: // 模块中的IR已经退出SSA形式
+						invalid("unexpected PHI");
+						break;
+						
+					default: { // 标量运算和CONST：r[dst] = ...
+							int uses[2], count = irUses(instr, uses);
+							
+							for (int k = 0; k < count; k++) {
+								reg(uses[k]);
+							}
+							
+							reg(instr.dst);
+							break;
+						}
+				}
+			}
+			
+			if (regCount >= 0)
+				endFunction();
+		}
+		
+		// 可以直接交给VM、后端和优化的IR：检查操作数，字符串下标换成当前线程的Symbol
+		vector<IRInstr> loadIR() const {
+			vector<IRInstr> IR(code.begin(), code.end());
+			vector<Symbol> symbols(stringCount(), (Symbol)NO_NODE);
+			checkIR(IR);
+			
+			for (IRInstr& instr : IR) {
+				if (!irHasSymbol(instr))
+					continue;
+					
+				uint32_t index = (uint32_t)instr.a;
+				
+				if (symbols[index] == (Symbol)NO_NODE)
+					symbols[index] = SymbolTable.intern(getString(index));
+					
+				instr.a = (int)symbols[index];
+			}
+			
+			return IR;
+		}
+		
+		// 在context中重建指针形式的AST（供需要ASTBaseNode的代码使用），没有AST时返回nullptr
+		// 子节点的编号都大于父节点，从后往前建，建到一个节点时它的子节点都已建好
+		ASTBaseNode* loadAST(ASTContext& context) const {
+			if (header.root == NO_NODE)
+				return nullptr;
+				
+			vector<ASTBaseNode*> built(nodes.size(), nullptr);
+			vector<Symbol> symbols(stringCount(), (Symbol)NO_NODE);
+			vector<ASTBaseNode*> scratch;
+			vector<Expression*> arguments;
+			vector<pair<Symbol, Symbol>> parameters;
+			
+			auto symbol = [&](uint32_t index) {
+				getString(index); // 检查下标
+				
+				if (symbols[index] == (Symbol)NO_NODE)
+					symbols[index] = SymbolTable.intern(getString(index));
+					
+				return symbols[index];
+			};
+			
+			auto child = [&](uint32_t self, uint32_t index) -> ASTBaseNode* {
+				if (index == NO_NODE)
+					return nullptr;
+					
+				if (index <= self || index >= nodes.size())
+					throw runtime_error("Invalid binary module: bad node link");
+					
+				return built[index];
+			};
+			
+			auto expression = [&](uint32_t self, uint32_t index) {
+				ASTBaseNode* node = child(self, index);
+				
+				if (node && node->getNodeType() != ASTBaseNode::EXPRESSION)
+					throw runtime_error("Invalid binary module: expected an expression");
+					
+				return static_cast<Expression*>(node);
+			};
+			
+			for (uint32_t i = (uint32_t)nodes.size(); i-- > 0;) {
+				const BinaryNode& record = nodes[i];
+				ASTBaseNode* node;
+				
+				if ((record.nodeType == ASTBaseNode::STATEMENT && record.kind > Statement::EMPTY) ||
+				        (record.nodeType == ASTBaseNode::EXPRESSION && record.kind > Expression::ARRAY_ASSIGN))
+					throw runtime_error("Invalid binary module: bad node kind");
+					
+				switch (record.nodeType) {
+					case ASTBaseNode::STATEMENT:
+						node = context.create<Statement>((Statement::StmtType)record.kind);
+						break;
+						
+					case ASTBaseNode::STMT_BLOCK:
+						node = context.create<StatementBlock>();
+						break;
+						
+					case ASTBaseNode::EXPRESSION:
+						if (record.kind == Expression::FUNC_CALL) {
+							FunctionCall* call = context.create<FunctionCall>(symbol(record.name));
+							arguments.clear();
+							
+							for (uint32_t index : list(record.params, record.paramCount)) {
+								arguments.push_back(expression(i, index));
+							}
+							
+							call->setParameters(context.makeList<Expression*>(arguments.begin(), arguments.end()));
+							node = call;
+						}
+						else {
+							node = context.create<Expression>((Expression::ExprType)record.kind, symbol(record.name),
+							                                  expression(i, record.link[0]), expression(i, record.link[1]));
+						}
+						
+						break;
+						
+					case ASTBaseNode::VAR_DECL:
+						node = context.create<VariableDeclaration>(symbol(record.type), symbol(record.name),
+						        expression(i, record.link[0]), expression(i, record.link[1]));
+						break;
+						
+					case ASTBaseNode::FUNC_DECL: {
+							span<const uint32_t> params = list(record.params, record.paramCount);
+							parameters.clear();
+							
+							for (size_t k = 0; k + 1 < params.size(); k += 2) {
+								parameters.push_back({symbol(params[k]), symbol(params[k + 1])});
+							}
+							
+							node = context.create<FunctionDeclaration>(symbol(record.type), symbol(record.name),
+							        context.makeList<pair<Symbol, Symbol>>(parameters.begin(), parameters.end()));
+							break;
+						}
+						
+					case ASTBaseNode::IF_STATEMENT:
+						node = context.create<IfStatement>(expression(i, record.link[0]), child(i, record.link[1]), child(i, record.link[2]));
+						break;
+						
+					case ASTBaseNode::FOR_STATEMENT:
+						node = context.create<ForStatement>(child(i, record.link[0]), expression(i, record.link[1]),
+						                                    child(i, record.link[2]), child(i, record.link[3]));
+						break;
+						
+					default:
+						throw runtime_error("Invalid binary module: bad node type");
+				}
+				
+				if (record.childCount) {
+					scratch.clear();
+					
+					for (uint32_t index : list(record.children, record.childCount)) {
+						scratch.push_back(child(i, index));
+					}
+					
+					node->setChildren(context.makeList<ASTBaseNode*>(scratch.begin(), scratch.end()));
+				}
+				
+				built[i] = node;
+			}
+			
+			return built[header.root];
+		}
+};
+
+#endif /*BINARY_FORMAT_H*/
@@ -0,0 +1,129 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include<cstdint>
+#include<cstring>
+#include<stdexcept>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"./X86Backend.h"
+#include"./X86Encoder.h"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include<windows.h>
+#else
+	#include<sys/mman.h>
+	#include<unistd.h>
+#endif
+using namespace std;
+
+// 进程内JIT：IR经X86CodeGen<X86Encoder>编码为机器码，复制进新映射的内存后直接调用，不经过汇编器和链接器
+// 代码页映射为只读+可执行，全局变量和数组单独占据随后的读写页（不会出现可写又可执行的页）
+// 与原生程序一致，除以0会触发硬件异常（SIGFPE），数组越界执行ud2（SIGILL），递归过深会耗尽线程栈，都会使宿主进程崩溃；
+// INT_MIN / -1与虚拟机一样回绕为INT_MIN
+// 向量化的循环默认在支持AVX2的CPU上用AVX2，否则用SSE2
+class JIT {
+		char* memory;
+		size_t mappedBytes;
+		size_t codeBytes;
+		size_t dataOffset;
+		size_t globalBytes;
+		int (*entry)();
+		
+		static size_t pageSize() {
+			#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return info.dwPageSize;
+			#else
+			return (size_t)sysconf(_SC_PAGESIZE);
+			#endif
+		}
+		
+	public:
+		static bool hostSupportsAvx2() {
+			#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+			return __builtin_cpu_supports("avx2");
+			#else
+			return false;
+			#endif
+		}
+		
+		JIT(const vector<IRInstr>& IR, bool avx2 = hostSupportsAvx2())
+			: memory(nullptr), mappedBytes(0), codeBytes(0), dataOffset(0), globalBytes(0), entry(nullptr) {
+			X86Encoder encoder;
+			X86CodeGen<X86Encoder> codegen(IR, encoder, avx2);
+			codegen.generate();
+			size_t page = pageSize();
+			const vector<uint8_t>& image = encoder.link(page); // 全局变量区从新的一页开始
+			dataOffset = encoder.getDataOffset();
+			codeBytes = dataOffset;
+			globalBytes = image.size() - dataOffset;
+			mappedBytes = (image.size() + page - 1) / page * page;
+			
+			if (mappedBytes == 0)
+				mappedBytes = page;
+				
+			#ifdef _WIN32
+			memory = (char*)VirtualAlloc(nullptr, mappedBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+			
+			if (!memory)
+				throw runtime_error("JIT: cannot allocate executable memory");
+				
+			memcpy(memory, image.data(), image.size());
+			DWORD oldProtect;
+			
+			if (!VirtualProtect(memory, codeBytes, PAGE_EXECUTE_READ, &oldProtect))
+				throw runtime_error("JIT: cannot make code executable");
+				
+			FlushInstructionCache(GetCurrentProcess(), memory, codeBytes);
+			#else
+			void* mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			
+			if (mapping == MAP_FAILED)
+				throw runtime_error("JIT: cannot allocate executable memory");
+				
+			memory = (char*)mapping;
+			memcpy(memory, image.data(), image.size());
+			
+			if (mprotect(memory, codeBytes, PROT_READ | PROT_EXEC) != 0) {
+				munmap(memory, mappedBytes);
+				throw runtime_error("JIT: cannot make code executable");
+			}
+			#endif
+			
+			entry = (int (*)())(memory + encoder.getEntryOffset());
+		}
+		
+		JIT(const JIT&) = delete;
+		JIT& operator=(const JIT&) = delete;
+		
+		// 执行顶层语句，返回其返回值；每次运行前全局变量和数组清零
+		int run() {
+			memset(memory + dataOffset, 0, globalBytes);
+			return entry();
+		}
+		
+		size_t getCodeSize() const {
+			return codeBytes;
+		}
+		
+		~JIT() {
+			if (!memory)
+				return;
+				
+			#ifdef _WIN32
+			VirtualFree(memory, 0, MEM_RELEASE);
+			#else
+			munmap(memory, mappedBytes);
+			#endif
+		}
+};
+
+#endif /*JIT_H*/
@@ -0,0 +1,1020 @@
+#ifndef X86_BACKEND_H
+#define X86_BACKEND_H
+
+#include<algorithm>
+#include<climits>
+#include<sstream>
+#include<string>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"../IR/CFG.h"
+#include"../Token.h"
+using namespace std;
+
+// x86-64寄存器编号（即机器码中的编号）
+enum X86Reg : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// 条件码（即jcc/setcc机器码的低4位）；X86_A为无符号大于，用于数组下标检查
+enum X86Cond : uint8_t { X86_A = 0x7, X86_E = 0x4, X86_NE = 0x5, X86_L = 0xC, X86_GE = 0xD, X86_LE = 0xE, X86_G = 0xF };
+
+enum X86Alu : uint8_t { X86_ADD, X86_SUB, X86_CMP };
+
+// SSE2的xmm, xmm运算（值即66 0F之后的操作码）
+enum X86Sse : uint8_t { SSE_MOVDQA = 0x6F, SSE_PADDD = 0xFE, SSE_PSUBD = 0xFA, SSE_PMULUDQ = 0xF4, SSE_PUNPCKLDQ = 0x62 };
+
+// AVX2的三操作数ymm运算
+enum X86Avx : uint8_t { AVX_PADDD, AVX_PSUBD, AVX_PMULLD };
+
+// 32位操作数：寄存器、rbp相对的栈槽、立即数、全局变量或数组元素
+struct X86Operand {
+	enum Kind : uint8_t { REG, MEM, IMM, GLOBAL, ELEMENT, ARRAY };
+	Kind kind;
+	int value; // REG：寄存器编号；MEM：相对rbp的偏移；IMM：立即数；GLOBAL：全局变量编号；
+	// ELEMENT：[rdx+rcx*4+value]（rdx为数组起点，rcx为下标）；ARRAY：数组编号（只用于lea取数组起点）
+	
+	static X86Operand reg(int r) {
+		return {REG, r};
+	}
+	
+	static X86Operand mem(int offset) {
+		return {MEM, offset};
+	}
+	
+	static X86Operand imm(int value) {
+		return {IMM, value};
+	}
+	
+	static X86Operand global(int index) {
+		return {GLOBAL, index};
+	}
+	
+	static X86Operand element(int offset) {
+		return {ELEMENT, offset};
+	}
+	
+	static X86Operand array(int index) {
+		return {ARRAY, index};
+	}
+	
+	bool isMemory() const {
+		return kind == MEM || kind == GLOBAL || kind == ELEMENT;
+	}
+};
+
+// IR -> x86-64指令（System V调用约定）。指令经由Emitter输出：X86AsmWriter生成汇编文本，X86Encoder直接生成机器码
+// 每个函数先做活跃变量分析得到虚拟寄存器的活跃区间，再用线性扫描分配物理寄存器，分配不下的溢出到栈帧
+// 标签在整个程序内统一编号；函数按FUNC出现的顺序编号，全局变量沿用GLOBAL的编号，数组沿用ARRAY的编号
+// 数组下标越界时跳到函数末尾的ud2（SIGILL）。向量寄存器v固定映射到ymm v（AVX2）或xmm 2v、2v+1（SSE2），
+// xmm14、xmm15留作SSE2乘法的临时寄存器；向量只在不含调用的循环内存活，不需要保存
+template<typename Emitter>
+class X86CodeGen {
+		// 可分配的寄存器：前5个被调用者保存（可跨越call），后2个调用者保存（只给不跨越call的区间）
+		// eax/ecx/edx留作临时寄存器，参数寄存器不参与分配，因此传参和取参时不会互相覆盖
+		static constexpr int REG_COUNT = 7;
+		static constexpr int CALLEE_SAVED_COUNT = 5;
+		static constexpr int NO_LOCATION = INT_MIN;
+		static constexpr X86Reg ALLOCATABLE[REG_COUNT] = {RBX, R12, R13, R14, R15, R10, R11};
+		static constexpr X86Reg ARG_REGS[6] = {RDI, RSI, RDX, RCX, R8, R9};
+		
+		// 一个虚拟寄存器的活跃区间[start, end]（IR中的指令下标）
+		struct Interval {
+			int reg;
+			size_t start;
+			size_t end;
+			bool crossesCall; // 区间内部有call，值必须放在被调用者保存的寄存器或栈上
+		};
+		
+		const vector<IRInstr>& IR;
+		Emitter& emitter;
+		bool avx2; // 向量指令用AVX2（否则用SSE2）
+		vector<int> location; // 虚拟寄存器 -> 可分配寄存器的下标(>=0)或溢出槽-(slot+1)
+		vector<bool> usedRegs;
+		int spillSlots;
+		int savedCount; // 本函数压栈保存的被调用者保存寄存器个数
+		int labelBase; // 本函数的标签0在全局编号中的位置
+		int trapLabel; // 本函数的越界出口
+		bool trapUsed;
+		int extraLabels; // 本函数在IR的标签之外另用的标签数（编号接在trapLabel之后）
+		vector<int> functionIndex; // 函数名 -> 函数编号
+		vector<int> arrayLength; // 数组编号 -> 长度
+		
+		// 计算活跃区间：块入口/出口活跃的寄存器覆盖整个块边界，指令中的读写覆盖该指令
+		// ARG的值在随后的CALL处才被读出，所以它的区间延伸到那条CALL
+		vector<Interval> buildIntervals(const CFG& cfg, const Liveness& liveness) {
+			vector<Interval> intervals(cfg.regCount, {0, SIZE_MAX, 0, false});
+			
+			for (int r = 0; r < cfg.regCount; r++) {
+				intervals[r].reg = r;
+			}
+			
+			auto extend = [&](int reg, size_t pos) {
+				Interval& interval = intervals[reg];
+				
+				if (interval.start == SIZE_MAX) {
+					interval.start = interval.end = pos;
+				}
+				else {
+					interval.start = min(interval.start, pos);
+					interval.end = max(interval.end, pos);
+				}
+			};
+			
+			for (int r = 0; r < IR[cfg.funcBegin].b; r++) {
+				extend(r, cfg.funcBegin); // 形参在入口处写入
+			}
+			
+			// 以下两个数组都以funcBegin为0号下标
+			size_t length = cfg.funcEnd - cfg.funcBegin;
+			vector<size_t> nextCall(length + 1, SIZE_MAX); // 每条指令之后（含自身）的第一条CALL
+			vector<size_t> callCount(length + 1, 0); // callCount[k]：前k条指令中的CALL个数
+			
+			for (size_t k = length; k > 0; k--) {
+				nextCall[k - 1] = IR[cfg.funcBegin + k - 1].op == CALL ? cfg.funcBegin + k - 1 : nextCall[k];
+			}
+			
+			for (size_t k = 0; k < length; k++) {
+				callCount[k + 1] = callCount[k] + (IR[cfg.funcBegin + k].op == CALL);
+			}
+			
+			for (int b = 0; b < (int)cfg.blocks.size(); b++) {
+				const BasicBlock& block = cfg.blocks[b];
+				liveness.forEachLiveIn(b, [&](int reg) {
+					extend(reg, block.begin);
+				});
+				liveness.forEachLiveOut(b, [&](int reg) {
+					extend(reg, block.end - 1);
+				});
+				
+				for (size_t i = block.begin; i < block.end; i++) {
+					int uses[2];
+					int count = irUses(IR[i], uses);
+					
+					for (int k = 0; k < count; k++) {
+						extend(uses[k], IR[i].op == ARG && nextCall[i - cfg.funcBegin] != SIZE_MAX ? nextCall[i - cfg.funcBegin] : i);
+					}
+					
+					int d = irDef(IR[i]);
+					
+					if (d >= 0)
+						extend(d, i);
+				}
+			}
+			
+			vector<Interval> result;
+			
+			for (Interval& interval : intervals) {
+				if (interval.start == SIZE_MAX || interval.end == cfg.funcBegin) // 从未被读取的形参不分配位置，入口处也不取
+					continue;
+					
+				// 严格位于区间内部的CALL：(start, end)
+				interval.crossesCall = interval.end > interval.start + 1 &&
+				                       callCount[interval.end - cfg.funcBegin] > callCount[interval.start + 1 - cfg.funcBegin];
+				result.push_back(interval);
+			}
+			
+			sort(result.begin(), result.end(), [](const Interval & x, const Interval & y) {
+				return x.start < y.start;
+			});
+			return result;
+		}
+		
+		// 线性扫描（Poletto & Sarkar）：按起点依次分配，已结束的区间归还寄存器；
+		// 没有空闲寄存器时，溢出当前活跃区间中结束最晚的那个
+		void allocateRegisters(const CFG& cfg) {
+			Liveness liveness(IR, cfg);
+			vector<Interval> intervals = buildIntervals(cfg, liveness);
+			vector<Interval> active;
+			bool freeReg[REG_COUNT];
+			fill(freeReg, freeReg + REG_COUNT, true);
+			location.assign(cfg.regCount, NO_LOCATION);
+			usedRegs.assign(REG_COUNT, false);
+			spillSlots = 0;
+			
+			for (const Interval& current : intervals) {
+				for (size_t i = 0; i < active.size();) {
+					if (active[i].end <= current.start) {
+						freeReg[location[active[i].reg]] = true;
+						active.erase(active.begin() + i);
+					}
+					else {
+						i++;
+					}
+				}
+				
+				int chosen = -1;
+				
+				if (!current.crossesCall) { // 优先用调用者保存的寄存器，省去入口处的压栈
+					for (int r = CALLEE_SAVED_COUNT; r < REG_COUNT && chosen < 0; r++) {
+						if (freeReg[r])
+							chosen = r;
+					}
+				}
+				
+				for (int r = 0; r < CALLEE_SAVED_COUNT && chosen < 0; r++) {
+					if (freeReg[r])
+						chosen = r;
+				}
+				
+				if (chosen < 0) {
+					int victim = -1;
+					
+					for (int i = 0; i < (int)active.size(); i++) {
+						bool usable = !current.crossesCall || location[active[i].reg] < CALLEE_SAVED_COUNT;
+						
+						if (usable && (victim < 0 || active[i].end > active[victim].end))
+							victim = i;
+					}
+					
+					if (victim < 0 || active[victim].end <= current.end) {
+						location[current.reg] = -(++spillSlots);
+						continue;
+					}
+					
+					chosen = location[active[victim].reg];
+					location[active[victim].reg] = -(++spillSlots);
+					active.erase(active.begin() + victim);
+				}
+				
+				freeReg[chosen] = false;
+				usedRegs[chosen] = true;
+				location[current.reg] = chosen;
+				active.push_back(current);
+			}
+		}
+		
+		
+		bool inReg(int v) const {
+			return location[v] >= 0;
+		}
+		
+		bool sameLocation(int x, int y) const {
+			return location[x] == location[y];
+		}
+		
+		bool hasLocation(int v) const {
+			return location[v] != NO_LOCATION;
+		}
+		
+		X86Operand operand(int v) const {
+			if (location[v] >= 0)
+				return X86Operand::reg(ALLOCATABLE[location[v]]);
+				
+			if (location[v] == NO_LOCATION) // 从未被读写的寄存器，只可能是未使用的结果
+				return X86Operand::reg(RAX);
+				
+			return X86Operand::mem(-(8 * savedCount + 8 * -location[v]));
+		}
+		
+		// 把v读入临时寄存器
+		void load(X86Reg reg, int v) {
+			emitter.mov(X86Operand::reg(reg), operand(v));
+		}
+		
+		void store(int v, X86Reg reg) {
+			if (hasLocation(v))
+				emitter.mov(operand(v), X86Operand::reg(reg));
+		}
+		
+		void move(int dst, int src) {
+			if (!hasLocation(dst) || sameLocation(dst, src))
+				return;
+				
+			if (inReg(dst) || inReg(src)) {
+				emitter.mov(operand(dst), operand(src));
+			}
+			else {
+				load(RAX, src);
+				store(dst, RAX);
+			}
+		}
+		
+		// dst = a op b，op为add/sub/imul
+		void arithmetic(IROp op, const IRInstr& instr) {
+			bool commutative = op != SUB;
+			auto apply = [&](X86Reg dst, X86Operand src) {
+				if (op == MUL)
+					emitter.imul(dst, src);
+				else
+					emitter.alu(op == ADD ? X86_ADD : X86_SUB, X86Operand::reg(dst), src);
+			};
+			
+			if (inReg(instr.dst) && !sameLocation(instr.dst, instr.b)) {
+				move(instr.dst, instr.a);
+				apply((X86Reg)operand(instr.dst).value, operand(instr.b));
+			}
+			else if (inReg(instr.dst) && commutative) { // dst与b同一个寄存器
+				apply((X86Reg)operand(instr.dst).value, operand(instr.a));
+			}
+			else {
+				load(RAX, instr.a);
+				apply(RAX, operand(instr.b));
+				store(instr.dst, RAX);
+			}
+		}
+		
+		void compare(int a, int b) {
+			if (inReg(a) || inReg(b)) {
+				emitter.alu(X86_CMP, operand(a), operand(b));
+			}
+			else {
+				load(RAX, a);
+				emitter.alu(X86_CMP, X86Operand::reg(RAX), operand(b));
+			}
+		}
+		
+		void setFlag(X86Cond cond, int dst) {
+			if (inReg(dst)) {
+				emitter.setFlag(cond, (X86Reg)operand(dst).value);
+			}
+			else {
+				emitter.setFlag(cond, RAX);
+				store(dst, RAX);
+			}
+		}
+		
+		// 除数为-1时用neg代替idiv：INT_MIN / -1在idiv中溢出触发SIGFPE，这里与VM、常量折叠一样回绕为INT_MIN
+		void divide(const IRInstr& instr) {
+			int divideLabel = trapLabel + 1 + extraLabels++, doneLabel = trapLabel + 1 + extraLabels++;
+			load(RAX, instr.a);
+			emitter.alu(X86_CMP, operand(instr.b), X86Operand::imm(-1));
+			emitter.jcc(X86_NE, divideLabel);
+			emitter.neg(RAX);
+			emitter.jmp(doneLabel);
+			emitter.bindLabel(divideLabel);
+			emitter.cdq();
+			emitter.idiv(operand(instr.b));
+			emitter.bindLabel(doneLabel);
+			store(instr.dst, RAX);
+		}
+		
+		// 检查数组array从下标index开始的count个元素都在范围内，之后rdx为数组起点、rcx为下标（ELEMENT操作数可用）
+		void elementAddress(int array, int index, int count) {
+			load(RCX, index);
+			
+			if (arrayLength[array] < count) {
+				emitter.jmp(trapLabel);
+			}
+			else { // 无符号比较，负下标同样越界
+				emitter.alu(X86_CMP, X86Operand::reg(RCX), X86Operand::imm(arrayLength[array] - count));
+				emitter.jcc(X86_A, trapLabel);
+			}
+			
+			emitter.leaArray(RDX, array);
+			trapUsed = true;
+		}
+		
+		// 向量寄存器v的第half个xmm（AVX2下整个在一个ymm中，half只能为0）
+		int xmm(int v, int half = 0) const {
+			return avx2 ? v : 2 * v + half;
+		}
+		
+		void vectorMove(const IRInstr& instr) {
+			bool store = instr.op == VSTORE;
+			int v = store ? instr.b : instr.dst;
+			elementAddress(store ? instr.dst : instr.b, instr.a, VECTOR_WIDTH);
+			
+			for (int half = 0; half < (avx2 ? 1 : 2); half++) {
+				emitter.vectorMove(store, xmm(v, half), 16 * half, avx2);
+			}
+		}
+		
+		void vectorSplat(const IRInstr& instr) {
+			load(RAX, instr.a);
+			emitter.movd(xmm(instr.dst), RAX, avx2);
+			
+			if (avx2) {
+				emitter.broadcast(instr.dst, instr.dst);
+			}
+			else {
+				emitter.pshufd(xmm(instr.dst), xmm(instr.dst), 0);
+				emitter.sse(SSE_MOVDQA, xmm(instr.dst, 1), xmm(instr.dst));
+			}
+		}
+		
+		// 逐分量的加减乘。SSE2没有32位乘法，按两组pmuludq分别算偶数和奇数分量，再交错拼回
+		void vectorArithmetic(const IRInstr& instr) {
+			if (avx2) {
+				emitter.avx(instr.op == VADD ? AVX_PADDD : instr.op == VSUB ? AVX_PSUBD : AVX_PMULLD, instr.dst, instr.a, instr.b);
+				return;
+			}
+			
+			const int T0 = 14, T1 = 15;
+			auto copy = [this](int dst, int src) {
+				if (dst != src)
+					emitter.sse(SSE_MOVDQA, dst, src);
+			};
+			
+			for (int half = 0; half < 2; half++) {
+				int d = xmm(instr.dst, half), a = xmm(instr.a, half), b = xmm(instr.b, half);
+				
+				if (instr.op == VMUL) {
+					copy(T0, a);
+					emitter.sse(SSE_PMULUDQ, T0, b); // 分量0、2的积
+					copy(T1, a);
+					emitter.psrlq(T1, 32);
+					copy(d, b);
+					emitter.psrlq(d, 32);
+					emitter.sse(SSE_PMULUDQ, T1, d); // 分量1、3的积
+					emitter.pshufd(T0, T0, 0x08);
+					emitter.pshufd(T1, T1, 0x08);
+					emitter.sse(SSE_PUNPCKLDQ, T0, T1);
+					copy(d, T0);
+					continue;
+				}
+				
+				int target = d == b ? T0 : d;
+				copy(target, a);
+				emitter.sse(instr.op == VADD ? SSE_PADDD : SSE_PSUBD, target, b);
+				copy(d, target);
+			}
+		}
+		
+		void emitFunction(size_t begin, int index) {
+			CFG cfg(IR, begin);
+			allocateRegisters(cfg);
+			const IRInstr& header = IR[begin];
+			int labelCount = (int)cfg.labelBlock.size();
+			int returnLabel = labelBase + labelCount; // 公共出口：恢复寄存器并返回
+			bool usesVectors = false;
+			trapLabel = returnLabel + 1;
+			trapUsed = false;
+			extraLabels = 0;
+			savedCount = 0;
+			
+			for (int r = 0; r < CALLEE_SAVED_COUNT; r++) {
+				savedCount += usedRegs[r];
+			}
+			
+			// 压栈后rsp应保持16字节对齐：返回地址 + rbp + 保存的寄存器 + 溢出槽
+			int frameBytes = 8 * spillSlots;
+			
+			if ((8 * savedCount + frameBytes) % 16)
+				frameBytes += 8;
+				
+			emitter.beginFunction(index);
+			emitter.push(RBP);
+			emitter.movRbpRsp();
+			
+			for (int r = 0; r < CALLEE_SAVED_COUNT; r++) {
+				if (usedRegs[r])
+					emitter.push(ALLOCATABLE[r]);
+			}
+			
+			if (frameBytes)
+				emitter.adjustRsp(-frameBytes);
+				
+			// 取参：前6个在寄存器中，其余由调用方压栈
+			for (int i = 0; i < header.b; i++) {
+				if (!hasLocation(i))
+					continue;
+					
+				if (i < 6) {
+					emitter.mov(operand(i), X86Operand::reg(ARG_REGS[i]));
+				}
+				else {
+					emitter.mov(X86Operand::reg(RAX), X86Operand::mem(16 + 8 * (i - 6)));
+					store(i, RAX);
+				}
+			}
+			
+			vector<int> pendingArgs;
+			
+			for (size_t i = begin + 1; i < cfg.funcEnd; i++) {
+				const IRInstr& instr = IR[i];
+				
+				switch (instr.op) {
+					case ADD:
+					case SUB:
+					case MUL:
+						arithmetic(instr.op, instr);
+						break;
+						
+					case DIV: // 除数为0时与C一样触发SIGFPE
+						divide(instr);
+						break;
+						
+					case ASSIGN:
+						move(instr.dst, instr.a);
+						break;
+						
+					case INC:
+						move(instr.dst, instr.a);
+						
+						if (hasLocation(instr.dst))
+							emitter.alu(X86_ADD, operand(instr.dst), X86Operand::imm(1));
+							
+						break;
+						
+					case CONST:
+						if (hasLocation(instr.dst))
+							emitter.mov(operand(instr.dst), X86Operand::imm(instr.a));
+							
+						break;
+						
+					case EQ:
+					case NE:
+					case LT:
+					case LE:
+					case GT:
+					case GE: {
+							static const X86Cond conds[] = {X86_E, X86_NE, X86_L, X86_LE, X86_G, X86_GE};
+							compare(instr.a, instr.b);
+							setFlag(conds[instr.op - EQ], instr.dst);
+							break;
+						}
+						
+					case NOT:
+						emitter.alu(X86_CMP, operand(instr.a), X86Operand::imm(0));
+						setFlag(X86_E, instr.dst);
+						break;
+						
+					case IF_GT:
+						compare(instr.a, instr.b);
+						emitter.jcc(X86_G, labelBase + instr.dst);
+						break;
+						
+					case Goto:
+						emitter.jmp(labelBase + instr.dst);
+						break;
+						
+					case LABEL:
+						emitter.bindLabel(labelBase + instr.dst);
+						break;
+						
+					case ARG: // 实参在CALL处统一放入参数寄存器
+						pendingArgs.push_back(instr.a);
+						break;
+						
+					case CALL: {
+							int stackArgs = max(0, (int)pendingArgs.size() - 6);
+							int padding = stackArgs % 2 ? 8 : 0;
+							
+							if (padding)
+								emitter.adjustRsp(-8);
+								
+							for (int k = (int)pendingArgs.size() - 1; k >= 6; k--) {
+								load(RAX, pendingArgs[k]);
+								emitter.push(RAX);
+							}
+							
+							for (int k = 0; k < (int)pendingArgs.size() && k < 6; k++) {
+								load(ARG_REGS[k], pendingArgs[k]);
+							}
+							
+							if ((Symbol)instr.a >= functionIndex.size() || functionIndex[instr.a] < 0)
+								throw runtime_error("Undefined function: " + string(symbolName(instr.a)));
+								
+							emitter.call(functionIndex[instr.a]);
+							
+							if (stackArgs)
+								emitter.adjustRsp(8 * stackArgs + padding);
+								
+							store(instr.dst, RAX);
+							pendingArgs.clear();
+							break;
+						}
+						
+					case RET:
+						load(RAX, instr.a);
+						
+						if (i + 1 < cfg.funcEnd)
+							emitter.jmp(returnLabel);
+							
+						break;
+						
+					case LOADG:
+						if (inReg(instr.dst)) {
+							emitter.mov(operand(instr.dst), X86Operand::global(instr.a));
+						}
+						else {
+							emitter.mov(X86Operand::reg(RAX), X86Operand::global(instr.a));
+							store(instr.dst, RAX);
+						}
+						
+						break;
+						
+					case STOREG:
+						if (inReg(instr.a)) {
+							emitter.mov(X86Operand::global(instr.dst), operand(instr.a));
+						}
+						else {
+							load(RAX, instr.a);
+							emitter.mov(X86Operand::global(instr.dst), X86Operand::reg(RAX));
+						}
+						
+						break;
+						
+					case LOADA:
+						elementAddress(instr.b, instr.a, 1);
+						
+						if (inReg(instr.dst)) {
+							emitter.mov(operand(instr.dst), X86Operand::element(0));
+						}
+						else {
+							emitter.mov(X86Operand::reg(RAX), X86Operand::element(0));
+							store(instr.dst, RAX);
+						}
+						
+						break;
+						
+					case STOREA:
+						if (inReg(instr.b)) {
+							elementAddress(instr.dst, instr.a, 1);
+							emitter.mov(X86Operand::element(0), operand(instr.b));
+						}
+						else {
+							load(RAX, instr.b);
+							elementAddress(instr.dst, instr.a, 1);
+							emitter.mov(X86Operand::element(0), X86Operand::reg(RAX));
+						}
+						
+						break;
+						
+					case VLOAD:
+					case VSTORE:
+						vectorMove(instr);
+						usesVectors = true;
+						break;
+						
+					case VSPLAT:
+						vectorSplat(instr);
+						usesVectors = true;
+						break;
+						
+					case VADD:
+					case VSUB:
+					case VMUL:
+						vectorArithmetic(instr);
+						usesVectors = true;
+						break;
+						
+					case PHI:
+						throw runtime_error("Malformed IR: PHI must be removed before code generation");
+						
+					default:
+						break;
+				}
+			}
+			
+			emitter.bindLabel(returnLabel);
+			emitter.restoreRsp(8 * savedCount);
+			
+			for (int r = CALLEE_SAVED_COUNT - 1; r >= 0; r--) {
+				if (usedRegs[r])
+					emitter.pop(ALLOCATABLE[r]);
+			}
+			
+			emitter.pop(RBP);
+			
+			if (usesVectors && avx2) // 避免调用方随后的SSE代码付出AVX状态切换的代价
+				emitter.vzeroupper();
+				
+			emitter.ret();
+			
+			if (trapUsed) {
+				emitter.bindLabel(trapLabel);
+				emitter.ud2();
+			}
+			
+			emitter.endFunction(index);
+			labelBase = trapLabel + 1 + extraLabels;
+		}
+		
+	public:
+		X86CodeGen(const vector<IRInstr>& IR, Emitter& emitter, bool avx2 = false)
+			: IR(IR), emitter(emitter), avx2(avx2), spillSlots(0), savedCount(0), labelBase(0), trapLabel(0), trapUsed(false),
+			  extraLabels(0) {}
+			
+		// 依次生成所有函数；emitter先收到函数、全局变量和数组的名字表（编号 -> 名字，数组另有长度）以及顶层函数的编号
+		void generate() {
+			vector<Symbol> functions, globals;
+			vector<pair<Symbol, int>> arrays;
+			int topIndex = -1;
+			Symbol topName = SymbolTable.intern(TOP_LEVEL_NAME);
+			functionIndex.assign(SymbolTable.size(), -1);
+			
+			for (const IRInstr& instr : IR) {
+				if (instr.op == GLOBAL) {
+					if ((size_t)instr.dst >= globals.size())
+						globals.resize(instr.dst + 1);
+						
+					globals[instr.dst] = instr.a;
+				}
+				else if (instr.op == ARRAY) {
+					if ((size_t)instr.dst >= arrays.size())
+						arrays.resize(instr.dst + 1, {0, 0});
+						
+					arrays[instr.dst] = {instr.a, instr.b};
+				}
+				else if (instr.op == FUNC) {
+					if ((Symbol)instr.a == topName)
+						topIndex = (int)functions.size();
+						
+					functionIndex[instr.a] = (int)functions.size();
+					functions.push_back(instr.a);
+				}
+			}
+			
+			if (topIndex < 0)
+				throw runtime_error("Malformed IR: no top-level function");
+				
+			arrayLength.clear();
+			
+			for (auto [name, length] : arrays) {
+				arrayLength.push_back(length);
+			}
+			
+			emitter.beginProgram(functions, globals, arrays, topIndex);
+			labelBase = 0;
+			
+			for (size_t i = 0, index = 0; i < IR.size(); i++) {
+				if (IR[i].op == FUNC)
+					emitFunction(i, (int)index++);
+			}
+			
+			emitter.endProgram();
+		}
+};
+
+// 输出GNU as汇编文本（Intel语法，ELF）
+// 符号：函数myg_fn_<名字>，全局变量myg_var_<名字>，数组myg_arr_<名字>，顶层语句myg_top（int myg_top(void)，可从C调用）
+class X86AsmWriter {
+		static constexpr const char* REG32[16] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+		                                          "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+		                                         };
+		static constexpr const char* REG64[16] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+		                                          "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+		                                         };
+		
+		ostringstream out;
+		vector<string> functionNames;
+		vector<string> globalNames;
+		vector<string> arrayNames;
+		int topIndex;
+		bool emitMain;
+		
+		static const char* condName(X86Cond cond) {
+			switch (cond) {
+				case X86_E:
+					return "e";
+					
+				case X86_NE:
+					return "ne";
+					
+				case X86_L:
+					return "l";
+					
+				case X86_GE:
+					return "ge";
+					
+				case X86_LE:
+					return "le";
+					
+				case X86_A:
+					return "a";
+					
+				default:
+					return "g";
+			}
+		}
+		
+		string format(X86Operand operand) const {
+			switch (operand.kind) {
+				case X86Operand::REG:
+					return REG32[operand.value];
+					
+				case X86Operand::MEM:
+					return "DWORD PTR [rbp" + string(operand.value < 0 ? "-" : "+") + to_string(abs(operand.value)) + "]";
+					
+				case X86Operand::IMM:
+					return to_string(operand.value);
+					
+				case X86Operand::ELEMENT:
+					return "DWORD PTR " + element(operand.value);
+					
+				case X86Operand::ARRAY:
+					return "[rip+" + arrayNames[operand.value] + "]";
+					
+				default:
+					return "DWORD PTR [rip+" + globalNames[operand.value] + "]";
+			}
+		}
+		
+		static string element(int offset) {
+			return "[rdx+rcx*4" + (offset ? "+" + to_string(offset) : string()) + "]";
+		}
+		
+		static string vreg(int index, bool wide) {
+			return (wide ? "ymm" : "xmm") + to_string(index);
+		}
+		
+		void line(const string& text) {
+			out << "\t" << text << "\n";
+		}
+		
+		static string label(int id) {
+			return ".L" + to_string(id);
+		}
+		
+	public:
+		X86AsmWriter(bool emitMain = true) : topIndex(0), emitMain(emitMain) {}
+		
+		void beginProgram(const vector<Symbol>& functions, const vector<Symbol>& globals, const vector<pair<Symbol, int>>& arrays, int top) {
+			topIndex = top;
+			out << "\t.intel_syntax noprefix\n";
+			
+			for (size_t i = 0; i < functions.size(); i++) {
+				functionNames.push_back((int)i == top ? "myg_top" : "myg_fn_" + string(symbolName(functions[i])));
+			}
+			
+			for (Symbol name : globals) {
+				globalNames.push_back("myg_var_" + string(symbolName(name)));
+			}
+			
+			if (!globalNames.empty()) {
+				out << "\t.bss\n\t.p2align 2\n";
+				
+				for (const string& name : globalNames) {
+					out << name << ":\n\t.zero 4\n";
+				}
+			}
+			
+			if (!arrays.empty()) {
+				out << "\t.bss\n";
+				
+				for (auto [name, length] : arrays) { // 按32字节对齐，便于向量访问
+					arrayNames.push_back("myg_arr_" + string(symbolName(name)));
+					out << "\t.p2align 5\n" << arrayNames.back() << ":\n\t.zero " << 4 * (int64_t)length << "\n";
+				}
+			}
+			
+			out << "\t.text\n\t.globl myg_top\n";
+		}
+		
+		// 程序入口：顶层语句的返回值作为进程退出码
+		void endProgram() {
+			if (emitMain) {
+				out << "\n\t.globl main\n\t.type main, @function\nmain:\n";
+				line("sub rsp, 8");
+				line("call myg_top");
+				line("add rsp, 8");
+				line("ret");
+				out << "\t.size main, .-main\n";
+			}
+			
+			out << "\t.section .note.GNU-stack,\"\",@progbits\n";
+		}
+		
+		void beginFunction(int index) {
+			out << "\n\t.type " << functionNames[index] << ", @function\n" << functionNames[index] << ":\n";
+		}
+		
+		void endFunction(int index) {
+			out << "\t.size " << functionNames[index] << ", .-" << functionNames[index] << "\n";
+		}
+		
+		void bindLabel(int id) {
+			out << label(id) << ":\n";
+		}
+		
+		void mov(X86Operand dst, X86Operand src) {
+			line("mov " + format(dst) + ", " + format(src));
+		}
+		
+		void alu(X86Alu op, X86Operand dst, X86Operand src) {
+			static const char* const names[] = {"add", "sub", "cmp"};
+			line(string(names[op]) + " " + format(dst) + ", " + format(src));
+		}
+		
+		void imul(X86Reg dst, X86Operand src) {
+			line("imul " + string(REG32[dst]) + ", " + format(src));
+		}
+		
+		void cdq() {
+			line("cdq");
+		}
+		
+		void idiv(X86Operand src) {
+			line("idiv " + format(src));
+		}
+		
+		void neg(X86Reg reg) {
+			line("neg " + string(REG32[reg]));
+		}
+		
+		// setcc al; movzx dst, al
+		void setFlag(X86Cond cond, X86Reg dst) {
+			line("set" + string(condName(cond)) + " al");
+			line("movzx " + string(REG32[dst]) + ", al");
+		}
+		
+		void jcc(X86Cond cond, int target) {
+			line("j" + string(condName(cond)) + " " + label(target));
+		}
+		
+		void jmp(int target) {
+			line("jmp " + label(target));
+		}
+		
+		void call(int function) {
+			line("call " + functionNames[function]);
+		}
+		
+		void push(X86Reg reg) {
+			line("push " + string(REG64[reg]));
+		}
+		
+		void pop(X86Reg reg) {
+			line("pop " + string(REG64[reg]));
+		}
+		
+		void movRbpRsp() {
+			line("mov rbp, rsp");
+		}
+		
+		// rsp += bytes
+		void adjustRsp(int bytes) {
+			line(string(bytes < 0 ? "sub" : "add") + " rsp, " + to_string(abs(bytes)));
+		}
+		
+		// rsp = rbp - savedBytes（回到保存的寄存器之上）
+		void restoreRsp(int savedBytes) {
+			if (savedBytes)
+				line("lea rsp, [rbp-" + to_string(savedBytes) + "]");
+			else
+				line("mov rsp, rbp");
+		}
+		
+		void ret() {
+			line("ret");
+		}
+		
+		void ud2() {
+			line("ud2");
+		}
+		
+		void leaArray(X86Reg dst, int array) {
+			line("lea " + string(REG64[dst]) + ", " + format(X86Operand::array(array)));
+		}
+		
+		// movdqu/vmovdqu：xmm/ymm与[rdx+rcx*4+offset]之间
+		void vectorMove(bool store, int reg, int offset, bool wide) {
+			string memory = string(wide ? "YMMWORD PTR " : "XMMWORD PTR ") + element(offset);
+			string name = string(wide ? "vmovdqu " : "movdqu ");
+			line(name + (store ? memory + ", " + vreg(reg, wide) : vreg(reg, wide) + ", " + memory));
+		}
+		
+		void movd(int dst, X86Reg src, bool vex) {
+			line(string(vex ? "vmovd " : "movd ") + vreg(dst, false) + ", " + REG32[src]);
+		}
+		
+		void broadcast(int dst, int src) {
+			line("vpbroadcastd " + vreg(dst, true) + ", " + vreg(src, false));
+		}
+		
+		void sse(X86Sse op, int dst, int src) {
+			const char* name = op == SSE_MOVDQA ? "movdqa" : op == SSE_PADDD ? "paddd" : op == SSE_PSUBD ? "psubd" :
+			                   op == SSE_PMULUDQ ? "pmuludq" : "punpckldq";
+			line(string(name) + " " + vreg(dst, false) + ", " + vreg(src, false));
+		}
+		
+		void psrlq(int reg, int bits) {
+			line("psrlq " + vreg(reg, false) + ", " + to_string(bits));
+		}
+		
+		void pshufd(int dst, int src, int order) {
+			line("pshufd " + vreg(dst, false) + ", " + vreg(src, false) + ", " + to_string(order));
+		}
+		
+		void avx(X86Avx op, int dst, int a, int b) {
+			static const char* const names[] = {"vpaddd", "vpsubd", "vpmulld"};
+			line(string(names[op]) + " " + vreg(dst, true) + ", " + vreg(a, true) + ", " + vreg(b, true));
+		}
+		
+		void vzeroupper() {
+			line("vzeroupper");
+		}
+		
+		string str() const {
+			return out.str();
+		}
+};
+
+// IR -> 汇编文本，可直接交给系统的as/cc汇编链接；向量指令默认只用x86-64都支持的SSE2
+class X86Backend {
+		const vector<IRInstr>& IR;
+		bool emitMain;
+		bool avx2;
+		
+	public:
+		X86Backend(const vector<IRInstr>& IR, bool emitMain = true, bool avx2 = false) : IR(IR), emitMain(emitMain), avx2(avx2) {}
+		
+		string generate() {
+			X86AsmWriter writer(emitMain);
+			X86CodeGen<X86AsmWriter> codegen(IR, writer, avx2);
+			codegen.generate();
+			return writer.str();
+		}
+};
+
+#endif /*X86_BACKEND_H*/
@@ -0,0 +1,453 @@
+#ifndef X86_ENCODER_H
+#define X86_ENCODER_H
+
+#include<cstdint>
+#include<cstring>
+#include<stdexcept>
+#include<vector>
+#include"./X86Backend.h"
+using namespace std;
+
+// X86CodeGen的另一个输出端：直接编码为x86-64机器码
+// 跳转、调用和RIP相对的全局变量/数组访问都先写入占位的rel32，link()时按最终布局回填
+// 布局：[代码][顶层入口桩][全局变量区][数组区]，数据紧跟代码，rel32总能覆盖；每个数组按32字节对齐
+class X86Encoder {
+		struct Fixup {
+			size_t pos; // rel32在code中的位置
+			int target; // 标签/函数/全局变量编号
+			int tail; // rel32之后本条指令还有几个字节（立即数）
+		};
+		
+		vector<uint8_t> code;
+		vector<size_t> labelPos; // 标签 -> 位置，SIZE_MAX表示尚未绑定
+		vector<size_t> functionPos;
+		vector<Fixup> labelFixups;
+		vector<Fixup> callFixups;
+		vector<Fixup> globalFixups;
+		vector<Fixup> arrayFixups;
+		vector<size_t> arrayOffset; // 数组 -> 在数据区中的偏移
+		size_t dataBytes; // 全局变量区和数组区的总大小
+		size_t globalCount;
+		size_t entryPos;
+		size_t dataPos;
+		int topIndex;
+		
+		void byte(uint8_t value) {
+			code.push_back(value);
+		}
+		
+		void dword(int32_t value) {
+			uint8_t bytes[4];
+			memcpy(bytes, &value, 4);
+			code.insert(code.end(), bytes, bytes + 4);
+		}
+		
+		static bool fitsByte(int value) {
+			return value >= -128 && value <= 127;
+		}
+		
+		void patch(size_t pos, int32_t value) {
+			memcpy(&code[pos], &value, 4);
+		}
+		
+		// 带ModRM的指令：opcode后跟ModRM（reg字段为寄存器或/digit），rm为寄存器、rbp相对、RIP相对内存或数组元素
+		void emitRM(initializer_list<uint8_t> opcode, int reg, X86Operand rm, bool wide = false, int tail = 0) {
+			uint8_t rex = 0x40 | (wide ? 8 : 0) | (reg >= 8 ? 4 : 0) | (rm.kind == X86Operand::REG && rm.value >= 8 ? 1 : 0);
+			
+			if (rex != 0x40)
+				byte(rex);
+				
+			for (uint8_t op : opcode) {
+				byte(op);
+			}
+			
+			modRM(reg, rm, tail);
+		}
+		
+		// SSE指令：强制前缀（66/F3）须在REX之前
+		void emitSse(uint8_t prefix, uint8_t opcode, int reg, X86Operand rm, int tail = 0) {
+			byte(prefix);
+			emitRM({0x0F, opcode}, reg, rm, false, tail);
+		}
+		
+		// VEX编码的指令（总用三字节形式）：map为1(0F)或2(0F38)，pp为1(66)或2(F3)，vvvv为第二个源寄存器
+		void emitVex(int map, int pp, bool wide, int reg, int vvvv, X86Operand rm, uint8_t opcode) {
+			byte(0xC4);
+			byte((uint8_t)((reg >= 8 ? 0 : 0x80) | 0x40 | (rm.kind == X86Operand::REG && rm.value >= 8 ? 0 : 0x20) | map));
+			byte((uint8_t)((~vvvv & 15) << 3 | (wide ? 4 : 0) | pp));
+			byte(opcode);
+			modRM(reg, rm, 0);
+		}
+		
+		void modRM(int reg, X86Operand rm, int tail) {
+			uint8_t regBits = (uint8_t)((reg & 7) << 3);
+			
+			switch (rm.kind) {
+				case X86Operand::REG:
+					byte(0xC0 | regBits | (rm.value & 7));
+					break;
+					
+				case X86Operand::MEM: // [rbp+disp8] / [rbp+disp32]
+					if (fitsByte(rm.value)) {
+						byte(0x45 | regBits);
+						byte((uint8_t)rm.value);
+					}
+					else {
+						byte(0x85 | regBits);
+						dword(rm.value);
+					}
+					
+					break;
+					
+				case X86Operand::GLOBAL: // [rip+disp32]
+					byte(0x05 | regBits);
+					globalFixups.push_back({code.size(), rm.value, tail});
+					dword(0);
+					break;
+					
+				case X86Operand::ARRAY:
+					byte(0x05 | regBits);
+					arrayFixups.push_back({code.size(), rm.value, tail});
+					dword(0);
+					break;
+					
+				case X86Operand::ELEMENT: // [rdx+rcx*4+disp]，SIB = 10 001 010
+					if (rm.value == 0) {
+						byte(0x04 | regBits);
+						byte(0x8A);
+					}
+					else if (fitsByte(rm.value)) {
+						byte(0x44 | regBits);
+						byte(0x8A);
+						byte((uint8_t)rm.value);
+					}
+					else {
+						byte(0x84 | regBits);
+						byte(0x8A);
+						dword(rm.value);
+					}
+					
+					break;
+					
+				default:
+					throw runtime_error("x86 encoder: immediate used as memory operand");
+			}
+		}
+		
+		void rel32(vector<Fixup>& fixups, int target) {
+			fixups.push_back({code.size(), target, 0});
+			dword(0);
+		}
+		
+	public:
+		X86Encoder() : dataBytes(0), globalCount(0), entryPos(0), dataPos(0), topIndex(0) {}
+		
+		void beginProgram(const vector<Symbol>& functions, const vector<Symbol>& globals, const vector<pair<Symbol, int>>& arrays, int top) {
+			functionPos.assign(functions.size(), SIZE_MAX);
+			globalCount = globals.size();
+			topIndex = top;
+			dataBytes = 4 * globalCount;
+			arrayOffset.clear();
+			
+			for (auto [name, length] : arrays) {
+				dataBytes = (dataBytes + 31) / 32 * 32;
+				arrayOffset.push_back(dataBytes);
+				dataBytes += 4 * (size_t)length;
+			}
+		}
+		
+		// 顶层入口桩：按两种调用约定都可安全调用——额外保存rsi/rdi和xmm6~xmm15（Win64中为被调用者保存），再调用顶层函数
+		void endProgram() {
+			const int XMM_SAVED = 10;
+			entryPos = code.size();
+			push(RSI);
+			push(RDI);
+			adjustRsp(-(16 * XMM_SAVED + 8));
+			
+			for (int k = 0; k < XMM_SAVED; k++) { // movdqu [rsp+16k], xmm(6+k)
+				byte(0xF3);
+				
+				if (6 + k >= 8)
+					byte(0x44);
+					
+				byte(0x0F);
+				byte(0x7F);
+				byte(0x84 | ((6 + k) & 7) << 3);
+				byte(0x24);
+				dword(16 * k);
+			}
+			
+			call(topIndex);
+			
+			for (int k = 0; k < XMM_SAVED; k++) { // movdqu xmm(6+k), [rsp+16k]
+				byte(0xF3);
+				
+				if (6 + k >= 8)
+					byte(0x44);
+					
+				byte(0x0F);
+				byte(0x6F);
+				byte(0x84 | ((6 + k) & 7) << 3);
+				byte(0x24);
+				dword(16 * k);
+			}
+			
+			adjustRsp(16 * XMM_SAVED + 8);
+			pop(RDI);
+			pop(RSI);
+			ret();
+		}
+		
+		void beginFunction(int index) {
+			while (code.size() % 16) { // 函数入口按16字节对齐，填充int3
+				byte(0xCC);
+			}
+			
+			functionPos[index] = code.size();
+		}
+		
+		void endFunction(int) {}
+		
+		void bindLabel(int id) {
+			if ((size_t)id >= labelPos.size())
+				labelPos.resize(id + 1, SIZE_MAX);
+				
+			labelPos[id] = code.size();
+		}
+		
+		void mov(X86Operand dst, X86Operand src) {
+			if (dst.kind == X86Operand::REG && src.kind == X86Operand::IMM) { // mov r32, imm32
+				if (dst.value >= 8)
+					byte(0x41);
+					
+				byte(0xB8 + (dst.value & 7));
+				dword(src.value);
+			}
+			else if (dst.kind == X86Operand::REG) { // mov r32, r/m32
+				emitRM({0x8B}, dst.value, src);
+			}
+			else if (src.kind == X86Operand::REG) { // mov r/m32, r32
+				emitRM({0x89}, src.value, dst);
+			}
+			else if (src.kind == X86Operand::IMM) { // mov r/m32, imm32
+				emitRM({0xC7}, 0, dst, false, 4);
+				dword(src.value);
+			}
+			else {
+				throw runtime_error("x86 encoder: memory-to-memory mov");
+			}
+		}
+		
+		void alu(X86Alu op, X86Operand dst, X86Operand src) {
+			static const uint8_t toRM[] = {0x01, 0x29, 0x39}; // r/m op= r
+			static const uint8_t toReg[] = {0x03, 0x2B, 0x3B}; // r op= r/m
+			static const int digit[] = {0, 5, 7}; // 立即数形式的/digit
+			
+			if (src.kind == X86Operand::IMM) {
+				if (fitsByte(src.value)) {
+					emitRM({0x83}, digit[op], dst, false, 1);
+					byte((uint8_t)src.value);
+				}
+				else {
+					emitRM({0x81}, digit[op], dst, false, 4);
+					dword(src.value);
+				}
+			}
+			else if (dst.kind == X86Operand::REG) {
+				emitRM({toReg[op]}, dst.value, src);
+			}
+			else if (src.kind == X86Operand::REG) {
+				emitRM({toRM[op]}, src.value, dst);
+			}
+			else {
+				throw runtime_error("x86 encoder: memory-to-memory alu");
+			}
+		}
+		
+		void imul(X86Reg dst, X86Operand src) {
+			emitRM({0x0F, 0xAF}, dst, src);
+		}
+		
+		void cdq() {
+			byte(0x99);
+		}
+		
+		void idiv(X86Operand src) {
+			emitRM({0xF7}, 7, src);
+		}
+		
+		void neg(X86Reg reg) {
+			emitRM({0xF7}, 3, X86Operand::reg(reg));
+		}
+		
+		// setcc al; movzx dst, al
+		void setFlag(X86Cond cond, X86Reg dst) {
+			byte(0x0F);
+			byte(0x90 + cond);
+			byte(0xC0);
+			emitRM({0x0F, 0xB6}, dst, X86Operand::reg(RAX));
+		}
+		
+		void jcc(X86Cond cond, int target) {
+			byte(0x0F);
+			byte(0x80 + cond);
+			rel32(labelFixups, target);
+		}
+		
+		void jmp(int target) {
+			byte(0xE9);
+			rel32(labelFixups, target);
+		}
+		
+		void call(int function) {
+			byte(0xE8);
+			rel32(callFixups, function);
+		}
+		
+		void push(X86Reg reg) {
+			if (reg >= 8)
+				byte(0x41);
+				
+			byte(0x50 + (reg & 7));
+		}
+		
+		void pop(X86Reg reg) {
+			if (reg >= 8)
+				byte(0x41);
+				
+			byte(0x58 + (reg & 7));
+		}
+		
+		void movRbpRsp() {
+			byte(0x48);
+			byte(0x89);
+			byte(0xE5);
+		}
+		
+		// rsp += bytes
+		void adjustRsp(int bytes) {
+			byte(0x48);
+			byte(0x81);
+			byte(bytes < 0 ? 0xEC : 0xC4); // sub/add rsp, imm32
+			dword(abs(bytes));
+		}
+		
+		// rsp = rbp - savedBytes
+		void restoreRsp(int savedBytes) {
+			if (savedBytes == 0) { // mov rsp, rbp
+				byte(0x48);
+				byte(0x89);
+				byte(0xEC);
+			}
+			else { // lea rsp, [rbp-savedBytes]
+				emitRM({0x8D}, RSP, X86Operand::mem(-savedBytes), true);
+			}
+		}
+		
+		void ret() {
+			byte(0xC3);
+		}
+		
+		void ud2() {
+			byte(0x0F);
+			byte(0x0B);
+		}
+		
+		// lea dst, [rip+数组]
+		void leaArray(X86Reg dst, int array) {
+			emitRM({0x8D}, dst, X86Operand::array(array), true);
+		}
+		
+		// movdqu/vmovdqu：xmm/ymm与[rdx+rcx*4+offset]之间
+		void vectorMove(bool store, int reg, int offset, bool wide) {
+			if (wide)
+				emitVex(1, 2, true, reg, 0, X86Operand::element(offset), store ? 0x7F : 0x6F);
+			else
+				emitSse(0xF3, store ? 0x7F : 0x6F, reg, X86Operand::element(offset));
+		}
+		
+		// movd/vmovd xmm, r32
+		void movd(int dst, X86Reg src, bool vex) {
+			if (vex)
+				emitVex(1, 1, false, dst, 0, X86Operand::reg(src), 0x6E);
+			else
+				emitSse(0x66, 0x6E, dst, X86Operand::reg(src));
+		}
+		
+		// vpbroadcastd ymm, xmm
+		void broadcast(int dst, int src) {
+			emitVex(2, 1, true, dst, 0, X86Operand::reg(src), 0x58);
+		}
+		
+		void sse(X86Sse op, int dst, int src) {
+			emitSse(0x66, op, dst, X86Operand::reg(src));
+		}
+		
+		// psrlq xmm, imm8（66 0F 73 /2）
+		void psrlq(int reg, int bits) {
+			emitSse(0x66, 0x73, 2, X86Operand::reg(reg), 1);
+			byte((uint8_t)bits);
+		}
+		
+		void pshufd(int dst, int src, int order) {
+			emitSse(0x66, 0x70, dst, X86Operand::reg(src), 1);
+			byte((uint8_t)order);
+		}
+		
+		void avx(X86Avx op, int dst, int a, int b) {
+			static const uint8_t maps[] = {1, 1, 2};
+			static const uint8_t opcodes[] = {0xFE, 0xFA, 0x40};
+			emitVex(maps[op], 1, true, dst, a, X86Operand::reg(b), opcodes[op]);
+		}
+		
+		void vzeroupper() {
+			byte(0xC5);
+			byte(0xF8);
+			byte(0x77);
+		}
+		
+		// 回填所有rel32，并在代码之后（按dataAlignment对齐）追加全局变量区和数组区；返回整个映像（代码+数据）
+		const vector<uint8_t>& link(size_t dataAlignment = 16) {
+			auto resolve = [&](const Fixup& fixup, size_t target) {
+				patch(fixup.pos, (int32_t)((int64_t)target - (int64_t)(fixup.pos + 4 + fixup.tail)));
+			};
+			
+			for (const Fixup& fixup : labelFixups) {
+				if ((size_t)fixup.target >= labelPos.size() || labelPos[fixup.target] == SIZE_MAX)
+					throw runtime_error("x86 encoder: unbound label");
+					
+				resolve(fixup, labelPos[fixup.target]);
+			}
+			
+			for (const Fixup& fixup : callFixups) {
+				resolve(fixup, functionPos[fixup.target]);
+			}
+			
+			while (code.size() % dataAlignment) {
+				code.push_back(0xCC);
+			}
+			
+			dataPos = code.size();
+			code.resize(dataPos + dataBytes, 0);
+			
+			for (const Fixup& fixup : globalFixups) {
+				resolve(fixup, dataPos + 4 * fixup.target);
+			}
+			
+			for (const Fixup& fixup : arrayFixups) {
+				resolve(fixup, dataPos + arrayOffset[fixup.target]);
+			}
+			
+			return code;
+		}
+		
+		size_t getEntryOffset() const {
+			return entryPos;
+		}
+		
+		size_t getDataOffset() const {
+			return dataPos;
+		}
+};
+
+#endif /*X86_ENCODER_H*/
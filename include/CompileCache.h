@@ -0,0 +1,556 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include<atomic>
+#include<chrono>
+#include<cstdint>
+#include<cstdio>
+#include<cstring>
+#include<filesystem>
+#include<fstream>
+#include<functional>
+#include<string>
+#include<string_view>
+#include<thread>
+#include<unordered_map>
+#include<vector>
+#include"./Token.h"
+#include"./SourceBuffer.h"
+#include"./AST/AST.h"
+#include"./Opt/ConstantFolding.h"
+#include"./IR/IR.h"
+#include"./Opt/Peephole.h"
+using namespace std;
+
+// 编译器自身的版本，编译器重新构建后旧的缓存项全部失效
+const string COMPILER_VERSION = string("MyG++ ") + __DATE__ + " " + __TIME__;
+
+// 源码中的一个顶层函数定义：Token下标[begin, end)，body为函数体左花括号的下标
+// 缓存的键是编译器版本、配置和函数的全部Token（以空格分隔），按哈希查找，加载时逐字节核对
+struct FunctionSource {
+	size_t begin;
+	size_t body;
+	size_t end;
+	uint64_t hash; // 键的哈希
+};
+
+// 函数引用的外部名字，加载时按名字重新定位到当前程序中的编号
+struct CacheReference {
+	int kind; // 'F'函数、'G'全局变量、'A'数组
+	int arity; // 调用函数时的实参个数
+	string_view name; // 指向符号表或包文件
+};
+
+// 一个缓存项：函数降级并做完窥孔优化后的IR，其中引用名字的字段（见irNameField）保存references的下标
+// references取自窥孔优化之前的IR，被优化删掉的引用在加载时同样要检查
+struct CachedFunction {
+	vector<CacheReference> references;
+	string_view code; // 包文件中各条IRInstr的原始字节（不一定对齐）
+	string_view entry; // 整个缓存项，原样写回新的包文件
+};
+
+// 指令中引用函数名、全局变量或数组编号的字段，kind同CacheReference；没有时返回nullptr（FUNC的函数名另行处理）
+int* irNameField(IRInstr& instr, int& kind) {
+	switch (instr.op) {
+		case CALL:
+			kind = 'F';
+			return &instr.a;
+			
+		case LOADG:
+			kind = 'G';
+			return &instr.a;
+			
+		case STOREG:
+			kind = 'G';
+			return &instr.dst;
+			
+		case LOADA:
+		case VLOAD:
+			kind = 'A';
+			return &instr.b;
+			
+		case STOREA:
+		case VSTORE:
+			kind = 'A';
+			return &instr.dst;
+			
+		default:
+			return nullptr;
+	}
+}
+
+// 程序中的全局变量、数组和函数，由IR中的GLOBAL、ARRAY和FUNC得到
+class ProgramSymbols {
+		vector<Symbol> globalName, arrayName; // 编号 -> 名字
+		vector<int> globalIndex, arrayIndex, functionParams; // 名字 -> 编号/形参个数，-1表示没有
+		
+		static int lookup(const vector<int>& table, Symbol name) {
+			return name < table.size() ? table[name] : -1;
+		}
+		
+	public:
+		explicit ProgramSymbols(const vector<IRInstr>& IR) {
+			size_t symbolCount = SymbolTable.size();
+			globalIndex.assign(symbolCount, -1);
+			arrayIndex.assign(symbolCount, -1);
+			functionParams.assign(symbolCount, -1);
+			
+			for (const IRInstr& instr : IR) {
+				if (instr.op == GLOBAL) {
+					globalIndex[instr.a] = instr.dst;
+					globalName.resize(max(globalName.size(), (size_t)instr.dst + 1));
+					globalName[instr.dst] = (Symbol)instr.a;
+				}
+				else if (instr.op == ARRAY) {
+					arrayIndex[instr.a] = instr.dst;
+					arrayName.resize(max(arrayName.size(), (size_t)instr.dst + 1));
+					arrayName[instr.dst] = (Symbol)instr.a;
+				}
+				else if (instr.op == FUNC) {
+					functionParams[instr.a] = instr.b;
+				}
+			}
+		}
+		
+		// 字段中的值（函数名sym或编号）对应的名字
+		Symbol nameOf(int kind, int value) const {
+			return kind == 'G' ? globalName[value] : kind == 'A' ? arrayName[value] : (Symbol)value;
+		}
+		
+		// 名字在当前程序中的字段值，不存在（或函数的形参个数不是arity）时返回-1
+		int resolve(int kind, Symbol name, int arity) const {
+			if (kind == 'G')
+				return lookup(globalIndex, name);
+				
+			if (kind == 'A')
+				return lookup(arrayIndex, name);
+				
+			return lookup(functionParams, name) == arity ? (int)name : -1;
+		}
+};
+
+// 以函数为单位的磁盘编译缓存：每个顶层函数的IR以其Token内容（连同编译器版本和配置）为键保存
+// 函数的Token没有变化时只解析函数头，函数体的IR从缓存中读出，按名字重新定位后拼回原来的位置，结果与完整编译相同
+// 同一个源文件的缓存项放在directory下的一个包文件中（一次mmap读入），改动过的函数的新缓存项追加在末尾，
+// 过时的缓存项多于有效的时整个重写到临时文件后再改名；读写失败、包文件损坏都只当作未命中
+class CompileCache {
+		string directory;
+		string configuration; // 影响缓存内容的编译选项
+		string keyPrefix; // 编译器版本 + 配置，所有键的开头
+		atomic<size_t> hits, misses;
+		
+		// 每次混入8个字节，h为之前内容的哈希
+		static uint64_t hash(string_view text, uint64_t h = 0x243f6a8885a308d3ull) {
+			for (size_t i = 0; i < text.size(); i += 8) {
+				uint64_t chunk = 0;
+				memcpy(&chunk, text.data() + i, min((size_t)8, text.size() - i));
+				h = (h ^ chunk) * 0x9e3779b97f4a7c15ull;
+				h ^= h >> 29;
+			}
+			
+			return (h ^ text.size()) * 0xbf58476d1ce4e5b9ull;
+		}
+		
+		string packPath(const string& sourceName) const {
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.pack", (unsigned long long)hash(sourceName, hash(configuration)));
+			return (filesystem::path(directory) / name).string();
+		}
+		
+		template<typename T>
+		static void putInt(string& out, T value) {
+			out.append((const char*)&value, sizeof(value));
+		}
+		
+		static void putString(string& out, string_view text) {
+			putInt(out, (int)text.size());
+			out.append(text);
+		}
+		
+		// 从data[pos]读取，越界时返回false
+		template<typename T>
+		static bool getInt(string_view data, size_t& pos, T& value) {
+			if (data.size() - pos < sizeof(value))
+				return false;
+				
+			memcpy(&value, data.data() + pos, sizeof(value));
+			pos += sizeof(value);
+			return true;
+		}
+		
+		static bool getString(string_view data, size_t& pos, string_view& text) {
+			int length;
+			
+			if (!getInt(data, pos, length) || length < 0 || data.size() - pos < (size_t)length)
+				return false;
+				
+			text = data.substr(pos, length);
+			pos += length;
+			return true;
+		}
+		
+		// 键：keyPrefix之后是函数的各个Token，每个后面跟一个空格
+		string keyOf(const vector<Token>& tokens, const FunctionSource& function) const {
+			string key = keyPrefix;
+			
+			for (size_t k = function.begin; k < function.end; k++) {
+				key += tokens[k].getContent();
+				key += ' ';
+			}
+			
+			return key;
+		}
+		
+		bool sameKey(string_view key, const vector<Token>& tokens, const FunctionSource& function) const {
+			if (key.substr(0, keyPrefix.size()) != keyPrefix)
+				return false;
+				
+			size_t pos = keyPrefix.size();
+			
+			for (size_t k = function.begin; k < function.end; k++) {
+				string_view content = tokens[k].getContent();
+				
+				if (key.size() - pos <= content.size() || key.compare(pos, content.size(), content) != 0 ||
+				        key[pos + content.size()] != ' ')
+					return false;
+					
+				pos += content.size() + 1;
+			}
+			
+			return pos == key.size();
+		}
+		
+		// 包文件（本机字节序）："MYGC"，之后直到文件末尾都是缓存项（键的哈希、长度、内容），同一个哈希以最后一项为准
+		// 缓存项：键，引用个数及各引用（kind、arity、名字），指令条数及各指令
+		// 文件完整时返回true；末尾不完整（例如写入中断）时保留之前的缓存项并返回false
+		static bool readPack(string_view data, unordered_map<uint64_t, string_view>& entries) {
+			size_t pos = 4;
+			
+			if (data.substr(0, 4) != "MYGC")
+				return false;
+				
+			while (pos < data.size()) {
+				uint64_t h;
+				string_view entry;
+				
+				if (!getInt(data, pos, h) || !getString(data, pos, entry))
+					return false;
+					
+				entries[h] = entry;
+			}
+			
+			return true;
+		}
+		
+		bool parseEntry(string_view entry, const vector<Token>& tokens, const FunctionSource& function,
+		                CachedFunction& cached) const {
+			size_t pos = 0;
+			string_view key;
+			int count;
+			
+			if (!getString(entry, pos, key) || !sameKey(key, tokens, function) || !getInt(entry, pos, count) || count < 0)
+				return false;
+				
+			cached.references.resize(count);
+			
+			for (CacheReference& reference : cached.references) {
+				if (!getInt(entry, pos, reference.kind) || !getInt(entry, pos, reference.arity) || !getString(entry, pos, reference.name))
+					return false;
+			}
+			
+			if (!getInt(entry, pos, count) || count < 1 || entry.size() - pos != count * sizeof(IRInstr))
+				return false;
+				
+			cached.code = entry.substr(pos);
+			cached.entry = entry;
+			return true;
+		}
+		
+		// 从降级后的IR中取出一个函数生成缓存项：raw[rawBegin, rawEnd)为窥孔优化前的该函数，IR[begin, end)为优化后的
+		static string makeEntry(const string& key, const vector<IRInstr>& raw, size_t rawBegin, size_t rawEnd,
+		                        const vector<IRInstr>& IR, size_t begin, size_t end, const ProgramSymbols& program) {
+			vector<CacheReference> references;
+			unordered_map<uint64_t, int> referenceIndex; // (kind, 名字) -> references下标
+			int kind;
+			
+			auto reference = [&](IRInstr instr) {
+				int* field = irNameField(instr, kind);
+				Symbol name = program.nameOf(kind, *field);
+				auto inserted = referenceIndex.emplace((uint64_t)kind << 32 | name, (int)references.size());
+				
+				if (inserted.second)
+					references.push_back({kind, instr.op == CALL ? instr.b : 0, symbolName(name)});
+					
+				return inserted.first->second;
+			};
+			
+			for (size_t i = rawBegin + 1; i < rawEnd; i++) {
+				IRInstr instr = raw[i];
+				
+				if (irNameField(instr, kind))
+					reference(instr);
+			}
+			
+			vector<IRInstr> code(IR.begin() + begin, IR.begin() + end);
+			code[0].a = 0;
+			
+			for (size_t i = 1; i < code.size(); i++) {
+				if (int* field = irNameField(code[i], kind))
+					*field = reference(code[i]);
+			}
+			
+			string entry;
+			putString(entry, key);
+			putInt(entry, (int)references.size());
+			
+			for (const CacheReference& reference : references) {
+				putInt(entry, reference.kind);
+				putInt(entry, reference.arity);
+				putString(entry, reference.name);
+			}
+			
+			putInt(entry, (int)code.size());
+			entry.append((const char*)code.data(), code.size() * sizeof(IRInstr));
+			return entry;
+		}
+		
+		// 把缓存的函数重新定位到当前程序，接在out末尾，header为解析函数头得到的FUNC
+		// 引用的名字不存在或形参个数不符时返回false
+		static bool relocate(const CachedFunction& cached, const IRInstr& header, const ProgramSymbols& program,
+		                     vector<IRInstr>& out) {
+			vector<int> value(cached.references.size());
+			int kind;
+			
+			for (size_t k = 0; k < cached.references.size(); k++) {
+				const CacheReference& reference = cached.references[k];
+				value[k] = program.resolve(reference.kind, SymbolTable.intern(reference.name), reference.arity);
+				
+				if (value[k] < 0)
+					return false;
+			}
+			
+			size_t first = out.size();
+			out.resize(first + cached.code.size() / sizeof(IRInstr));
+			memcpy(&out[first], cached.code.data(), cached.code.size());
+			
+			if (out[first].op != FUNC || out[first].b != header.b)
+				return false;
+				
+			out[first].a = header.a;
+			
+			for (size_t i = first + 1; i < out.size(); i++) {
+				if (int* field = irNameField(out[i], kind)) {
+					if (*field < 0 || *field >= (int)value.size())
+						return false;
+						
+					*field = value[*field];
+				}
+			}
+			
+			return true;
+		}
+		
+		// compile的主体：packData为原来的包文件，需要写入时把要追加的缓存项（append为true）或新的包文件写到pack
+		bool compile(string_view packData, const vector<Token>& tokens, ASTContext& context, ASTBaseNode*& root,
+		             vector<IRInstr>& IR, string& pack, bool& append) {
+			unordered_map<uint64_t, string_view> entries;
+			bool complete = readPack(packData, entries);
+			
+			vector<FunctionSource> functions = findFunctions(tokens);
+			vector<CachedFunction> cached(functions.size()); // 没命中的函数entry为空
+			vector<Token> reduced;
+			reduced.reserve(tokens.size());
+			size_t next = 0, hitCount = 0;
+			
+			for (size_t k = 0; k < functions.size(); k++) {
+				const FunctionSource& function = functions[k];
+				auto it = entries.find(function.hash);
+				bool hit = it != entries.end() && parseEntry(it->second, tokens, function, cached[k]);
+				
+				if (!hit)
+					cached[k].entry = string_view();
+					
+				hitCount += hit;
+				reduced.insert(reduced.end(), tokens.begin() + next, tokens.begin() + (hit ? function.body + 1 : function.end));
+				
+				if (hit) // 函数体换成空的
+					reduced.push_back(tokens[function.end - 1]);
+					
+				next = function.end;
+			}
+			
+			reduced.insert(reduced.end(), tokens.begin() + next, tokens.end());
+			hits += hitCount;
+			misses += functions.size() - hitCount;
+			
+			try {
+				AST ast(reduced, context);
+				root = ast.buildAST();
+				ASTFolder folder(context);
+				folder.fold(root);
+				vector<IRInstr> raw = getIRFromAST(root);
+				vector<IRInstr> optimized = raw;
+				peephole(optimized);
+				ProgramSymbols program(optimized);
+				vector<string> fresh(functions.size());
+				
+				IR.clear();
+				IR.reserve(optimized.size());
+				size_t i = 0, r = 0;
+				
+				// 跳过GLOBAL、ARRAY和顶层语句组成的函数，之后的函数与functions一一对应
+				while (i < optimized.size() && optimized[i].op != FUNC) {
+					IR.push_back(optimized[i++]);
+				}
+				
+				while (r < raw.size() && raw[r].op != FUNC) {
+					r++;
+				}
+				
+				for (size_t k = 0; k <= functions.size(); k++) {
+					if (i >= optimized.size() || r >= raw.size())
+						return false;
+						
+					size_t end = irFunctionEnd(optimized, i), rawEnd = irFunctionEnd(raw, r);
+					
+					if (k == 0 || cached[k - 1].entry.empty()) {
+						IR.insert(IR.end(), optimized.begin() + i, optimized.begin() + end);
+						
+						if (k > 0)
+							fresh[k - 1] = makeEntry(keyOf(tokens, functions[k - 1]), raw, r, rawEnd, optimized, i, end, program);
+					}
+					else if (!relocate(cached[k - 1], optimized[i], program, IR)) {
+						return false;
+					}
+					
+					i = end;
+					r = rawEnd;
+				}
+				
+				if (i != optimized.size())
+					return false;
+					
+				// 过时的缓存项不多时只追加没命中的，否则连同命中的一起重写
+				append = complete && entries.size() - hitCount <= functions.size();
+				
+				if (!append)
+					pack = "MYGC";
+					
+				for (size_t k = 0; k < functions.size(); k++) {
+					if (!append || cached[k].entry.empty()) {
+						putInt(pack, functions[k].hash);
+						putString(pack, cached[k].entry.empty() ? fresh[k] : cached[k].entry);
+					}
+				}
+				
+				return true;
+			}
+			catch (exception&) {
+				return false;
+			}
+		}
+		
+	public:
+		// configuration中写入所有会改变缓存内容的选项，不同配置的缓存项互不命中
+		explicit CompileCache(const string& directory, const string& configuration = "")
+			: directory(directory), configuration(configuration), keyPrefix(COMPILER_VERSION + "\n" + configuration + "\n"),
+			  hits(0), misses(0) {
+			error_code error;
+			filesystem::create_directories(directory, error);
+		}
+		
+		// 找出所有顶层函数定义（与AST::buildAST的判断相同：int、名字、左括号），花括号不配对时返回空，留给解析器报错
+		vector<FunctionSource> findFunctions(const vector<Token>& tokens) const {
+			vector<FunctionSource> functions;
+			uint64_t prefixHash = hash(keyPrefix);
+			size_t n = tokens.size();
+			int depth = 0;
+			
+			for (size_t i = 0; i < n; i++) {
+				Symbol symbol = tokens[i].getSymbol();
+				
+				if (depth == 0 && symbol == SYM_INT && i + 2 < n && tokens[i + 1].getSymbol() != SYM_SEMICOLON &&
+				        tokens[i + 2].getSymbol() == SYM_LPAREN) {
+					size_t body = i + 3;
+					
+					while (body < n && tokens[body].getSymbol() != SYM_LBRACE) {
+						body++;
+					}
+					
+					size_t end = body;
+					
+					for (int nested = 0; end < n; end++) {
+						Symbol s = tokens[end].getSymbol();
+						nested += s == SYM_LBRACE ? 1 : s == SYM_RBRACE ? -1 : 0;
+						
+						if (nested == 0)
+							break;
+					}
+					
+					if (end >= n)
+						return {};
+						
+					FunctionSource function = {i, body, end + 1, prefixHash};
+					
+					for (size_t k = i; k <= end; k++) {
+						function.hash = hash(tokens[k].getContent(), function.hash);
+					}
+					
+					functions.push_back(move(function));
+					i = end;
+					continue;
+				}
+				
+				if (symbol == SYM_LBRACE)
+					depth++;
+				else if (symbol == SYM_RBRACE)
+					depth--;
+			}
+			
+			return functions;
+		}
+		
+		// 编译源文件sourceName的tokens（与File::compileAST、compileIR的步骤相同），命中缓存的函数只解析函数头
+		// 缓存的函数引用了当前程序中不存在的名字、或编译出错时返回false，由调用者不用缓存重新编译（报告与之相同的错误）
+		bool compile(const string& sourceName, const vector<Token>& tokens, ASTContext& context, ASTBaseNode*& root,
+		             vector<IRInstr>& IR) {
+			string path = packPath(sourceName), pack;
+			bool ok, append = false;
+			
+			{
+				SourceBuffer packFile;
+				packFile.open(path);
+				ok = compile(packFile.view(), tokens, context, root, IR, pack, append);
+			}
+			
+			if (ok && append && !pack.empty()) { // 一次写入，与其他进程的追加不会交错
+				ofstream(path, ios::binary | ios::app).write(pack.data(), pack.size());
+			}
+			else if (ok && !pack.empty()) {
+				string temp = path + "." + to_string(std::hash<thread::id>()(this_thread::get_id()) ^
+				                                     (size_t)chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+				ofstream out(temp, ios::binary);
+				out.write(pack.data(), pack.size());
+				out.close();
+				error_code error;
+				
+				if (out)
+					filesystem::rename(temp, path, error);
+					
+				if (!out || error)
+					filesystem::remove(temp, error);
+			}
+			
+			return ok;
+		}
+		
+		size_t getHits() const {
+			return hits;
+		}
+		
+		size_t getMisses() const {
+			return misses;
+		}
+};
+
+#endif /*COMPILE_CACHE_H*/
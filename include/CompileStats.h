@@ -0,0 +1,280 @@
+#ifndef COMPILE_STATS_H
+#define COMPILE_STATS_H
+
+#include<algorithm>
+#include<chrono>
+#include<cstdint>
+#include<cstdio>
+#include<cstdlib>
+#include<malloc.h>
+#include<new>
+#include<ostream>
+#include<string>
+#include<utility>
+#include<vector>
+using namespace std;
+
+// 编译过程的计量：各阶段的耗时（单调时钟）、堆内存分配，以及Token数、AST节点数、IR指令数等计数
+// 开销只有每次分配时的几次线程局部加法和每个阶段两次读时钟，可以一直开着
+
+// 本线程的堆内存计数，由下面替换的全局operator new/delete维护
+// 按申请的字节数计算；在别的线程释放的内存记在释放的线程上，所以live可能为负
+struct MemoryCounters {
+	int64_t live; // 当前占用的字节数
+	int64_t peak; // live的最大值（PhaseTimer按阶段重置）
+	uint64_t allocatedBytes; // 累计分配的字节数
+	uint64_t allocations; // 累计分配次数
+};
+
+thread_local MemoryCounters threadMemory = {0, 0, 0, 0};
+
+size_t allocationSize(void* p) {
+#ifdef _WIN32
+	return _msize(p);
+#else
+	return malloc_usable_size(p);
+#endif
+}
+
+// new[]、nothrow等形式的默认实现都转到这里
+void* operator new(size_t size) {
+	void* p;
+	
+	while (!(p = malloc(size ? size : 1))) {
+		new_handler handler = get_new_handler();
+		
+		if (!handler)
+			throw bad_alloc();
+			
+		handler();
+	}
+	
+	MemoryCounters& memory = threadMemory;
+	memory.live += (int64_t)size;
+	memory.peak = max(memory.peak, memory.live);
+	memory.allocatedBytes += size;
+	memory.allocations++;
+	return p;
+}
+
+// 数组形式也明确转到上面，和下面的delete[]成对（ASan等会另外替换没有定义的形式）
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+// 容器、unique_ptr<T>等释放时都带着申请的大小，不用再问malloc
+// 各delete不内联（标准库中的版本本来也不会内联）：内联后GCC在调用处看到operator new的结果被free，会误报-Wmismatched-new-delete
+[[gnu::noinline]] void operator delete(void* p, size_t size) noexcept {
+	threadMemory.live -= (int64_t)size;
+	free(p);
+}
+
+[[gnu::noinline]] void operator delete[](void* p, size_t size) noexcept {
+	operator delete(p, size);
+}
+
+// 不知道大小的释放（如unique_ptr<char[]>）按malloc给出的块大小扣除，比申请时记的略多
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+	if (!p)
+		return;
+		
+	threadMemory.live -= (int64_t)allocationSize(p);
+	free(p);
+}
+
+[[gnu::noinline]] void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+// 一个阶段的累计数据，同一阶段多次执行（如每个函数执行一次的pass）时累加
+struct PhaseStats {
+	string name;
+	double ms;
+	uint64_t allocatedBytes; // 阶段内分配的字节数之和
+	uint64_t allocations;
+	int64_t peakBytes; // 阶段内堆内存最多比阶段开始时多出的字节数
+	uint64_t runs;
+	
+	PhaseStats(const string& name = "") : name(name), ms(0), allocatedBytes(0), allocations(0), peakBytes(0), runs(0) {}
+	
+	void add(const PhaseStats& other) {
+		ms += other.ms;
+		allocatedBytes += other.allocatedBytes;
+		allocations += other.allocations;
+		peakBytes = max(peakBytes, other.peakBytes);
+		runs += other.runs;
+	}
+};
+
+// 计量一段代码：构造时记下时钟和本线程的内存计数，stop()或析构时累加到stats
+// 可以嵌套：内层结束时把峰值还给外层，外层看到的峰值包括内层的
+class PhaseTimer {
+		PhaseStats* stats;
+		chrono::steady_clock::time_point start;
+		int64_t startLive;
+		int64_t outerPeak;
+		uint64_t startBytes;
+		uint64_t startAllocations;
+		
+	public:
+		explicit PhaseTimer(PhaseStats& stats) : stats(&stats), start(chrono::steady_clock::now()) {
+			MemoryCounters& memory = threadMemory;
+			startLive = memory.live;
+			outerPeak = memory.peak;
+			memory.peak = memory.live;
+			startBytes = memory.allocatedBytes;
+			startAllocations = memory.allocations;
+		}
+		
+		PhaseTimer(const PhaseTimer&) = delete;
+		PhaseTimer& operator=(const PhaseTimer&) = delete;
+		
+		~PhaseTimer() {
+			stop();
+		}
+		
+		void stop() {
+			if (!stats)
+				return;
+				
+			MemoryCounters& memory = threadMemory;
+			stats->ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			stats->allocatedBytes += memory.allocatedBytes - startBytes;
+			stats->allocations += memory.allocations - startAllocations;
+			stats->peakBytes = max(stats->peakBytes, memory.peak - startLive);
+			stats->runs++;
+			memory.peak = max(memory.peak, outerPeak);
+			stats = nullptr;
+		}
+};
+
+// 按JSON字符串的转义规则输出s（连同引号）
+void writeJSONString(ostream& os, const string& s) {
+	os << '"';
+	
+	for (char c : s) {
+		if (c == '"' || c == '\\')
+			os << '\\' << c;
+		else if ((unsigned char)c < 0x20)
+			os << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+		else
+			os << c;
+	}
+	
+	os << '"';
+}
+
+// 一次（或多次合并后的）编译的全部计量结果：阶段按第一次出现的顺序排列，计数器同样
+class CompileStats {
+		vector<PhaseStats> phases;
+		vector<pair<string, uint64_t>> counters;
+		
+	public:
+		// 名为name的阶段，没有时添加到末尾（返回的引用在添加下一个阶段前有效）
+		PhaseStats& phase(const string& name) {
+			for (PhaseStats& p : phases) {
+				if (p.name == name)
+					return p;
+			}
+			
+			phases.emplace_back(name);
+			return phases.back();
+		}
+		
+		void addPhase(const PhaseStats& stats) {
+			phase(stats.name).add(stats);
+		}
+		
+		void addCounter(const string& name, uint64_t value) {
+			for (auto& counter : counters) {
+				if (counter.first == name) {
+					counter.second += value;
+					return;
+				}
+			}
+			
+			counters.emplace_back(name, value);
+		}
+		
+		// 合并另一次编译的结果（如并行编译的多个文件）：耗时、分配量、计数相加，峰值取最大
+		void merge(const CompileStats& other) {
+			for (const PhaseStats& p : other.phases) {
+				addPhase(p);
+			}
+			
+			for (const auto& counter : other.counters) {
+				addCounter(counter.first, counter.second);
+			}
+		}
+		
+		const vector<PhaseStats>& getPhases() const {
+			return phases;
+		}
+		
+		const vector<pair<string, uint64_t>>& getCounters() const {
+			return counters;
+		}
+		
+		// 各阶段的总耗时；名字中带'/'的是嵌套在外层阶段中计量的子阶段（如"optimize/inline"），已包含在外层中，不重复计入
+		double totalMs() const {
+			double total = 0;
+			
+			for (const PhaseStats& p : phases) {
+				if (p.name.find('/') == string::npos)
+					total += p.ms;
+			}
+			
+			return total;
+		}
+		
+		// 表格：每个阶段的耗时、占比、分配量和峰值，然后是各计数器
+		void print(ostream& os) const {
+			double total = totalMs();
+			char line[160];
+			snprintf(line, sizeof(line), "%-32s %12s %7s %12s %10s %12s\n", "phase", "time", "share", "allocated", "allocs",
+			         "peak");
+			os << line;
+			
+			for (const PhaseStats& p : phases) {
+				snprintf(line, sizeof(line), "%-32s %9.3f ms %6.1f%% %9.1f KB %10llu %9.1f KB\n", p.name.c_str(), p.ms,
+				         total > 0 ? p.ms * 100 / total : 0.0, p.allocatedBytes / 1024.0, (unsigned long long)p.allocations,
+				         p.peakBytes / 1024.0);
+				os << line;
+			}
+			
+			snprintf(line, sizeof(line), "%-32s %9.3f ms\n", "total", total);
+			os << line;
+			
+			for (const auto& counter : counters) {
+				snprintf(line, sizeof(line), "%-32s %12llu\n", counter.first.c_str(), (unsigned long long)counter.second);
+				os << line;
+			}
+		}
+		
+		// {"phases": [{"name", "ms", "allocatedBytes", "allocations", "peakBytes", "runs"}...], "counters": {名字: 值...}}
+		void writeJSON(ostream& os) const {
+			char number[32];
+			os << "{\"phases\": [";
+			
+			for (size_t i = 0; i < phases.size(); i++) {
+				const PhaseStats& p = phases[i];
+				snprintf(number, sizeof(number), "%.6f", p.ms);
+				os << (i ? ", " : "") << "{\"name\": ";
+				writeJSONString(os, p.name);
+				os << ", \"ms\": " << number << ", \"allocatedBytes\": " << p.allocatedBytes << ", \"allocations\": "
+				   << p.allocations << ", \"peakBytes\": " << p.peakBytes << ", \"runs\": " << p.runs << "}";
+			}
+			
+			os << "], \"counters\": {";
+			
+			for (size_t i = 0; i < counters.size(); i++) {
+				os << (i ? ", " : "");
+				writeJSONString(os, counters[i].first);
+				os << ": " << counters[i].second;
+			}
+			
+			os << "}}";
+		}
+};
+
+#endif /*COMPILE_STATS_H*/
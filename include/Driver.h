@@ -0,0 +1,91 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include<fstream>
+#include<memory>
+#include<string>
+#include<vector>
+#include"./File.h"
+#include"./ThreadPool.h"
+using namespace std;
+
+struct DriverOptions {
+	size_t jobs = 0; // 并行编译的线程数，0表示按硬件线程数
+	bool optimize = true; // 执行默认的优化流水线（否则只做窥孔优化）
+	bool emitAssembly = true; // 把x86-64汇编写到"源文件名.s"
+	bool emitBinary = false; // 把AST和IR写成二进制模块"源文件名.myb"
+	bool pipelined = false; // 每个文件的词法分析另开一个线程，与语法分析流水线进行（用缓存时不起作用）
+	string cacheDirectory; // 以函数为单位的编译缓存所在的目录，空表示不用缓存
+};
+
+struct CompileResult {
+	string input;
+	bool ok;
+	string error; // 失败时的错误信息
+	size_t instructions; // 最终的IR指令数
+	CompileStats stats; // 各阶段的耗时、内存分配和计数，编译失败时为空
+};
+
+// 编译一个源文件，全部在调用线程内完成；错误记录在结果中，不抛出
+// 文件的符号在返回时从线程的符号表中撤销，各表的大小只与这一个文件有关，编译的总耗时与文件数成线性
+CompileResult compileFile(const string& input, const DriverOptions& options, CompileCache* cache = nullptr) {
+	CompileResult result = {input, false, "", 0, CompileStats()};
+	SymbolScope symbols;
+	
+	try {
+		// 命中缓存的函数在AST中只有函数头，写二进制模块时不用缓存
+		File file(input, false, options.emitBinary ? nullptr : cache, options.pipelined);
+		
+		if (options.optimize)
+			file.optimize();
+			
+		if (options.emitAssembly) {
+			ofstream out(input + ".s", ios::binary);
+			out << file.getAssembly();
+			
+			if (!out)
+				throw runtime_error("Cannot write " + input + ".s");
+		}
+		
+		if (options.emitBinary)
+			file.saveBinary(input + ".myb");
+			
+		result.instructions = file.getIR().size();
+		result.stats = file.getStats();
+		result.ok = true;
+	}
+	catch (exception& e) {
+		result.error = e.what();
+	}
+	
+	return result;
+}
+
+// 在工作窃取线程池上并行编译inputs中的每个文件，结果与inputs一一对应
+// 每个文件是一个任务，在一个工作线程内完成从词法分析到代码生成的全部步骤（符号表是线程局部的）
+// 缓存中保存的是优化之前的IR，与optimize、emitAssembly无关，各线程共用一个缓存目录
+vector<CompileResult> compileFiles(const vector<string>& inputs, const DriverOptions& options = DriverOptions()) {
+	vector<CompileResult> results(inputs.size());
+	unique_ptr<CompileCache> cache(options.cacheDirectory.empty() ? nullptr : new CompileCache(options.cacheDirectory));
+	
+	if (inputs.size() <= 1 || options.jobs == 1) {
+		for (size_t i = 0; i < inputs.size(); i++) {
+			results[i] = compileFile(inputs[i], options, cache.get());
+		}
+		
+		return results;
+	}
+	
+	ThreadPool pool(min(options.jobs ? options.jobs : max(1u, thread::hardware_concurrency()), inputs.size()));
+	
+	for (size_t i = 0; i < inputs.size(); i++) {
+		pool.submit([&, i] {
+			results[i] = compileFile(inputs[i], options, cache.get());
+		});
+	}
+	
+	pool.wait();
+	return results;
+}
+
+#endif /*DRIVER_H*/
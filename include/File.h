@@ -1,127 +1,156 @@
+#ifndef FILE_H
+#define FILE_H
+
 #include<fstream>
 #include<string>
 #include<vector>
 #include"./Token.h"
+#include"./Lexer.h"
+#include"./SourceBuffer.h"
+#include"./CompileCache.h"
+#include"./BinaryFormat.h"
+#include"./TokenPipeline.h"
+#include"./CompileStats.h"
 #include"./AST/AST.h"
 #include"./AST/ASTPrinter.h"
 #include"./IR/IR.h"
+#include"./IR/IRprinter.h"
+#include"./IR/PassManager.h"
+#include"./Opt/Pipeline.h"
+#include"./VM/VM.h"
+#include"./CodeGen/X86Backend.h"
+#include"./CodeGen/JIT.h"
 using namespace std;
 
-const string symbolList = "+-*/=(){}[];,&|!><";
-
-bool issymbol(char c) {
-	return symbolList.find(c) != symbolList.npos;
-}
-
-bool islitter(char c) {
-	return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
-}
+#ifdef _DEBUG
+const bool FILE_DEBUG_OUTPUT = true;
+#else
+const bool FILE_DEBUG_OUTPUT = false;
+#endif
 
+// 一份源码的完整编译状态（源码、Token、AST、IR），各File之间互不共享，可以在不同线程中分别编译
 class File {
-		fstream codeFile;
-		fstream tempFile;
+		string fileName; // 源文件名，编译缓存按它找到这个文件的包文件
+		SourceBuffer source; // 源码（mmap映射），TokenList中的string_view均指向这里
 		vector<Token> TokenList;
+		ASTContext ASTcontext; // AST节点内存池，随File一起释放
 		ASTBaseNode* ASTroot;
 		vector<IRInstr> IR;
-		
-		void format() {
-			string line = "";
-			
-			while (getline(codeFile, line)) {
-				for (size_t i = 0; i < line.size(); i++) {
-					tempFile << line[i];
-					bool isMultiCharOp = false;
-					
-					// 检查是否为多字符逻辑运算符（如&&、||）
-					if (i + 1 < line.size()) {
-						string twoChars = string(1, line[i]) + string(1, line[i + 1]);
-						
-						// 包含逻辑运算符和比较运算符
-						if (twoChars == "&&" || twoChars == "||" ||
-						twoChars == "==" || twoChars == "!=" ||
-						twoChars == ">=" || twoChars == "<=" ||
-						twoChars == "++") {
-							isMultiCharOp = true;
-						}
-					}
-					
-					// 仅在不是多字符运算符的情况下，才添加空格分隔
-					if (issymbol(line[i])) {
-						if ((i + 1 < line.size()) && isdigit(line[i + 1]) && !isMultiCharOp) {
-							tempFile << " ";
-						}
-						
-						if ((i + 1 < line.size()) && islitter(line[i + 1]) && !isMultiCharOp) {
-							tempFile << " ";
-						}
-						
-						if ((i + 1 < line.size()) && issymbol(line[i + 1]) && !isMultiCharOp) {
-							tempFile << " ";
-						}
-					}
-					
-					if (isdigit(line[i])) { // 数字
-						if ((i + 1 < line.size()) && issymbol(line[i + 1])) { // 符号
-							tempFile << " ";
-						}
-					}
-					
-					if (islitter(line[i])) { // 字母
-						if ((i + 1 < line.size()) && issymbol(line[i + 1])) { // 符号
-							tempFile << " ";
-						}
-					}
-				}
-				
-				tempFile << "\n";
-			}
-		}
+		bool debugOutput; // 编译后打印AST和IR，优化后打印各pass耗时和IR
+		CompileCache* cache; // 以函数为单位的编译缓存，nullptr表示不用（命中缓存的函数在AST中只有函数头）
+		bool pipelined; // 词法分析在另一个线程上与语法分析流水线进行，TokenList保持为空（缓存要用完整的Token序列，用缓存时不开）
+		CompileStats stats; // 各阶段的耗时、内存分配和计数
 		
 		void getAllToken() {
-			tempFile.seekg(0, std::ios::beg);
-			string content = "";
-			int c = 0;
-			
-			while (tempFile >> content) {
-				TokenList.push_back({content, c});
-				c += content.size() + 1;
-			}
+			PhaseTimer timer(stats.phase("lex"));
+			Lexer lexer(source.view());
+			TokenList = lexer.getAllToken();
+			timer.stop();
+			stats.addCounter("tokens", TokenList.size());
 		}
 		
 		void compileAST() {
-			AST ast(TokenList);
-			ASTroot = ast.buildAST();
+			if (pipelined) {
+				PhaseTimer timer(stats.phase("lex + parse (pipelined)"));
+				TokenPipeline pipeline(source.view());
+				
+				try {
+					AST ast([&pipeline](vector<Token>& tokens) {
+						return pipeline.fill(tokens);
+					}, ASTcontext);
+					ASTroot = ast.buildAST();
+				}
+				catch (...) {
+					pipeline.drain(); // 后面还有词法错误时报告词法错误，与不用流水线时一致
+					throw;
+				}
+				
+				timer.stop();
+				stats.addCounter("tokens", pipeline.getTokenCount());
+			}
+			else {
+				PhaseTimer timer(stats.phase("parse"));
+				AST ast(TokenList, ASTcontext);
+				ASTroot = ast.buildAST();
+			}
+			
+			PhaseTimer timer(stats.phase("fold constants"));
+			ASTFolder folder(ASTcontext); // 降级前先折叠常量
+			folder.fold(ASTroot);
 		}
 		
 		void compileIR() {
+			PhaseTimer lowerTimer(stats.phase("lower to IR"));
 			IR = getIRFromAST(ASTroot);
+			lowerTimer.stop();
+			stats.addCounter("IR instructions (lowered)", IR.size());
+			PhaseTimer peepholeTimer(stats.phase("peephole"));
+			peephole(IR); // 线性的窥孔优化，不调用optimize()时也执行
+		}
+		
+		void countAST() {
+			size_t total = 0;
+			
+			for (size_t type = 0; type <= ASTBaseNode::FOR_STATEMENT; type++) {
+				size_t count = ASTcontext.getNodeCount(type);
+				total += count;
+				
+				if (count > 0)
+					stats.addCounter(string("AST nodes: ") + nodeTypeName((ASTBaseNode::NodeType)type), count);
+			}
+			
+			stats.addCounter("AST nodes", total);
+			stats.addCounter("AST pool bytes", ASTcontext.getReservedBytes());
 		}
 		
 	public:
-		File() {}
+		File() : ASTroot(nullptr), debugOutput(FILE_DEBUG_OUTPUT), cache(nullptr), pipelined(false) {}
 		
-		File(const string& fileName) {
-			codeFile.open(fileName);
-			tempFile.open("temp.txt", ios::out | ios::in | ios::trunc);
+		File(const string& fileName, bool debugOutput = FILE_DEBUG_OUTPUT, CompileCache* cache = nullptr, bool pipelined = false)
+			: fileName(fileName), ASTroot(nullptr), debugOutput(debugOutput), cache(cache), pipelined(pipelined && !cache) {
+			if (!source.open(fileName)) {
+				throw runtime_error("Cannot open source file: " + fileName);
+			}
+			
 			compile();
 		}
 		
 		~File() {
-			codeFile.close();
-			tempFile.close();
 		}
 		
 		void compile() {
-			format(); // 格式化
-			getAllToken(); // 转为token形式
-			compileAST(); // 转为AST
-			compileIR();
-			#ifdef _DEBUG
-			printAST();
-			#endif
+			stats.addCounter("source bytes", source.view().size());
+			
+			if (!pipelined)
+				getAllToken(); // 单遍扫描转为token形式
+				
+			bool cached = false;
+			
+			if (cache) {
+				PhaseTimer timer(stats.phase("cache lookup"));
+				cached = cache->compile(fileName, TokenList, ASTcontext, ASTroot, IR);
+			}
+			
+			if (!cached) {
+				if (cache) { // 缓存路径中途失败时已在ASTcontext中建了一部分节点，清掉再完整编译，内存和节点数不重复计入
+					ASTcontext.reset();
+					ASTroot = nullptr;
+					IR.clear();
+				}
+				
+				compileAST(); // 转为AST
+				compileIR();
+			}
+			
+			countAST();
+			stats.addCounter("IR instructions (compiled)", IR.size());
+			
+			if (debugOutput) {
+				printAST();
+				printIR();
+			}
 		}
 		
-		#ifdef _DEBUG
 		void printAST() {
 			if (ASTroot) {
 				ASTPrinter printer;
@@ -132,9 +161,75 @@ class File {
 			}
 		}
 		
-		#endif
+		void printIR() {
+			IRprinter printer(IR);
+			printer.print();
+		}
+		
+		
+		// 执行默认的优化流水线
+		void optimize() {
+			PassManager passes;
+			addStandardPasses(passes);
+			optimize(passes);
+		}
 		
-		vector<Token> returnAllToken() {
+		// 对IR依次执行passes中的优化；passes中累计的各pass计量作为"optimize/"下的子阶段记入本文件的统计
+		void optimize(PassManager& passes) {
+			PhaseTimer timer(stats.phase("optimize"));
+			passes.run(IR);
+			timer.stop();
+			passes.reportTo(stats, "optimize/");
+			stats.addCounter("IR instructions (optimized)", IR.size());
+			
+			if (debugOutput) {
+				passes.printTiming();
+				printIR();
+			}
+		}
+		
+		// 在虚拟机中执行编译结果，返回顶层语句的返回值
+		int run() {
+			VM vm(IR);
+			return vm.run();
+		}
+		
+		// JIT模式：直接生成机器码并在进程内执行顶层语句，不经过汇编器和链接器
+		// 与run()不同，运行时错误不会变成异常：除以0（SIGFPE）、数组越界（ud2，SIGILL）和递归过深会使整个进程崩溃，
+		// 不可信的程序应在子进程中执行或改用run()；INT_MIN / -1与虚拟机一样回绕为INT_MIN，不会崩溃
+		int runJIT() {
+			JIT jit(IR);
+			return jit.run();
+		}
+		
+		// 生成x86-64汇编（System V ABI），可直接交给系统的as/cc汇编链接
+		string getAssembly() {
+			PhaseTimer timer(stats.phase("x86 codegen"));
+			X86Backend backend(IR);
+			string assembly = backend.generate();
+			timer.stop();
+			stats.addCounter("assembly bytes", assembly.size());
+			return assembly;
+		}
+		
+		// 把AST和当前的IR（优化后则为优化后的）写成二进制模块，可由BinaryModule直接mmap加载
+		void saveBinary(const string& fileName) {
+			PhaseTimer timer(stats.phase("write binary module"));
+			writeBinaryModule(fileName, ASTroot, IR);
+		}
+		
+		// 各阶段的耗时、内存分配，以及Token、AST节点、IR指令等计数
+		const CompileStats& getStats() const {
+			return stats;
+		}
+		
+		const vector<IRInstr>& getIR() {
+			return IR;
+		}
+		
+		const vector<Token>& returnAllToken() {
 			return TokenList;
 		}
 };
+
+#endif /*FILE_H*/
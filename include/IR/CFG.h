@@ -0,0 +1,399 @@
+#ifndef IR_CFG_H
+#define IR_CFG_H
+
+#include<algorithm>
+#include<bit>
+#include<cstdint>
+#include<vector>
+#include"./IRbase.h"
+using namespace std;
+
+// 基本块：IR中的一段连续指令[begin, end)，下标指向整段IR
+struct BasicBlock {
+	size_t begin;
+	size_t end;
+	vector<int> succs;
+	vector<int> preds;
+};
+
+// 一个函数的控制流图：在LABEL处以及IF_GT/Goto/RET之后切分基本块
+class CFG {
+	public:
+		size_t funcBegin; // FUNC指令的位置
+		size_t funcEnd;
+		int regCount;
+		vector<BasicBlock> blocks; // 按指令顺序排列，blocks[0]为入口
+		vector<int> labelBlock; // 标签 -> 所在基本块，-1表示未定义
+		
+		CFG(const vector<IRInstr>& IR, size_t begin)
+			: funcBegin(begin), funcEnd(irFunctionEnd(IR, begin)), regCount(IR[begin].dst) {
+			size_t blockStart = begin + 1;
+			
+			for (size_t i = begin + 1; i < funcEnd; i++) {
+				const IRInstr& instr = IR[i];
+				
+				if (instr.op == LABEL && i > blockStart) {
+					blocks.push_back({blockStart, i, {}, {}});
+					blockStart = i;
+				}
+				
+				if (instr.op == LABEL) {
+					if ((size_t)instr.dst >= labelBlock.size())
+						labelBlock.resize(instr.dst + 1, -1);
+						
+					labelBlock[instr.dst] = (int)blocks.size();
+				}
+				
+				if (instr.op == IF_GT || instr.op == Goto || instr.op == RET) {
+					blocks.push_back({blockStart, i + 1, {}, {}});
+					blockStart = i + 1;
+				}
+			}
+			
+			if (blockStart < funcEnd)
+				blocks.push_back({blockStart, funcEnd, {}, {}});
+				
+			for (int b = 0; b < (int)blocks.size(); b++) {
+				const IRInstr& last = IR[blocks[b].end - 1];
+				
+				if (last.op == IF_GT || last.op == Goto)
+					addEdge(b, labelBlock.at(last.dst));
+					
+				if (last.op != Goto && last.op != RET && b + 1 < (int)blocks.size())
+					addEdge(b, b + 1);
+			}
+		}
+		
+		void addEdge(int from, int to) {
+			if (to < 0)
+				return;
+				
+			blocks[from].succs.push_back(to);
+			blocks[to].preds.push_back(from);
+		}
+};
+
+// 活跃变量分析：每个基本块入口/出口处活跃的寄存器集合（按位存储），逆向迭代到不动点
+class Liveness {
+		size_t words; // 每个集合占用的64位字数
+		vector<uint64_t> in;
+		vector<uint64_t> out;
+		
+		static void set(uint64_t* bits, int reg) {
+			bits[reg >> 6] |= 1ull << (reg & 63);
+		}
+		
+	public:
+		Liveness(const vector<IRInstr>& IR, const CFG& cfg) : words((cfg.regCount + 63) / 64) {
+			size_t blockCount = cfg.blocks.size();
+			vector<uint64_t> use(blockCount * words, 0), def(blockCount * words, 0);
+			in.assign(blockCount * words, 0);
+			out.assign(blockCount * words, 0);
+			
+			// 每个块的use（先读后写的寄存器）和def集合
+			for (size_t b = 0; b < blockCount; b++) {
+				uint64_t* blockUse = use.data() + b * words;
+				uint64_t* blockDef = def.data() + b * words;
+				
+				for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+					int uses[2];
+					int count = irUses(IR[i], uses);
+					
+					for (int k = 0; k < count; k++) {
+						if (!(blockDef[uses[k] >> 6] >> (uses[k] & 63) & 1))
+							set(blockUse, uses[k]);
+					}
+					
+					int d = irDef(IR[i]);
+					
+					if (d >= 0)
+						set(blockDef, d);
+				}
+			}
+			
+			// out[b] = ∪ in[succ]，in[b] = use[b] ∪ (out[b] - def[b])；逆序遍历收敛更快
+			bool changed = true;
+			
+			while (changed) {
+				changed = false;
+				
+				for (size_t b = blockCount; b > 0; b--) {
+					size_t index = b - 1;
+					uint64_t* blockOut = out.data() + index * words;
+					uint64_t* blockIn = in.data() + index * words;
+					
+					for (int succ : cfg.blocks[index].succs) {
+						for (size_t w = 0; w < words; w++) {
+							blockOut[w] |= in[succ * words + w];
+						}
+					}
+					
+					for (size_t w = 0; w < words; w++) {
+						uint64_t value = use[index * words + w] | (blockOut[w] & ~def[index * words + w]);
+						
+						if (value != blockIn[w]) {
+							blockIn[w] = value;
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+		
+		bool liveIn(int block, int reg) const {
+			return in[block * words + (reg >> 6)] >> (reg & 63) & 1;
+		}
+		
+		bool liveOut(int block, int reg) const {
+			return out[block * words + (reg >> 6)] >> (reg & 63) & 1;
+		}
+		
+		// 对块出口处活跃的每个寄存器调用f
+		template<typename F>
+		void forEachLiveOut(int block, F f) const {
+			forEach(out.data() + block * words, f);
+		}
+		
+		template<typename F>
+		void forEachLiveIn(int block, F f) const {
+			forEach(in.data() + block * words, f);
+		}
+		
+	private:
+		template<typename F>
+		void forEach(const uint64_t* bits, F f) const {
+			for (size_t w = 0; w < words; w++) {
+				for (uint64_t word = bits[w]; word; word &= word - 1) {
+					f((int)(w * 64 + countr_zero(word)));
+				}
+			}
+		}
+};
+
+// 支配树（Cooper-Harvey-Kennedy迭代算法）。Blocks为带succs/preds的基本块数组，blocks[0]为入口
+// 不可达的块不参与计算：idom为-1，reachable()为false
+class DominatorTree {
+	public:
+		vector<int> idom; // 直接支配者，入口和不可达块为-1
+		vector<int> rpo; // 可达块的逆后序
+		vector<int> rpoIndex; // 块 -> 在rpo中的位置，-1表示不可达
+		vector<vector<int>> children; // 支配树上的子节点
+		
+		template<typename Blocks>
+		DominatorTree(const Blocks& blocks) {
+			int count = (int)blocks.size();
+			idom.assign(count, -1);
+			rpoIndex.assign(count, -1);
+			children.assign(count, {});
+			
+			if (count == 0)
+				return;
+				
+			// 非递归DFS求后序
+			vector<char> visited(count, 0);
+			vector<pair<int, size_t>> stack = {{0, 0}};
+			visited[0] = 1;
+			
+			while (!stack.empty()) {
+				auto& [block, next] = stack.back();
+				
+				if (next < blocks[block].succs.size()) {
+					int succ = blocks[block].succs[next++];
+					
+					if (!visited[succ]) {
+						visited[succ] = 1;
+						stack.push_back({succ, 0});
+					}
+				}
+				else {
+					rpo.push_back(block);
+					stack.pop_back();
+				}
+			}
+			
+			reverse(rpo.begin(), rpo.end());
+			
+			for (int i = 0; i < (int)rpo.size(); i++) {
+				rpoIndex[rpo[i]] = i;
+			}
+			
+			// 按逆后序迭代：idom[b] = 所有已处理前驱的最近公共支配者
+			idom[0] = 0;
+			bool changed = true;
+			
+			while (changed) {
+				changed = false;
+				
+				for (size_t i = 1; i < rpo.size(); i++) {
+					int block = rpo[i];
+					int newIdom = -1;
+					
+					for (int pred : blocks[block].preds) {
+						if (rpoIndex[pred] < 0 || idom[pred] < 0)
+							continue;
+							
+						newIdom = newIdom < 0 ? pred : intersect(pred, newIdom);
+					}
+					
+					if (newIdom != idom[block]) {
+						idom[block] = newIdom;
+						changed = true;
+					}
+				}
+			}
+			
+			idom[0] = -1;
+			
+			for (size_t i = 1; i < rpo.size(); i++) {
+				children[idom[rpo[i]]].push_back(rpo[i]);
+			}
+			
+			// 支配树的先序/后序编号，dominates()据此O(1)判断
+			enter.assign(count, -1);
+			leave.assign(count, -1);
+			int clock = 0;
+			vector<pair<int, size_t>> walk = {{0, 0}};
+			enter[0] = clock++;
+			
+			while (!walk.empty()) {
+				auto& [block, next] = walk.back();
+				
+				if (next < children[block].size()) {
+					int child = children[block][next++];
+					enter[child] = clock++;
+					walk.push_back({child, 0});
+				}
+				else {
+					leave[block] = clock++;
+					walk.pop_back();
+				}
+			}
+		}
+		
+		bool reachable(int block) const {
+			return rpoIndex[block] >= 0;
+		}
+		
+		// a是否支配b（每个块都支配自己）
+		bool dominates(int a, int b) const {
+			return reachable(a) && reachable(b) && enter[a] <= enter[b] && leave[b] <= leave[a];
+		}
+		
+		// 支配边界：frontier[x]为x支配某个前驱、但不严格支配的块
+		template<typename Blocks>
+		vector<vector<int>> frontiers(const Blocks& blocks) const {
+			vector<vector<int>> frontier(blocks.size());
+			
+			for (int block : rpo) {
+				if (blocks[block].preds.size() < 2)
+					continue;
+					
+				for (int pred : blocks[block].preds) {
+					for (int runner = pred; runner >= 0 && reachable(runner) && runner != idom[block]; runner = idom[runner]) {
+						if (frontier[runner].empty() || frontier[runner].back() != block)
+							frontier[runner].push_back(block);
+					}
+				}
+			}
+			
+			return frontier;
+		}
+		
+	private:
+		vector<int> enter;
+		vector<int> leave;
+		
+		int intersect(int a, int b) const {
+			while (a != b) {
+				while (rpoIndex[a] > rpoIndex[b]) {
+					a = idom[a];
+				}
+				
+				while (rpoIndex[b] > rpoIndex[a]) {
+					b = idom[b];
+				}
+			}
+			
+			return a;
+		}
+};
+
+// 自然循环：回边latch->header（header支配latch）确定的循环，循环体为不经过header就能到达latch的块
+// 同一个header的多条回边合并为一个循环
+struct NaturalLoop {
+	int header;
+	vector<int> latches;
+	vector<int> blocks; // 含header，按编号排序
+	int parent; // 直接外层循环的下标，-1表示最外层
+	int depth; // 最外层为1
+	bool innermost; // 不含其他循环
+	
+	bool contains(int block) const {
+		return binary_search(blocks.begin(), blocks.end(), block);
+	}
+};
+
+// 找出所有自然循环，按header在逆后序中的位置排列：外层循环总在它包含的循环之前
+template<typename Blocks>
+vector<NaturalLoop> findLoops(const Blocks& blocks, const DominatorTree& dom) {
+	vector<NaturalLoop> loops;
+	
+	for (int header : dom.rpo) {
+		NaturalLoop loop = {header, {}, {}, -1, 1, true};
+		
+		for (int pred : blocks[header].preds) {
+			if (dom.dominates(header, pred))
+				loop.latches.push_back(pred);
+		}
+		
+		if (loop.latches.empty())
+			continue;
+			
+		// 从latch沿前驱反向搜索，遇到header停止
+		vector<char> inLoop(blocks.size(), 0);
+		vector<int> work = loop.latches;
+		inLoop[header] = 1;
+		loop.blocks.push_back(header);
+		
+		for (int latch : loop.latches) {
+			if (!inLoop[latch]) {
+				inLoop[latch] = 1;
+				loop.blocks.push_back(latch);
+			}
+		}
+		
+		while (!work.empty()) {
+			int block = work.back();
+			work.pop_back();
+			
+			if (block == header)
+				continue;
+				
+			for (int pred : blocks[block].preds) {
+				if (!inLoop[pred] && dom.reachable(pred)) {
+					inLoop[pred] = 1;
+					loop.blocks.push_back(pred);
+					work.push_back(pred);
+				}
+			}
+		}
+		
+		sort(loop.blocks.begin(), loop.blocks.end());
+		
+		// 外层循环的header支配内层循环的header，已经排在前面；最近的一个包含本header的循环就是直接外层
+		for (int outer = (int)loops.size() - 1; outer >= 0; outer--) {
+			if (loops[outer].contains(header)) {
+				loop.parent = outer;
+				loop.depth = loops[outer].depth + 1;
+				loops[outer].innermost = false;
+				break;
+			}
+		}
+		
+		loops.push_back(move(loop));
+	}
+	
+	return loops;
+}
+
+#endif /*IR_CFG_H*/
@@ -1,5 +1,627 @@
+#ifndef IR_H
+#define IR_H
+
+#include<stdexcept>
+#include<string>
+#include<vector>
 #include"./IRbase.h"
 #include"../AST/ASTnode.h"
+using namespace std;
+
+// 十进制字面量，超出int范围时按32位回绕
+int literalValue(Symbol value) {
+	uint32_t result = 0;
+	
+	for (char c : symbolName(value)) {
+		result = result * 10 + (uint32_t)(c - '0');
+	}
+	
+	return (int)result;
+}
+
+// 把AST中的运算符符号映射为IR操作符
+IROp irBinaryOp(Symbol op) {
+	switch (op) {
+		case SYM_ADD:
+			return ADD;
+			
+		case SYM_SUB:
+			return SUB;
+			
+		case SYM_MUL:
+			return MUL;
+			
+		case SYM_DIV:
+			return DIV;
+			
+		case SYM_EQ:
+			return EQ;
+			
+		case SYM_NE:
+			return NE;
+			
+		case SYM_LT:
+			return LT;
+			
+		case SYM_LE:
+			return LE;
+			
+		case SYM_GT:
+			return GT;
+			
+		case SYM_GE:
+			return GE;
+			
+		default:
+			throw runtime_error("Unsupported operator: " + string(symbolName(op)));
+	}
+}
+
+// AST -> 三地址码：局部变量和临时值都是虚拟寄存器，标签在每个函数内从0编号
+// 名字解析用按Symbol编号索引的数组，作用域退出时按撤销栈恢复被遮蔽的绑定
+class IRBuilder {
+		vector<IRInstr> code;
+		int regCount; // 当前函数已分配的寄存器数
+		int labelCount; // 当前函数已分配的标签数
+		int scopeDepth;
+		
+		vector<int> localReg; // 变量名 -> 寄存器，-1表示不是局部变量
+		vector<int> localDepth; // 变量名 -> 绑定所在的作用域深度
+		
+		struct Binding {
+			Symbol name;
+			int reg;
+			int depth;
+		};
+		
+		vector<Binding> shadowed; // 撤销栈：每次声明前的旧绑定
+		vector<size_t> scopeStarts; // 每个作用域在撤销栈中的起点
+		
+		vector<int> globalIndex; // 变量名 -> 全局变量编号，-1表示没有
+		vector<int> arrayIndex; // 数组名 -> 数组编号，-1表示没有
+		vector<int> functionParams; // 函数名 -> 形参个数，-1表示没有
+		
+		// 表达式后序遍历的显式栈，避免深层嵌套的表达式耗尽调用栈
+		struct ExprFrame {
+			Expression* expr;
+			bool expanded; // 操作数是否已入栈
+		};
+		
+		vector<ExprFrame> exprStack;
+		vector<int> valueStack; // 已求值操作数所在的寄存器
+		
+		// 条件跳转代码的工作项：label >= 0时放置标签，否则按expr的真假跳到trueLabel/falseLabel
+		struct CondItem {
+			Expression* expr;
+			int trueLabel;
+			int falseLabel;
+			int label;
+		};
+		
+		vector<CondItem> condStack;
+		
+		void emit(IROp op, int dst, int a = -1, int b = -1) {
+			code.push_back({op, dst, a, b});
+		}
+		
+		int newReg() {
+			return regCount++;
+		}
+		
+		int newLabel() {
+			return labelCount++;
+		}
+		
+		int emitConst(int value) {
+			int reg = newReg();
+			emit(CONST, reg, value);
+			return reg;
+		}
+		
+		void enterScope() {
+			scopeStarts.push_back(shadowed.size());
+			scopeDepth++;
+		}
+		
+		void leaveScope() {
+			size_t start = scopeStarts.back();
+			scopeStarts.pop_back();
+			
+			while (shadowed.size() > start) {
+				Binding binding = shadowed.back();
+				shadowed.pop_back();
+				localReg[binding.name] = binding.reg;
+				localDepth[binding.name] = binding.depth;
+			}
+			
+			scopeDepth--;
+		}
+		
+		void declareLocal(Symbol name, int reg) {
+			if (localReg[name] != -1 && localDepth[name] == scopeDepth) {
+				throw runtime_error("Redefinition of variable: " + string(symbolName(name)));
+			}
+			
+			shadowed.push_back({name, localReg[name], localDepth[name]});
+			localReg[name] = reg;
+			localDepth[name] = scopeDepth;
+		}
+		
+		static bool isLogical(Expression* expr) {
+			return expr->exprType == Expression::BINARY_OPERATOR && (expr->value == SYM_AND || expr->value == SYM_OR);
+		}
+		
+		// 读取变量：局部变量直接使用其寄存器，全局变量先LOADG到临时寄存器
+		int loadVariable(Symbol name) {
+			if (localReg[name] != -1)
+				return localReg[name];
+				
+			if (globalIndex[name] != -1) {
+				int reg = newReg();
+				emit(LOADG, reg, globalIndex[name]);
+				return reg;
+			}
+			
+			throw runtime_error("Undefined variable: " + string(symbolName(name)));
+		}
+		
+		// 数组只能是全局的，不会被局部变量遮蔽
+		int findArray(Symbol name) {
+			if (arrayIndex[name] == -1)
+				throw runtime_error("Undefined array: " + string(symbolName(name)));
+				
+			return arrayIndex[name];
+		}
+		
+		// 所有操作数都已求值后，为单个表达式节点生成代码，返回结果寄存器
+		int lowerNode(Expression* expr) {
+			switch (expr->exprType) {
+				case Expression::LITERAL:
+					return emitConst(literalValue(expr->value));
+					
+				case Expression::IDENTIFIER:
+					return loadVariable(expr->value);
+					
+				case Expression::FUNC_CALL: {
+						FunctionCall* call = static_cast<FunctionCall*>(expr);
+						int argc = (int)call->parameters.size();
+						
+						if (functionParams[call->funcName] == -1) {
+							throw runtime_error("Undefined function: " + string(symbolName(call->funcName)));
+						}
+						
+						if (functionParams[call->funcName] != argc) {
+							throw runtime_error("Wrong number of arguments in call to " + string(symbolName(call->funcName)));
+						}
+						
+						// 实参全部求值后再连续传递，嵌套调用的ARG不会交错
+						size_t first = valueStack.size() - argc;
+						
+						for (size_t i = first; i < valueStack.size(); i++) {
+							emit(ARG, -1, valueStack[i]);
+						}
+						
+						valueStack.resize(first);
+						int reg = newReg();
+						emit(CALL, reg, call->funcName, argc);
+						return reg;
+					}
+					
+				case Expression::ARRAY_ELEMENT: {
+						int index = valueStack.back();
+						valueStack.pop_back();
+						int reg = newReg();
+						emit(LOADA, reg, index, findArray(expr->value));
+						return reg;
+					}
+					
+				case Expression::BINARY_OPERATOR: {
+						if (isLogical(expr))
+							return lowerLogicalValue(expr);
+							
+						int right = valueStack.back();
+						valueStack.pop_back();
+						int reg = newReg();
+						
+						if (expr->value == SYM_NOT) {
+							emit(NOT, reg, right);
+							return reg;
+						}
+						
+						int left = valueStack.back();
+						valueStack.pop_back();
+						emit(irBinaryOp(expr->value), reg, left, right);
+						return reg;
+					}
+					
+				default:
+					throw runtime_error("Increment and array assignment are only allowed as statements");
+			}
+		}
+		
+		// 求表达式的值（后序遍历，不递归），返回结果寄存器
+		int lowerExpression(Expression* root) {
+			size_t base = exprStack.size();
+			size_t valueBase = valueStack.size();
+			exprStack.push_back({root, false});
+			
+			while (exprStack.size() > base) {
+				ExprFrame frame = exprStack.back();
+				Expression* expr = frame.expr;
+				
+				if (!frame.expanded) {
+					exprStack.back().expanded = true;
+					
+					if (expr->exprType == Expression::FUNC_CALL) {
+						NodeList<Expression*> params = static_cast<FunctionCall*>(expr)->parameters;
+						
+						for (size_t i = params.size(); i > 0; i--) {
+							exprStack.push_back({params[i - 1], false});
+						}
+						
+						continue;
+					}
+					
+					if (expr->exprType == Expression::ARRAY_ELEMENT) {
+						exprStack.push_back({expr->left, false});
+						continue;
+					}
+					
+					if (expr->exprType == Expression::BINARY_OPERATOR && !isLogical(expr)) {
+						exprStack.push_back({expr->right, false});
+						
+						if (expr->left)
+							exprStack.push_back({expr->left, false});
+							
+						continue;
+					}
+				}
+				
+				exprStack.pop_back();
+				valueStack.push_back(lowerNode(expr));
+			}
+			
+			int result = valueStack.back();
+			valueStack.resize(valueBase);
+			return result;
+		}
+		
+		// &&、||作为值使用时，先生成跳转代码，再在两个出口分别写入1和0
+		int lowerLogicalValue(Expression* expr) {
+			int reg = newReg();
+			int trueLabel = newLabel(), falseLabel = newLabel(), endLabel = newLabel();
+			lowerCondition(expr, trueLabel, falseLabel);
+			emit(LABEL, trueLabel);
+			emit(CONST, reg, 1);
+			emit(Goto, endLabel);
+			emit(LABEL, falseLabel);
+			emit(CONST, reg, 0);
+			emit(LABEL, endLabel);
+			return reg;
+		}
+		
+		// 生成条件跳转：cond为真时跳到trueLabel，否则跳到falseLabel
+		// &&、||短路求值，!交换两个出口；> < >= <= 直接比较两侧，其余的值与0比较
+		void lowerCondition(Expression* cond, int trueLabel, int falseLabel) {
+			size_t base = condStack.size();
+			condStack.push_back({cond, trueLabel, falseLabel, -1});
+			
+			while (condStack.size() > base) {
+				CondItem item = condStack.back();
+				condStack.pop_back();
+				
+				if (item.label >= 0) {
+					emit(LABEL, item.label);
+					continue;
+				}
+				
+				Expression* expr = item.expr;
+				Symbol op = expr->exprType == Expression::BINARY_OPERATOR ? expr->value : (Symbol)PREDEFINED_SYMBOL_COUNT;
+				
+				if (op == SYM_AND || op == SYM_OR) {
+					int middle = newLabel();
+					// 逆序入栈：先处理左侧，再放置middle，最后处理右侧
+					condStack.push_back({expr->right, item.trueLabel, item.falseLabel, -1});
+					condStack.push_back({nullptr, -1, -1, middle});
+					
+					if (op == SYM_AND)
+						condStack.push_back({expr->left, middle, item.falseLabel, -1});
+					else
+						condStack.push_back({expr->left, item.trueLabel, middle, -1});
+						
+					continue;
+				}
+				
+				if (op == SYM_NOT) {
+					condStack.push_back({expr->right, item.falseLabel, item.trueLabel, -1});
+					continue;
+				}
+				
+				if (op == SYM_GT || op == SYM_LT || op == SYM_GE || op == SYM_LE) {
+					int left = lowerExpression(expr->left);
+					int right = lowerExpression(expr->right);
+					
+					if (op == SYM_GT) {
+						emit(IF_GT, item.trueLabel, left, right);
+						emit(Goto, item.falseLabel);
+					}
+					else if (op == SYM_LT) {
+						emit(IF_GT, item.trueLabel, right, left);
+						emit(Goto, item.falseLabel);
+					}
+					else if (op == SYM_GE) { // a >= b 即 !(b > a)
+						emit(IF_GT, item.falseLabel, right, left);
+						emit(Goto, item.trueLabel);
+					}
+					else { // a <= b 即 !(a > b)
+						emit(IF_GT, item.falseLabel, left, right);
+						emit(Goto, item.trueLabel);
+					}
+					
+					continue;
+				}
+				
+				int value = lowerExpression(expr);
+				int zero = emitConst(0);
+				
+				if (op != SYM_EQ && op != SYM_NE) { // 比较结果已是0/1，其余的值先归一化
+					int flag = newReg();
+					emit(NE, flag, value, zero);
+					value = flag;
+				}
+				
+				emit(IF_GT, item.trueLabel, value, zero);
+				emit(Goto, item.falseLabel);
+			}
+		}
+		
+		// i++：局部变量原地自增，全局变量读-改-写
+		void lowerIncrement(Expression* expr) {
+			Symbol name = expr->operand->value;
+			
+			if (localReg[name] != -1) {
+				emit(INC, localReg[name], localReg[name]);
+				return;
+			}
+			
+			int reg = loadVariable(name);
+			emit(INC, reg, reg);
+			emit(STOREG, globalIndex[name], reg);
+		}
+		
+		// a[i] = x：先求下标再求新值
+		void lowerArrayAssign(Expression* expr) {
+			int array = findArray(expr->value);
+			int index = lowerExpression(expr->left);
+			int value = lowerExpression(expr->right);
+			emit(STOREA, array, index, value);
+		}
+		
+		void lowerVariableDeclaration(VariableDeclaration* var) {
+			if (var->arraySize) {
+				throw runtime_error("Arrays are only allowed at top level: " + string(symbolName(var->varName)));
+			}
+			
+			int reg = newReg();
+			
+			if (var->initExpr) {
+				int value = lowerExpression(var->initExpr); // 先求初值再声明，初值中的同名变量指外层
+				emit(ASSIGN, reg, value);
+			}
+			else {
+				emit(CONST, reg, 0);
+			}
+			
+			declareLocal(var->varName, reg);
+		}
+		
+		void lowerStatement(ASTBaseNode* node) {
+			if (!node)
+				return;
+				
+			switch (node->getNodeType()) {
+				case ASTBaseNode::STMT_BLOCK:
+					enterScope();
+					
+					for (ASTBaseNode* child : node->getAllChildren()) {
+						lowerStatement(child);
+					}
+					
+					leaveScope();
+					break;
+					
+				case ASTBaseNode::STATEMENT: {
+						Statement* stmt = static_cast<Statement*>(node);
+						
+						if (stmt->getStmtType() != Statement::RETURN)
+							break;
+							
+						NodeList<ASTBaseNode*> children = stmt->getAllChildren();
+						int value = children.empty() ? emitConst(0) : lowerExpression(static_cast<Expression*>(children[0]));
+						emit(RET, -1, value);
+						break;
+					}
+					
+				case ASTBaseNode::VAR_DECL:
+					lowerVariableDeclaration(static_cast<VariableDeclaration*>(node));
+					break;
+					
+				case ASTBaseNode::EXPRESSION: {
+						Expression* expr = static_cast<Expression*>(node);
+						
+						if (expr->exprType == Expression::UNARY_OPERATOR)
+							lowerIncrement(expr);
+						else if (expr->exprType == Expression::ARRAY_ASSIGN)
+							lowerArrayAssign(expr);
+						else
+							lowerExpression(expr); // 结果不使用（如函数调用语句）
+							
+						break;
+					}
+					
+				case ASTBaseNode::IF_STATEMENT: {
+						IfStatement* ifStmt = static_cast<IfStatement*>(node);
+						int thenLabel = newLabel(), elseLabel = newLabel();
+						lowerCondition(ifStmt->condition, thenLabel, elseLabel);
+						emit(LABEL, thenLabel);
+						lowerStatement(ifStmt->thenBlock);
+						
+						if (ifStmt->elseBlock) {
+							int endLabel = newLabel();
+							emit(Goto, endLabel);
+							emit(LABEL, elseLabel);
+							lowerStatement(ifStmt->elseBlock);
+							emit(LABEL, endLabel);
+						}
+						else {
+							emit(LABEL, elseLabel);
+						}
+						
+						break;
+					}
+					
+				case ASTBaseNode::FOR_STATEMENT: {
+						ForStatement* forStmt = static_cast<ForStatement*>(node);
+						int condLabel = newLabel(), bodyLabel = newLabel(), endLabel = newLabel();
+						enterScope(); // 初始化语句中声明的变量只在循环内可见
+						lowerStatement(forStmt->initStmt);
+						emit(LABEL, condLabel);
+						lowerCondition(forStmt->condition, bodyLabel, endLabel);
+						emit(LABEL, bodyLabel);
+						lowerStatement(forStmt->body);
+						lowerStatement(forStmt->updateStmt);
+						emit(Goto, condLabel);
+						emit(LABEL, endLabel);
+						leaveScope();
+						break;
+					}
+					
+				default:
+					throw runtime_error("Function declarations are only allowed at top level");
+			}
+		}
+		
+		// 开始一个函数：重置寄存器和标签编号，返回FUNC指令的位置（结束时回填寄存器数）
+		size_t beginFunction(Symbol name, int paramCount) {
+			regCount = paramCount;
+			labelCount = 0;
+			code.push_back({FUNC, 0, (int)name, paramCount});
+			return code.size() - 1;
+		}
+		
+		// 函数末尾没有return时补上return 0
+		void endFunction(size_t header) {
+			if (code.back().op != RET) {
+				emit(RET, -1, emitConst(0));
+			}
+			
+			code[header].dst = regCount;
+		}
+		
+		void lowerFunction(FunctionDeclaration* func) {
+			size_t header = beginFunction(func->funcName, (int)func->parameters.size());
+			enterScope();
+			
+			for (size_t i = 0; i < func->parameters.size(); i++) {
+				declareLocal(func->parameters[i].second, (int)i);
+			}
+			
+			for (ASTBaseNode* body : func->getAllChildren()) {
+				lowerStatement(body);
+			}
+			
+			leaveScope();
+			endFunction(header);
+		}
+		
+	public:
+		IRBuilder() : regCount(0), labelCount(0), scopeDepth(0) {}
+		
+		vector<IRInstr> build(ASTBaseNode* root) {
+			Symbol topName = SymbolTable.intern(TOP_LEVEL_NAME);
+			size_t symbolCount = SymbolTable.size();
+			localReg.assign(symbolCount, -1);
+			localDepth.assign(symbolCount, -1);
+			globalIndex.assign(symbolCount, -1);
+			arrayIndex.assign(symbolCount, -1);
+			functionParams.assign(symbolCount, -1);
+			code.clear();
+			
+			NodeList<ASTBaseNode*> topLevel = root->getAllChildren();
+			int globalCount = 0, arrayCount = 0;
+			
+			// 先登记所有全局变量、数组和函数，函数体中可以引用在其后声明的名字
+			for (ASTBaseNode* node : topLevel) {
+				if (node->getNodeType() == ASTBaseNode::VAR_DECL) {
+					VariableDeclaration* var = static_cast<VariableDeclaration*>(node);
+					Symbol name = var->varName;
+					
+					if (globalIndex[name] != -1 || arrayIndex[name] != -1) {
+						throw runtime_error("Redefinition of variable: " + string(symbolName(name)));
+					}
+					
+					if (var->arraySize) {
+						int length = literalValue(var->arraySize->value);
+						
+						if (length <= 0) {
+							throw runtime_error("Invalid array size: " + string(symbolName(name)));
+						}
+						
+						arrayIndex[name] = arrayCount;
+						emit(ARRAY, arrayCount++, name, length);
+						continue;
+					}
+					
+					globalIndex[name] = globalCount;
+					emit(GLOBAL, globalCount++, name);
+				}
+				else if (node->getNodeType() == ASTBaseNode::FUNC_DECL) {
+					FunctionDeclaration* func = static_cast<FunctionDeclaration*>(node);
+					
+					if (functionParams[func->funcName] != -1) {
+						throw runtime_error("Redefinition of function: " + string(symbolName(func->funcName)));
+					}
+					
+					functionParams[func->funcName] = (int)func->parameters.size();
+				}
+			}
+			
+			// 顶层语句按出现顺序组成一个无参函数，全局变量的初始化也在其中执行
+			size_t header = beginFunction(topName, 0);
+			enterScope();
+			
+			for (ASTBaseNode* node : topLevel) {
+				if (node->getNodeType() == ASTBaseNode::FUNC_DECL)
+					continue;
+					
+				if (node->getNodeType() == ASTBaseNode::VAR_DECL) {
+					VariableDeclaration* var = static_cast<VariableDeclaration*>(node);
+					
+					if (var->initExpr) {
+						emit(STOREG, globalIndex[var->varName], lowerExpression(var->initExpr));
+					}
+				}
+				else {
+					lowerStatement(node);
+				}
+			}
+			
+			leaveScope();
+			endFunction(header);
+			
+			for (ASTBaseNode* node : topLevel) {
+				if (node->getNodeType() == ASTBaseNode::FUNC_DECL) {
+					lowerFunction(static_cast<FunctionDeclaration*>(node));
+				}
+			}
+			
+			return std::move(code);
+		}
+};
 
 vector<IRInstr> getIRFromAST(ASTBaseNode* ASTRoot) {
+	IRBuilder builder;
+	return builder.build(ASTRoot);
 }
+
+#endif /*IR_H*/
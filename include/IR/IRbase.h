@@ -1,13 +1,30 @@
 #ifndef IR_BASE_H
 #define IR_BASE_H
 
+#include<cstdint>
 #include<string>
 #include<string.h>
+#include<string_view>
 #include<vector>
-#include<string>
-#include<unordered_map>
 using namespace std;
 
+// 三地址码操作符。每条指令的字段含义（r=虚拟寄存器，L=标签，g=全局变量编号，sym=驻留符号）：
+//   ADD/SUB/MUL/DIV/EQ/NE/LT/LE/GT/GE  r[dst] = r[a] op r[b]（比较结果为0或1）
+//   ASSIGN  r[dst] = r[a]          INC    r[dst] = r[a] + 1
+//   CONST   r[dst] = a（立即数）    NOT    r[dst] = !r[a]
+//   IF_GT   if (r[a] > r[b]) goto L[dst]          Goto  goto L[dst]
+//   LABEL   L[dst]:
+//   ARG     把r[a]作为下一个实参            CALL  r[dst] = sym[a](最近的b个ARG)
+//   RET     return r[a]
+//   FUNC    函数开始：dst=虚拟寄存器个数，a=函数名sym，b=形参个数（形参依次位于r0..r[b-1]）
+//   GLOBAL  全局变量声明：dst=g，a=变量名sym
+//   LOADG   r[dst] = g[a]                  STOREG g[dst] = r[a]
+//   PHI     r[dst] = φ(...)，只出现在SSA形式中：参数依次为SSAFunction::phiArgs[a..a+b)，第k个对应所在块的第k个前驱
+//   ARRAY   全局数组声明：dst=数组编号A，a=数组名sym，b=长度（元素初值为0）
+//   LOADA   r[dst] = A[b][r[a]]            STOREA A[dst][r[a]] = r[b]（下标越界时报错）
+// 以下为向量指令，只由向量化生成。v是向量寄存器（与r分开编号，0..VECTOR_REGS-1），每个含VECTOR_WIDTH个int分量：
+//   VLOAD   v[dst] = A[b][r[a] .. r[a]+VECTOR_WIDTH)    VSTORE A[dst][r[a] .. r[a]+VECTOR_WIDTH) = v[b]
+//   VSPLAT  v[dst]的每个分量 = r[a]        VADD/VSUB/VMUL  v[dst] = v[a] op v[b]（逐分量，按32位回绕）
 enum IROp {
 	ADD, // +
 	SUB, // -
@@ -16,10 +33,39 @@ enum IROp {
 	ASSIGN, // 赋值
 	IF_GT, // if条件
 	Goto, // 转跳（用于FuncCall以及For和If）
-	INC // 自增 i++
+	INC, // 自增 i++
+	CONST, // 加载常量
+	EQ, // ==
+	NE, // !=
+	LT, // <
+	LE, // <=
+	GT, // >
+	GE, // >=
+	NOT, // !
+	LABEL, // 标签
+	ARG, // 传递实参
+	CALL, // 函数调用
+	RET, // 返回
+	FUNC, // 函数开始
+	GLOBAL, // 全局变量声明
+	LOADG, // 读全局变量
+	STOREG, // 写全局变量
+	PHI, // SSA形式中的φ函数
+	ARRAY, // 全局数组声明
+	LOADA, // 读数组元素
+	STOREA, // 写数组元素
+	VLOAD, // 读连续的VECTOR_WIDTH个数组元素
+	VSTORE, // 写连续的VECTOR_WIDTH个数组元素
+	VSPLAT, // 标量广播到向量的每个分量
+	VADD, // 逐分量 +
+	VSUB, // 逐分量 -
+	VMUL // 逐分量 *
 };
 
-string IROpToString[] = {
+constexpr int VECTOR_WIDTH = 8; // 向量的分量个数（x86上为一个ymm或两个xmm）
+constexpr int VECTOR_REGS = 7; // 一个函数内可用的向量寄存器个数
+
+const string IROpToString[] = {
 	"ADD",
 	"SUB",
 	"MUL",
@@ -27,14 +73,189 @@ string IROpToString[] = {
 	"ASSIGN",
 	"IF_GT",
 	"Goto",
-	"INC"
+	"INC",
+	"CONST",
+	"EQ",
+	"NE",
+	"LT",
+	"LE",
+	"GT",
+	"GE",
+	"NOT",
+	"LABEL",
+	"ARG",
+	"CALL",
+	"RET",
+	"FUNC",
+	"GLOBAL",
+	"LOADG",
+	"STOREG",
+	"PHI",
+	"ARRAY",
+	"LOADA",
+	"STOREA",
+	"VLOAD",
+	"VSTORE",
+	"VSPLAT",
+	"VADD",
+	"VSUB",
+	"VMUL"
 };
 
+// 定长指令：操作符 + 三个整数操作数，整个程序是一段连续的IRInstr数组
+// 依次为：所有GLOBAL和ARRAY，顶层语句组成的函数（名为TOP_LEVEL_NAME），再按声明顺序排列各个函数
 struct IRInstr {
 	IROp op; // 操作符
-	unordered_map<string, string> label; //label[标签名称]=标签的值
+	int dst; // 目标寄存器/标签（见IROp的说明）
+	int a; // 第一个操作数
+	int b; // 第二个操作数
 };
 
+static_assert(sizeof(IRInstr) == 16, "IRInstr is a fixed-width 16-byte record");
+
+const string_view TOP_LEVEL_NAME = "<top>"; // 词法分析不会产生的名字，避免和用户函数冲突
+
+// 指令写入的寄存器，没有则返回-1（向量寄存器不计入）
+int irDef(const IRInstr& instr) {
+	switch (instr.op) {
+		case IF_GT:
+		case Goto:
+		case LABEL:
+		case ARG:
+		case RET:
+		case FUNC:
+		case GLOBAL:
+		case STOREG:
+		case ARRAY:
+		case STOREA:
+		case VLOAD:
+		case VSTORE:
+		case VSPLAT:
+		case VADD:
+		case VSUB:
+		case VMUL:
+			return -1;
+			
+		default:
+			return instr.dst;
+	}
+}
+
+// 指令读取的寄存器依次写入uses，返回个数（uses[0]总是字段a，uses[1]总是字段b）
+// PHI的参数不在指令里，这里不计入，需要单独处理；向量寄存器也不计入
+int irUses(const IRInstr& instr, int uses[2]) {
+	switch (instr.op) {
+		case ADD:
+		case SUB:
+		case MUL:
+		case DIV:
+		case IF_GT:
+		case EQ:
+		case NE:
+		case LT:
+		case LE:
+		case GT:
+		case GE:
+		case STOREA:
+			uses[0] = instr.a;
+			uses[1] = instr.b;
+			return 2;
+			
+		case ASSIGN:
+		case INC:
+		case NOT:
+		case ARG:
+		case RET:
+		case STOREG:
+		case LOADA:
+		case VLOAD:
+		case VSTORE:
+		case VSPLAT:
+			uses[0] = instr.a;
+			return 1;
+			
+		default:
+			return 0;
+	}
+}
+
+// 常量求值，语义与虚拟机一致（按32位补码回绕）；除数为0等不能在编译期求值时返回false
+// 二元运算用a、b；ASSIGN/INC/NOT只用a
+bool irEvaluate(IROp op, int a, int b, int& result) {
+	uint32_t x = (uint32_t)a, y = (uint32_t)b;
+	
+	switch (op) {
+		case ADD:
+			result = (int)(x + y);
+			return true;
+			
+		case SUB:
+			result = (int)(x - y);
+			return true;
+			
+		case MUL:
+			result = (int)(x * y);
+			return true;
+			
+		case DIV:
+			if (b == 0)
+				return false;
+				
+			result = (int)(uint32_t)((int64_t)a / b);
+			return true;
+			
+		case EQ:
+			result = a == b;
+			return true;
+			
+		case NE:
+			result = a != b;
+			return true;
+			
+		case LT:
+			result = a < b;
+			return true;
+			
+		case LE:
+			result = a <= b;
+			return true;
+			
+		case GT:
+			result = a > b;
+			return true;
+			
+		case GE:
+			result = a >= b;
+			return true;
+			
+		case ASSIGN:
+			result = a;
+			return true;
+			
+		case INC:
+			result = (int)(x + 1);
+			return true;
+			
+		case NOT:
+			result = !a;
+			return true;
+			
+		default:
+			return false;
+	}
+}
+
+// 从begin处的FUNC开始，返回该函数最后一条指令之后的位置
+size_t irFunctionEnd(const vector<IRInstr>& IR, size_t begin) {
+	size_t end = begin + 1;
+	
+	while (end < IR.size() && IR[end].op != FUNC && IR[end].op != GLOBAL && IR[end].op != ARRAY) {
+		end++;
+	}
+	
+	return end;
+}
+
 template<typename _Tp>
 struct MyStack { //手写栈
 	vector<_Tp> stackContent;
@@ -1,3 +1,6 @@
+#ifndef IR_PRINTER_H
+#define IR_PRINTER_H
+
 #include<vector>
 #include<iostream>
 #include"./IRbase.h"
@@ -12,12 +15,106 @@ class IRprinter {
 			this->IR = IR;
 		}
 		
+		// 按IROp中约定的字段含义逐条打印，r=寄存器，L=标签，g=全局变量，A=数组，v=向量寄存器
 		void print() {
-			for (IRInstr i : IR) {
+			for (const IRInstr& i : IR) {
+				if (i.op != FUNC && i.op != GLOBAL && i.op != ARRAY) {
+					cout << "    ";
+				}
+				
 				cout << IROpToString[i.op] << ": ";
 				
-				for (pair<string, string> j : i.label) {
-					cout << "    " << j.first << " : " << j.second;
+				switch (i.op) {
+					case ADD:
+					case SUB:
+					case MUL:
+					case DIV:
+					case EQ:
+					case NE:
+					case LT:
+					case LE:
+					case GT:
+					case GE:
+						cout << "r" << i.dst << " = r" << i.a << ", r" << i.b;
+						break;
+						
+					case ASSIGN:
+					case INC:
+					case NOT:
+						cout << "r" << i.dst << " = r" << i.a;
+						break;
+						
+					case CONST:
+						cout << "r" << i.dst << " = " << i.a;
+						break;
+						
+					case IF_GT:
+						cout << "r" << i.a << " > r" << i.b << " goto L" << i.dst;
+						break;
+						
+					case Goto:
+					case LABEL:
+						cout << "L" << i.dst;
+						break;
+						
+					case ARG:
+					case RET:
+						cout << "r" << i.a;
+						break;
+						
+					case CALL:
+						cout << "r" << i.dst << " = " << symbolName(i.a) << " (" << i.b << " args)";
+						break;
+						
+					case FUNC:
+						cout << symbolName(i.a) << " (" << i.b << " params, " << i.dst << " regs)";
+						break;
+						
+					case GLOBAL:
+						cout << "g" << i.dst << " " << symbolName(i.a);
+						break;
+						
+					case LOADG:
+						cout << "r" << i.dst << " = g" << i.a;
+						break;
+						
+					case STOREG:
+						cout << "g" << i.dst << " = r" << i.a;
+						break;
+						
+					case PHI: // 参数在SSAFunction::phiArgs中
+						cout << "r" << i.dst << " = phi(" << i.b << " args at " << i.a << ")";
+						break;
+						
+					case ARRAY:
+						cout << "A" << i.dst << " " << symbolName(i.a) << "[" << i.b << "]";
+						break;
+						
+					case LOADA:
+						cout << "r" << i.dst << " = A" << i.b << "[r" << i.a << "]";
+						break;
+						
+					case STOREA:
+						cout << "A" << i.dst << "[r" << i.a << "] = r" << i.b;
+						break;
+						
+					case VLOAD:
+						cout << "v" << i.dst << " = A" << i.b << "[r" << i.a << "]";
+						break;
+						
+					case VSTORE:
+						cout << "A" << i.dst << "[r" << i.a << "] = v" << i.b;
+						break;
+						
+					case VSPLAT:
+						cout << "v" << i.dst << " = r" << i.a;
+						break;
+						
+					case VADD:
+					case VSUB:
+					case VMUL:
+						cout << "v" << i.dst << " = v" << i.a << ", v" << i.b;
+						break;
 				}
 				
 				cout << endl;
@@ -28,3 +125,5 @@ class IRprinter {
 		}
 		
 };
+
+#endif /*IR_PRINTER_H*/
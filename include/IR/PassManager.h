@@ -0,0 +1,174 @@
+#ifndef IR_PASS_MANAGER_H
+#define IR_PASS_MANAGER_H
+
+#include<cstdio>
+#include<functional>
+#include<iostream>
+#include<string>
+#include<vector>
+#include"./IRbase.h"
+#include"./SSA.h"
+#include"../CompileStats.h"
+using namespace std;
+
+// 按顺序执行一组优化pass，并统计每个pass的耗时、内存分配和删掉的指令数
+// 两种pass：程序级pass直接改写整段IR（如跨函数的分析）；函数级pass作用于单个函数的SSA形式
+// 连续的函数级pass共用一次SSA构造和退出：每个函数先toSSA，依次执行这些pass，再fromSSA
+class PassManager {
+		struct Pass {
+			string name;
+			function<void(vector<IRInstr>&)> programPass; // 二者恰有一个非空
+			function<void(SSAFunction&)> functionPass;
+			PhaseStats stats;
+			long long removed; // 累计删除的指令数（负数表示增加）
+		};
+		
+		vector<Pass> passes;
+		PhaseStats toSSAStats;
+		PhaseStats fromSSAStats;
+		size_t instrsBefore;
+		size_t instrsAfter;
+		bool verify; // 每个函数级pass之后检查SSA形式
+		
+		// 对IR中的每个函数执行passes[first, last)，它们都是函数级pass
+		void runFunctionPasses(vector<IRInstr>& IR, size_t first, size_t last) {
+			vector<IRInstr> result;
+			result.reserve(IR.size());
+			
+			for (size_t i = 0; i < IR.size();) {
+				if (IR[i].op != FUNC) {
+					result.push_back(IR[i++]);
+					continue;
+				}
+				
+				PhaseTimer toSSATimer(toSSAStats);
+				SSAFunction ssa = toSSA(IR, i);
+				toSSATimer.stop();
+				
+				for (size_t p = first; p < last; p++) {
+					size_t before = ssa.instructionCount();
+					PhaseTimer timer(passes[p].stats);
+					passes[p].functionPass(ssa);
+					timer.stop();
+					passes[p].removed += (long long)before - (long long)ssa.instructionCount();
+					
+					if (verify)
+						verifySSA(ssa);
+				}
+				
+				PhaseTimer fromSSATimer(fromSSAStats);
+				fromSSA(ssa, result);
+				fromSSATimer.stop();
+				i = irFunctionEnd(IR, i);
+			}
+			
+			IR.swap(result);
+		}
+		
+		static PhaseStats renamed(PhaseStats stats, const string& prefix) {
+			stats.name = prefix + stats.name;
+			return stats;
+		}
+		
+	public:
+		PassManager(bool verify = false) : toSSAStats("(to SSA)"), fromSSAStats("(from SSA)"), instrsBefore(0), instrsAfter(0),
+			verify(verify) {}
+			
+		void addProgramPass(const string& name, function<void(vector<IRInstr>&)> pass) {
+			passes.push_back({name, move(pass), nullptr, PhaseStats(name), 0});
+		}
+		
+		void addFunctionPass(const string& name, function<void(SSAFunction&)> pass) {
+			passes.push_back({name, nullptr, move(pass), PhaseStats(name), 0});
+		}
+		
+		size_t size() const {
+			return passes.size();
+		}
+		
+		void run(vector<IRInstr>& IR) {
+			instrsBefore = IR.size();
+			
+			for (size_t p = 0; p < passes.size();) {
+				if (passes[p].programPass) {
+					size_t before = IR.size();
+					PhaseTimer timer(passes[p].stats);
+					passes[p].programPass(IR);
+					timer.stop();
+					passes[p].removed += (long long)before - (long long)IR.size();
+					p++;
+					continue;
+				}
+				
+				size_t last = p;
+				
+				while (last < passes.size() && passes[last].functionPass) {
+					last++;
+				}
+				
+				runFunctionPasses(IR, p, last);
+				p = last;
+			}
+			
+			instrsAfter = IR.size();
+		}
+		
+		// 每个pass的累计耗时、占比及删掉的指令数，最后是IR指令数和字节数的变化
+		// 进出SSA本身也会增删指令（去掉标签、插入复制），所以各pass删除数之和不一定等于总的变化
+		void printTiming(ostream& os = cout) const {
+			double total = toSSAStats.ms + fromSSAStats.ms;
+			
+			for (const Pass& pass : passes) {
+				total += pass.stats.ms;
+			}
+			
+			char line[128];
+			auto row = [&](const string& name, double ms, const string& removed) {
+				snprintf(line, sizeof(line), "%-24s %10.3f ms %6.1f%% %10s\n", name.c_str(), ms, total > 0 ? ms * 100 / total : 0.0, removed.c_str());
+				os << line;
+			};
+			
+			snprintf(line, sizeof(line), "%-24s %13s %7s %10s\n", "pass", "time", "share", "removed");
+			os << line;
+			
+			if (toSSAStats.runs > 0)
+				row("(to SSA)", toSSAStats.ms, "");
+				
+			for (const Pass& pass : passes) {
+				row(pass.name, pass.stats.ms, to_string(pass.removed));
+			}
+			
+			if (fromSSAStats.runs > 0)
+				row("(from SSA)", fromSSAStats.ms, "");
+				
+			row("total", total, "");
+			long long removed = (long long)instrsBefore - (long long)instrsAfter;
+			os << "IR instructions: " << instrsBefore << " -> " << instrsAfter
+			   << " (removed " << removed << " instructions, " << removed * (long long)sizeof(IRInstr) << " bytes)" << endl;
+		}
+		
+		// 把各pass（以及进出SSA）的计量作为prefix下的子阶段加入stats，执行顺序即报告中的顺序
+		void reportTo(CompileStats& stats, const string& prefix) const {
+			if (toSSAStats.runs > 0)
+				stats.addPhase(renamed(toSSAStats, prefix));
+				
+			for (const Pass& pass : passes) {
+				stats.addPhase(renamed(pass.stats, prefix));
+			}
+			
+			if (fromSSAStats.runs > 0)
+				stats.addPhase(renamed(fromSSAStats, prefix));
+		}
+		
+		void resetTiming() {
+			toSSAStats = PhaseStats(toSSAStats.name);
+			fromSSAStats = PhaseStats(fromSSAStats.name);
+			
+			for (Pass& pass : passes) {
+				pass.stats = PhaseStats(pass.name);
+				pass.removed = 0;
+			}
+		}
+};
+
+#endif /*IR_PASS_MANAGER_H*/
@@ -0,0 +1,954 @@
+#ifndef IR_SSA_H
+#define IR_SSA_H
+
+#include<algorithm>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include"./IRbase.h"
+#include"./CFG.h"
+#include"../Symbol.h"
+using namespace std;
+
+// 把指令读取的寄存器（字段a/b）替换为f(原寄存器)
+template<typename F>
+void irRenameUses(IRInstr& instr, F f) {
+	int uses[2];
+	int count = irUses(instr, uses);
+	
+	if (count >= 1)
+		instr.a = f(instr.a);
+		
+	if (count >= 2)
+		instr.b = f(instr.b);
+}
+
+// SSA形式下的基本块。code中PHI在最前，末尾可能是IF_GT/Goto/RET
+// 控制流只由succs决定（跳转指令的dst在SSA形式中不使用）：
+//   IF_GT结尾：succs = {条件成立时的目标, 否则的目标}    Goto结尾：succs = {目标}
+//   RET结尾：succs为空    其他：succs = {下一个执行的块}
+// preds与每条PHI的参数一一对应
+struct SSABlock {
+	vector<IRInstr> code;
+	vector<int> succs;
+	vector<int> preds;
+};
+
+// 一个函数的SSA形式：每个寄存器只被定义一次，形参r0..r[b-1]和未定义就使用的寄存器视为在入口处定义
+class SSAFunction {
+	public:
+		IRInstr header; // 原FUNC指令（dst在退出SSA时重新计算）
+		int regCount;
+		vector<SSABlock> blocks; // blocks[0]为入口，没有前驱；顺序即退出SSA后的布局顺序
+		vector<int> phiArgs; // 所有PHI的参数
+		
+		int newReg() {
+			return regCount++;
+		}
+		
+		int& phiArg(const IRInstr& phi, int k) {
+			return phiArgs[phi.a + k];
+		}
+		
+		int paramCount() const {
+			return header.b;
+		}
+		
+		// 在块to中插入一条PHI，参数初始都为value
+		IRInstr& addPhi(int to, int dst, int value) {
+			SSABlock& block = blocks[to];
+			IRInstr phi = {PHI, dst, (int)phiArgs.size(), (int)block.preds.size()};
+			phiArgs.insert(phiArgs.end(), block.preds.size(), value);
+			size_t pos = 0;
+			
+			while (pos < block.code.size() && block.code[pos].op == PHI) {
+				pos++;
+			}
+			
+			return *block.code.insert(block.code.begin() + pos, phi);
+		}
+		
+		// 删除边from->to以及to中PHI对应的参数；from以IF_GT结尾时改为Goto或顺序执行
+		void removeEdge(int from, int to) {
+			SSABlock& source = blocks[from];
+			size_t s = 0;
+			
+			while (s < source.succs.size() && source.succs[s] != to) {
+				s++;
+			}
+			
+			if (s == source.succs.size())
+				return;
+				
+			if (!source.code.empty() && source.code.back().op == IF_GT) {
+				if (s == 0)
+					source.code.pop_back(); // 条件成立的一侧不可能执行：直接顺序执行到另一侧
+				else
+					source.code.back() = {Goto, 0, 0, 0};
+			}
+			
+			source.succs.erase(source.succs.begin() + s);
+			removePred(to, from);
+		}
+		
+		// 删除入口不可达的块，其余块重新编号（保持原有顺序）
+		void removeUnreachable() {
+			vector<char> reachable(blocks.size(), 0);
+			vector<int> work = {0};
+			reachable[0] = 1;
+			
+			while (!work.empty()) {
+				int block = work.back();
+				work.pop_back();
+				
+				for (int succ : blocks[block].succs) {
+					if (!reachable[succ]) {
+						reachable[succ] = 1;
+						work.push_back(succ);
+					}
+				}
+			}
+			
+			vector<int> index(blocks.size(), -1);
+			int count = 0;
+			
+			for (size_t b = 0; b < blocks.size(); b++) {
+				if (reachable[b])
+					index[b] = count++;
+			}
+			
+			if (count == (int)blocks.size())
+				return;
+				
+			for (size_t b = 0; b < blocks.size(); b++) {
+				if (!reachable[b])
+					continue;
+					
+				for (size_t k = blocks[b].preds.size(); k > 0; k--) {
+					if (!reachable[blocks[b].preds[k - 1]])
+						removePredAt((int)b, k - 1);
+				}
+			}
+			
+			vector<SSABlock> kept;
+			kept.reserve(count);
+			
+			for (size_t b = 0; b < blocks.size(); b++) {
+				if (!reachable[b])
+					continue;
+					
+				for (int& succ : blocks[b].succs) {
+					succ = index[succ];
+				}
+				
+				for (int& pred : blocks[b].preds) {
+					pred = index[pred];
+				}
+				
+				kept.push_back(move(blocks[b]));
+			}
+			
+			blocks = move(kept);
+		}
+		
+		// 按order重新排列块：order[新编号] = 原编号，须包含每个块恰好一次且入口保持在最前
+		void reorderBlocks(const vector<int>& order) {
+			vector<int> index(blocks.size());
+			
+			for (size_t k = 0; k < order.size(); k++) {
+				index[order[k]] = (int)k;
+			}
+			
+			vector<SSABlock> sorted;
+			sorted.reserve(blocks.size());
+			
+			for (int old : order) {
+				SSABlock& block = blocks[old];
+				
+				for (int& succ : block.succs) {
+					succ = index[succ];
+				}
+				
+				for (int& pred : block.preds) {
+					pred = index[pred];
+				}
+				
+				sorted.push_back(move(block));
+			}
+			
+			blocks = move(sorted);
+		}
+		
+		// 合并直线相连的块：b只有唯一后继s、s只有唯一前驱b时把s接到b后面（s中单参数的PHI变为ASSIGN）
+		// 被合并的块成为不可达块并被删除
+		void mergeBlocks() {
+			bool merged = false;
+			
+			for (int b = 0; b < (int)blocks.size(); b++) {
+				while (blocks[b].succs.size() == 1) {
+					int s = blocks[b].succs[0];
+					
+					if (s == b || s == 0 || blocks[s].preds.size() != 1)
+						break;
+						
+					vector<IRInstr>& code = blocks[b].code;
+					
+					if (!code.empty() && code.back().op == Goto)
+						code.pop_back();
+						
+					for (IRInstr instr : blocks[s].code) {
+						if (instr.op == PHI)
+							instr = {ASSIGN, instr.dst, phiArgs[instr.a], 0};
+							
+						code.push_back(instr);
+					}
+					
+					blocks[b].succs = move(blocks[s].succs);
+					blocks[s].succs.clear();
+					blocks[s].preds.clear();
+					blocks[s].code.clear();
+					
+					for (int succ : blocks[b].succs) {
+						for (int& pred : blocks[succ].preds) {
+							if (pred == s)
+								pred = b;
+						}
+					}
+					
+					merged = true;
+				}
+			}
+			
+			if (merged)
+				removeUnreachable();
+		}
+		
+		// 复制传播：删除ASSIGN和平凡的PHI（除自身外参数都相同），把使用处改为源寄存器
+		// SSA中源寄存器的定义支配复制指令，也就支配复制结果的所有使用处
+		void propagateCopies() {
+			vector<int> alias(regCount);
+			
+			for (int reg = 0; reg < regCount; reg++) {
+				alias[reg] = reg;
+			}
+			
+			auto find = [&](int reg) {
+				int root = reg;
+				
+				while (alias[root] != root) {
+					root = alias[root];
+				}
+				
+				while (alias[reg] != root) {
+					int next = alias[reg];
+					alias[reg] = root;
+					reg = next;
+				}
+				
+				return root;
+			};
+			
+			bool changed = true;
+			bool removed = false;
+			
+			while (changed) { // 删掉一条PHI可能使别的PHI变得平凡
+				changed = false;
+				
+				for (SSABlock& block : blocks) {
+					for (IRInstr& instr : block.code) {
+						int source = -1;
+						
+						if (instr.op == ASSIGN) {
+							source = find(instr.a);
+						}
+						else if (instr.op == PHI) {
+							for (int k = 0; k < instr.b && source != -2; k++) {
+								int arg = find(phiArgs[instr.a + k]);
+								
+								if (arg != instr.dst && arg != source)
+									source = source == -1 ? arg : -2;
+							}
+						}
+						
+						if (source < 0 || source == instr.dst)
+							continue;
+							
+						alias[instr.dst] = source;
+						instr.op = LABEL; // 标记删除
+						changed = removed = true;
+					}
+				}
+			}
+			
+			if (!removed)
+				return;
+				
+			for (SSABlock& block : blocks) {
+				size_t kept = 0;
+				
+				for (IRInstr& instr : block.code) {
+					if (instr.op == LABEL)
+						continue;
+						
+					if (instr.op == PHI) {
+						for (int k = 0; k < instr.b; k++) {
+							phiArgs[instr.a + k] = find(phiArgs[instr.a + k]);
+						}
+					}
+					else {
+						irRenameUses(instr, find);
+					}
+					
+					block.code[kept++] = instr;
+				}
+				
+				block.code.resize(kept);
+			}
+		}
+		
+		// 删除块to的第k个前驱以及PHI的第k个参数
+		void removePredAt(int to, size_t k) {
+			SSABlock& block = blocks[to];
+			
+			for (IRInstr& instr : block.code) {
+				if (instr.op != PHI)
+					break;
+					
+				for (int i = (int)k; i + 1 < instr.b; i++) {
+					phiArgs[instr.a + i] = phiArgs[instr.a + i + 1];
+				}
+				
+				instr.b--;
+			}
+			
+			block.preds.erase(block.preds.begin() + k);
+		}
+		
+		void removePred(int to, int from) {
+			for (size_t k = 0; k < blocks[to].preds.size(); k++) {
+				if (blocks[to].preds[k] == from) {
+					removePredAt(to, k);
+					return;
+				}
+			}
+		}
+		
+		size_t instructionCount() const {
+			size_t count = 0;
+			
+			for (const SSABlock& block : blocks) {
+				count += block.code.size();
+			}
+			
+			return count;
+		}
+};
+
+// 构造剪枝SSA：按支配边界放置PHI（只放在该寄存器入口活跃的块），再沿支配树重命名
+SSAFunction toSSA(const vector<IRInstr>& IR, size_t begin) {
+	CFG cfg(IR, begin);
+	Liveness live(IR, cfg);
+	SSAFunction function;
+	function.header = IR[begin];
+	function.regCount = cfg.regCount;
+	int original = cfg.regCount;
+	
+	// 入口块有前驱（函数一开始就是循环头）时补一个空的入口块，保证入口没有PHI
+	int shift = !cfg.blocks.empty() && !cfg.blocks[0].preds.empty() ? 1 : 0;
+	function.blocks.resize(cfg.blocks.size() + shift);
+	
+	if (shift)
+		function.blocks[0].succs = {1};
+		
+	for (size_t b = 0; b < cfg.blocks.size(); b++) {
+		SSABlock& block = function.blocks[b + shift];
+		const BasicBlock& source = cfg.blocks[b];
+		
+		if (b == 0 && shift)
+			block.preds.push_back(0);
+			
+		for (size_t i = source.begin; i < source.end; i++) {
+			if (IR[i].op != LABEL)
+				block.code.push_back(IR[i]);
+		}
+		
+		for (int succ : source.succs) {
+			block.succs.push_back(succ + shift);
+		}
+		
+		for (int pred : source.preds) {
+			block.preds.push_back(pred + shift);
+		}
+		
+		IROp last = block.code.empty() ? LABEL : block.code.back().op;
+		
+		if ((last == IF_GT && block.succs.size() != 2) || (last == Goto && block.succs.size() != 1) ||
+		        (last != IF_GT && last != Goto && last != RET && block.succs.size() != 1))
+			throw runtime_error("Malformed IR: bad control flow in " + string(symbolName(function.header.a)));
+	}
+	
+	DominatorTree dom(function.blocks);
+	vector<vector<int>> frontier = dom.frontiers(function.blocks);
+	int blockCount = (int)function.blocks.size();
+	
+	// 放置PHI：每个寄存器从它的定义块出发，沿支配边界迭代
+	vector<vector<int>> defBlocks(original);
+	
+	for (int b : dom.rpo) {
+		for (const IRInstr& instr : function.blocks[b].code) {
+			int d = irDef(instr);
+			
+			if (d >= 0 && (defBlocks[d].empty() || defBlocks[d].back() != b))
+				defBlocks[d].push_back(b);
+		}
+	}
+	
+	vector<int> phiOrigin; // PHI参数起点 -> 原寄存器
+	vector<int> visited(blockCount, -1);
+	
+	for (int reg = 0; reg < original; reg++) {
+		vector<int>& work = defBlocks[reg];
+		
+		while (!work.empty()) {
+			int block = work.back();
+			work.pop_back();
+			
+			for (int y : frontier[block]) {
+				if (visited[y] == reg || y < shift || !live.liveIn(y - shift, reg))
+					continue;
+					
+				visited[y] = reg;
+				const IRInstr& phi = function.addPhi(y, reg, reg);
+				phiOrigin.resize(function.phiArgs.size(), -1);
+				phiOrigin[phi.a] = reg;
+				work.push_back(y);
+			}
+		}
+	}
+	
+	phiOrigin.resize(function.phiArgs.size() + 1, -1);
+	
+	// 重命名：沿支配树先序遍历，current[r]为r当前的SSA名字，离开子树时按undo日志恢复
+	vector<int> current(original);
+	
+	for (int reg = 0; reg < original; reg++) {
+		current[reg] = reg;
+	}
+	
+	vector<pair<int, int>> undo;
+	vector<pair<int, size_t>> walk; // (块, 已访问的子节点数)
+	vector<size_t> marks;
+	
+	auto visit = [&](int b) {
+		marks.push_back(undo.size());
+		walk.push_back({b, 0});
+		SSABlock& block = function.blocks[b];
+		
+		for (IRInstr& instr : block.code) {
+			if (instr.op != PHI) {
+				irRenameUses(instr, [&](int reg) {
+					return reg < original ? current[reg] : reg;
+				});
+			}
+			
+			int d = irDef(instr);
+			
+			if (d >= 0) {
+				int reg = instr.op == PHI ? phiOrigin[instr.a] : d;
+				undo.push_back({reg, current[reg]});
+				current[reg] = instr.dst = function.newReg();
+			}
+		}
+		
+		for (size_t s = 0; s < block.succs.size(); s++) {
+			if (s > 0 && block.succs[s] == block.succs[0])
+				continue;
+				
+			SSABlock& succ = function.blocks[block.succs[s]];
+			
+			for (size_t k = 0; k < succ.preds.size(); k++) {
+				if (succ.preds[k] != b)
+					continue;
+					
+				for (const IRInstr& phi : succ.code) {
+					if (phi.op != PHI)
+						break;
+						
+					function.phiArg(phi, (int)k) = current[phiOrigin[phi.a]];
+				}
+			}
+		}
+	};
+	
+	visit(0);
+	
+	while (!walk.empty()) {
+		auto& [block, next] = walk.back();
+		
+		if (next < dom.children[block].size()) {
+			visit(dom.children[block][next++]);
+		}
+		else {
+			for (size_t mark = marks.back(); undo.size() > mark; undo.pop_back()) {
+				current[undo.back().first] = undo.back().second;
+			}
+			
+			marks.pop_back();
+			walk.pop_back();
+		}
+	}
+	
+	function.removeUnreachable();
+	return function;
+}
+
+// SSA上按变量计算的活跃信息：对每个变量从使用处沿前驱回溯到定义块，只记录各块出口活跃的变量
+// PHI的参数视为在对应前驱的出口处使用
+class SSALiveness {
+		const SSAFunction& function;
+		vector<vector<int>> liveOut; // 块 -> 出口活跃的寄存器（有序）
+		
+	public:
+		vector<pair<int, int>> defSite; // 寄存器 -> (块, 下标)；形参和未定义的寄存器为(0, -1)
+		
+		SSALiveness(const SSAFunction& function) : function(function), liveOut(function.blocks.size()), defSite(function.regCount, {0, -1}) {
+			int blockCount = (int)function.blocks.size();
+			int regCount = function.regCount;
+			vector<int> useStart(regCount + 1, 0);
+			vector<pair<int, int>> uses; // (块, 是否为PHI参数：此时块为对应的前驱)
+			
+			auto forEachUse = [&](auto f) {
+				for (int b = 0; b < blockCount; b++) {
+					const SSABlock& block = function.blocks[b];
+					
+					for (const IRInstr& instr : block.code) {
+						if (instr.op == PHI) {
+							for (int k = 0; k < instr.b; k++) {
+								f(function.phiArgs[instr.a + k], block.preds[k], 1);
+							}
+						}
+						else {
+							int regs[2];
+							int count = irUses(instr, regs);
+							
+							for (int u = 0; u < count; u++) {
+								f(regs[u], b, 0);
+							}
+						}
+					}
+				}
+			};
+			
+			forEachUse([&](int reg, int, int) {
+				useStart[reg + 1]++;
+			});
+			
+			for (int reg = 0; reg < regCount; reg++) {
+				useStart[reg + 1] += useStart[reg];
+			}
+			
+			uses.resize(useStart[regCount]);
+			vector<int> fill(useStart.begin(), useStart.end() - 1);
+			
+			forEachUse([&](int reg, int block, int phi) {
+				uses[fill[reg]++] = {block, phi};
+			});
+			
+			for (int b = 0; b < blockCount; b++) {
+				for (int i = 0; i < (int)function.blocks[b].code.size(); i++) {
+					int d = irDef(function.blocks[b].code[i]);
+					
+					if (d >= 0)
+						defSite[d] = {b, i};
+				}
+			}
+			
+			vector<int> inMark(blockCount, -1), outMark(blockCount, -1), work;
+			
+			for (int reg = 0; reg < regCount; reg++) {
+				int defBlock = defSite[reg].first;
+				
+				auto liveAtEnd = [&](int block) {
+					if (outMark[block] == reg)
+						return;
+						
+					outMark[block] = reg;
+					liveOut[block].push_back(reg);
+					
+					if (block != defBlock && inMark[block] != reg) {
+						inMark[block] = reg;
+						work.push_back(block);
+					}
+				};
+				
+				for (int u = useStart[reg]; u < useStart[reg + 1]; u++) {
+					auto [block, phi] = uses[u];
+					
+					if (phi)
+						liveAtEnd(block);
+					else if (block != defBlock && inMark[block] != reg) {
+						inMark[block] = reg;
+						work.push_back(block);
+					}
+				}
+				
+				while (!work.empty()) {
+					int block = work.back();
+					work.pop_back();
+					
+					for (int pred : function.blocks[block].preds) {
+						liveAtEnd(pred);
+					}
+				}
+			}
+		}
+		
+		bool isLiveOut(int block, int reg) const {
+			return binary_search(liveOut[block].begin(), liveOut[block].end(), reg);
+		}
+		
+		// reg在块block第pos条指令之后是否仍活跃（PHI的参数不算块内的使用）
+		bool liveAfter(int reg, int block, int pos) const {
+			if (isLiveOut(block, reg))
+				return true;
+				
+			const vector<IRInstr>& code = function.blocks[block].code;
+			
+			for (size_t i = pos + 1; i < code.size(); i++) {
+				int regs[2];
+				int count = code[i].op == PHI ? 0 : irUses(code[i], regs);
+				
+				for (int u = 0; u < count; u++) {
+					if (regs[u] == reg)
+						return true;
+				}
+			}
+			
+			return false;
+		}
+};
+
+// 退出SSA，把函数追加到out末尾（function会被修改）：
+// 1. 合并PHI相关的寄存器：PHI的结果和参数互不干涉时分到同一组，共用一个寄存器（循环变量因此不需要复制）
+//    严格SSA中两个值干涉当且仅当一个的定义支配另一个的定义，且在后者定义处仍活跃
+// 2. 拆分关键边，再把每条边上剩下的PHI作为并行复制放在前驱末尾，按依赖排序，有环时借一个临时寄存器
+// 最后把寄存器重新紧凑编号（形参保持r0..r[b-1]），并重新生成标签
+void fromSSA(SSAFunction& function, vector<IRInstr>& out) {
+	int blockCount = (int)function.blocks.size();
+	bool hasPhi = false;
+	
+	for (const SSABlock& block : function.blocks) {
+		hasPhi = hasPhi || (!block.code.empty() && block.code[0].op == PHI);
+	}
+	
+	if (hasPhi) {
+		DominatorTree dom(function.blocks);
+		SSALiveness live(function);
+		
+		auto interfere = [&](int a, int b) {
+			auto [blockA, posA] = live.defSite[a];
+			auto [blockB, posB] = live.defSite[b];
+			
+			if (blockA == blockB ? posA > posB : dom.dominates(blockB, blockA)) {
+				swap(a, b);
+				swap(blockA, blockB);
+				swap(posA, posB);
+			}
+			else if (blockA != blockB && !dom.dominates(blockA, blockB)) {
+				return false;
+			}
+			
+			return live.liveAfter(a, blockB, posB); // a的定义在前：a在b定义处是否活跃
+		};
+		
+		// 并查集，代表元取组内最小的寄存器，形参所在的组以形参为代表
+		vector<int> parent(function.regCount);
+		vector<vector<int>> members(function.regCount);
+		
+		for (int reg = 0; reg < function.regCount; reg++) {
+			parent[reg] = reg;
+			members[reg] = {reg};
+		}
+		
+		auto find = [&](int reg) {
+			while (parent[reg] != reg) {
+				reg = parent[reg] = parent[parent[reg]];
+			}
+			
+			return reg;
+		};
+		
+		for (const SSABlock& block : function.blocks) {
+			for (size_t p = 0; p < block.code.size() && block.code[p].op == PHI; p++) {
+				for (int k = 0; k < block.code[p].b; k++) {
+					int x = find(block.code[p].dst), y = find(function.phiArgs[block.code[p].a + k]);
+					
+					if (x == y || (x < function.paramCount() && y < function.paramCount()))
+						continue;
+						
+					bool conflict = false;
+					
+					for (size_t i = 0; i < members[x].size() && !conflict; i++) {
+						for (size_t j = 0; j < members[y].size() && !conflict; j++) {
+							conflict = interfere(members[x][i], members[y][j]);
+						}
+					}
+					
+					if (conflict)
+						continue;
+						
+					if (y < x)
+						swap(x, y);
+						
+					parent[y] = x;
+					members[x].insert(members[x].end(), members[y].begin(), members[y].end());
+					members[y].clear();
+				}
+			}
+		}
+		
+		for (SSABlock& block : function.blocks) {
+			for (IRInstr& instr : block.code) {
+				irRenameUses(instr, find);
+				
+				if (irDef(instr) >= 0)
+					instr.dst = find(instr.dst);
+			}
+		}
+		
+		for (int& arg : function.phiArgs) {
+			arg = find(arg);
+		}
+	}
+	
+	// 拆分需要复制的关键边：新块排在最后，只含复制和跳回原目标的Goto
+	for (int b = 0; b < blockCount; b++) {
+		for (size_t k = 0; k < function.blocks[b].preds.size(); k++) {
+			int pred = function.blocks[b].preds[k];
+			const vector<IRInstr>& code = function.blocks[b].code;
+			bool needsCopy = false;
+			
+			for (size_t p = 0; p < code.size() && code[p].op == PHI; p++) {
+				needsCopy = needsCopy || function.phiArgs[code[p].a + k] != code[p].dst;
+			}
+			
+			if (!needsCopy || function.blocks[pred].succs.size() < 2)
+				continue;
+				
+			int split = (int)function.blocks.size();
+			function.blocks.push_back({{}, {b}, {pred}});
+			vector<int>& succs = function.blocks[pred].succs;
+			*find(succs.begin(), succs.end(), b) = split;
+			function.blocks[b].preds[k] = split;
+		}
+	}
+	
+	blockCount = (int)function.blocks.size();
+	vector<vector<IRInstr>> copies(blockCount); // 各块末尾（跳转之前）的复制
+	
+	for (int b = 0; b < blockCount; b++) {
+		const SSABlock& block = function.blocks[b];
+		
+		for (size_t k = 0; k < block.preds.size() && !block.code.empty() && block.code[0].op == PHI; k++) {
+			vector<pair<int, int>> pending; // (dst, src)
+			
+			for (size_t p = 0; p < block.code.size() && block.code[p].op == PHI; p++) {
+				int arg = function.phiArgs[block.code[p].a + k];
+				
+				if (arg != block.code[p].dst)
+					pending.push_back({block.code[p].dst, arg});
+			}
+			
+			vector<IRInstr>& target = copies[block.preds[k]];
+			
+			auto isSource = [&](int reg) {
+				return any_of(pending.begin(), pending.end(), [&](const pair<int, int>& copy) {
+					return copy.second == reg;
+				});
+			};
+			
+			while (!pending.empty()) {
+				size_t ready = 0;
+				
+				while (ready < pending.size() && isSource(pending[ready].first)) {
+					ready++;
+				}
+				
+				if (ready == pending.size()) { // 只剩环：先把一个目标的旧值存进临时寄存器
+					int temp = function.newReg();
+					int saved = pending[0].first;
+					target.push_back({ASSIGN, temp, saved, 0});
+					
+					for (pair<int, int>& copy : pending) {
+						if (copy.second == saved)
+							copy.second = temp;
+					}
+					
+					ready = 0;
+				}
+				
+				target.push_back({ASSIGN, pending[ready].first, pending[ready].second, 0});
+				pending.erase(pending.begin() + ready);
+			}
+		}
+	}
+	
+	int regCount = function.regCount;
+	
+	// 需要标签的块：跳转目标，以及后继不是下一块的顺序执行
+	vector<int> label(blockCount, -1);
+	int labelCount = 0;
+	
+	auto need = [&](int target) {
+		if (label[target] < 0)
+			label[target] = labelCount++;
+	};
+	
+	for (int b = 0; b < blockCount; b++) {
+		const SSABlock& block = function.blocks[b];
+		IROp last = block.code.empty() ? LABEL : block.code.back().op;
+		
+		if (last == IF_GT) {
+			need(block.succs[0]);
+			
+			if (block.succs[1] != b + 1)
+				need(block.succs[1]);
+		}
+		else if (last != RET && !block.succs.empty() && block.succs[0] != b + 1) {
+			need(block.succs[0]);
+		}
+	}
+	
+	size_t start = out.size();
+	out.push_back(function.header);
+	
+	for (int b = 0; b < blockCount; b++) {
+		const SSABlock& block = function.blocks[b];
+		
+		if (label[b] >= 0)
+			out.push_back({LABEL, label[b], 0, 0});
+			
+		size_t end = block.code.size();
+		IROp last = end ? block.code.back().op : LABEL;
+		bool terminated = last == IF_GT || last == Goto || last == RET;
+		
+		for (size_t i = 0; i < end - (terminated ? 1 : 0); i++) {
+			if (block.code[i].op != PHI)
+				out.push_back(block.code[i]);
+		}
+		
+		out.insert(out.end(), copies[b].begin(), copies[b].end());
+		
+		if (last == RET) {
+			out.push_back(block.code.back());
+		}
+		else if (last == IF_GT) {
+			IRInstr branch = block.code.back();
+			branch.dst = label[block.succs[0]];
+			out.push_back(branch);
+			
+			if (block.succs[1] != b + 1)
+				out.push_back({Goto, label[block.succs[1]], 0, 0});
+		}
+		else if (!block.succs.empty() && block.succs[0] != b + 1) {
+			out.push_back({Goto, label[block.succs[0]], 0, 0});
+		}
+	}
+	
+	// 重新编号寄存器
+	vector<int> index(regCount, -1);
+	int count = function.paramCount();
+	
+	for (int reg = 0; reg < count; reg++) {
+		index[reg] = reg;
+	}
+	
+	auto rename = [&](int reg) {
+		if (index[reg] < 0)
+			index[reg] = count++;
+			
+		return index[reg];
+	};
+	
+	for (size_t i = start + 1; i < out.size(); i++) {
+		irRenameUses(out[i], rename);
+		
+		if (irDef(out[i]) >= 0)
+			out[i].dst = rename(out[i].dst);
+	}
+	
+	out[start].dst = max(count, 1);
+}
+
+// 检查SSA形式：每个寄存器至多定义一次，每次使用都被其定义支配（PHI参数须支配对应前驱的出口）
+void verifySSA(const SSAFunction& function) {
+	DominatorTree dom(function.blocks);
+	vector<int> defBlock(function.regCount, -1), defPos(function.regCount, -1);
+	string name(symbolName(function.header.a));
+	
+	auto fail = [&](const string& message) {
+		throw runtime_error("Invalid SSA in " + name + ": " + message);
+	};
+	
+	for (int b = 0; b < (int)function.blocks.size(); b++) {
+		const SSABlock& block = function.blocks[b];
+		
+		if (!dom.reachable(b))
+			fail("unreachable block " + to_string(b));
+			
+		for (size_t i = 0; i < block.code.size(); i++) {
+			const IRInstr& instr = block.code[i];
+			
+			if (instr.op == PHI && (i > 0 && block.code[i - 1].op != PHI))
+				fail("PHI after an ordinary instruction in block " + to_string(b));
+				
+			if (instr.op == PHI && instr.b != (int)block.preds.size())
+				fail("PHI argument count differs from predecessor count in block " + to_string(b));
+				
+			int d = irDef(instr);
+			
+			if (d < 0)
+				continue;
+				
+			if (d < function.paramCount() || defBlock[d] >= 0)
+				fail("r" + to_string(d) + " defined more than once");
+				
+			defBlock[d] = b;
+			defPos[d] = (int)i;
+		}
+	}
+	
+	// 没有定义的寄存器视为在入口定义
+	auto dominatesUse = [&](int reg, int block, int pos) {
+		return defBlock[reg] < 0 || (defBlock[reg] == block ? defPos[reg] < pos : dom.dominates(defBlock[reg], block));
+	};
+	
+	for (int b = 0; b < (int)function.blocks.size(); b++) {
+		const SSABlock& block = function.blocks[b];
+		
+		for (size_t i = 0; i < block.code.size(); i++) {
+			const IRInstr& instr = block.code[i];
+			
+			if (instr.op == PHI) {
+				for (int k = 0; k < instr.b; k++) {
+					int pred = block.preds[k];
+					
+					if (!dominatesUse(function.phiArgs[instr.a + k], pred, (int)function.blocks[pred].code.size()))
+						fail("PHI argument r" + to_string(function.phiArgs[instr.a + k]) + " does not dominate its edge");
+				}
+				
+				continue;
+			}
+			
+			int uses[2];
+			int count = irUses(instr, uses);
+			
+			for (int k = 0; k < count; k++) {
+				if (!dominatesUse(uses[k], b, (int)i))
+					fail("use of r" + to_string(uses[k]) + " not dominated by its definition");
+			}
+		}
+	}
+}
+
+#endif /*IR_SSA_H*/
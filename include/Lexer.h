@@ -0,0 +1,121 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<stdexcept>
+#include"./Token.h"
+using namespace std;
+
+// 单遍词法分析器：直接从源码缓冲区切分Token，不再经过temp.txt中转
+// Token只保存指向源码的string_view，扫描过程中不为单个Token分配堆内存
+class Lexer {
+		string_view source;
+		size_t pos;
+		
+		static bool isIdentStart(char c) {
+			return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+		}
+		
+		static bool isDigitChar(char c) {
+			return '0' <= c && c <= '9';
+		}
+		
+		static bool isSpaceChar(char c) {
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+		}
+		
+		// 返回从pos开始的运算符/分隔符长度，0表示不是符号
+		size_t symbolLength() const {
+			char c = source[pos];
+			char n = pos + 1 < source.size() ? source[pos + 1] : '\0';
+			
+			switch (c) {
+				case '&':
+					return n == '&' ? 2 : 1;
+					
+				case '|':
+					return n == '|' ? 2 : 1;
+					
+				case '=':
+				case '!':
+				case '>':
+				case '<':
+					return n == '=' ? 2 : 1; // ==、!=、>=、<=
+					
+				case '+':
+					return n == '+' ? 2 : 1; // ++
+					
+				case '-':
+				case '*':
+				case '/':
+				case '(':
+				case ')':
+				case '{':
+				case '}':
+				case '[':
+				case ']':
+				case ';':
+				case ',':
+					return 1;
+					
+				default:
+					return 0;
+			}
+		}
+		
+	public:
+		Lexer(string_view source) : source(source), pos(0) {}
+		
+		// 切分下一个词素[start, start + length)，到末尾时返回false
+		bool next(size_t& start, size_t& length) {
+			const size_t n = source.size();
+			
+			while (pos < n && isSpaceChar(source[pos])) {
+				pos++;
+			}
+			
+			if (pos >= n) {
+				return false;
+			}
+			
+			start = pos;
+			char c = source[pos];
+			
+			if (isIdentStart(c)) { // 关键字/标识符
+				while (pos < n && (isIdentStart(source[pos]) || isDigitChar(source[pos]))) {
+					pos++;
+				}
+			}
+			else if (isDigitChar(c)) { // 数字
+				while (pos < n && isDigitChar(source[pos])) {
+					pos++;
+				}
+			}
+			else if (size_t len = symbolLength()) { // 运算符/分隔符
+				pos += len;
+			}
+			else {
+				throw runtime_error("Unexpected character: " + string(1, c) + " at " + to_string(pos));
+			}
+			
+			length = pos - start;
+			return true;
+		}
+		
+		// 扫描整个缓冲区，返回全部Token
+		vector<Token> getAllToken() {
+			vector<Token> tokens;
+			tokens.reserve(source.size() / 4);
+			size_t start, length;
+			
+			while (next(start, length)) {
+				tokens.emplace_back(source.substr(start, length), start);
+			}
+			
+			return tokens;
+		}
+};
+
+#endif /*LEXER_H*/
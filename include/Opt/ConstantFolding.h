@@ -0,0 +1,497 @@
+#ifndef OPT_CONSTANT_FOLDING_H
+#define OPT_CONSTANT_FOLDING_H
+
+#include<cstdint>
+#include<string>
+#include<vector>
+#include"../AST/ASTContext.h"
+#include"../AST/ASTnode.h"
+#include"../IR/IR.h"
+#include"../IR/SSA.h"
+using namespace std;
+
+// 降级之前在AST上折叠常量：操作数都是字面量的运算直接替换为字面量，条件为常量的if只保留会执行的分支
+// 只折叠没有副作用的子树（字面量），以及&&、||短路后不会执行的一侧；除以0留到运行时报错
+// 遍历全部用显式栈，深层嵌套不会耗尽调用栈
+class ASTFolder {
+		ASTContext& context;
+		vector<pair<Expression*, bool>> exprStack; // (节点, 子节点是否已入栈)
+		vector<ASTBaseNode**> slots; // 待处理的语句（存放它的指针位置，便于替换）
+		size_t foldedExprs;
+		size_t prunedIfs;
+		
+		static bool isLiteral(Expression* expr) {
+			return expr && expr->exprType == Expression::LITERAL;
+		}
+		
+		// 字面量文本只能是十进制数字：负数按32位无符号写出，literalValue读回时回绕为原值
+		static void makeLiteral(Expression* expr, int value) {
+			expr->exprType = Expression::LITERAL;
+			expr->value = SymbolTable.intern(to_string((uint32_t)value));
+			expr->left = nullptr;
+			expr->right = nullptr;
+		}
+		
+		// 子节点都已折叠后尝试折叠expr本身
+		void foldNode(Expression* expr) {
+			if (expr->exprType != Expression::BINARY_OPERATOR)
+				return;
+				
+			Expression* left = expr->left;
+			Expression* right = expr->right;
+			Symbol op = expr->value;
+			int result;
+			
+			if (op == SYM_NOT) {
+				if (!isLiteral(right))
+					return;
+					
+				result = !literalValue(right->value);
+			}
+			else if (op == SYM_AND || op == SYM_OR) {
+				if (!isLiteral(left))
+					return;
+					
+				bool value = literalValue(left->value) != 0;
+				
+				if (value == (op == SYM_OR)) // 0 && x、1 || x：右侧不会执行
+					result = value;
+				else if (isLiteral(right))
+					result = literalValue(right->value) != 0;
+				else
+					return;
+			}
+			else {
+				if (!isLiteral(left) || !isLiteral(right) ||
+				        !irEvaluate(irBinaryOp(op), literalValue(left->value), literalValue(right->value), result))
+					return;
+			}
+			
+			makeLiteral(expr, result);
+			foldedExprs++;
+		}
+		
+		void foldExpression(Expression* root) {
+			if (!root)
+				return;
+				
+			exprStack.push_back({root, false});
+			
+			while (!exprStack.empty()) {
+				auto [expr, expanded] = exprStack.back();
+				
+				if (!expanded) {
+					exprStack.back().second = true;
+					
+					if (expr->exprType == Expression::FUNC_CALL) {
+						for (Expression* param : static_cast<FunctionCall*>(expr)->parameters) {
+							exprStack.push_back({param, false});
+						}
+						
+						continue;
+					}
+					
+					if (expr->exprType == Expression::BINARY_OPERATOR || expr->exprType == Expression::ARRAY_ELEMENT ||
+					        expr->exprType == Expression::ARRAY_ASSIGN) { // 数组的下标和新值同样折叠
+						if (expr->right)
+							exprStack.push_back({expr->right, false});
+							
+						if (expr->left)
+							exprStack.push_back({expr->left, false});
+							
+						continue;
+					}
+				}
+				
+				exprStack.pop_back();
+				foldNode(expr);
+			}
+		}
+		
+		void pushChildren(ASTBaseNode* node) {
+			for (ASTBaseNode*& child : node->getAllChildren()) {
+				slots.push_back(&child);
+			}
+		}
+		
+		// if条件为常量时用会执行的分支替换整条if语句
+		// 分支直接作为if的子语句时，其中的声明属于外层作用域，所以被删掉的分支若是声明则保留if
+		bool pruneIf(ASTBaseNode** slot) {
+			IfStatement* ifStmt = static_cast<IfStatement*>(*slot);
+			
+			if (!isLiteral(ifStmt->condition))
+				return false;
+				
+			bool taken = literalValue(ifStmt->condition->value) != 0;
+			ASTBaseNode* kept = taken ? ifStmt->thenBlock : ifStmt->elseBlock;
+			ASTBaseNode* dropped = taken ? ifStmt->elseBlock : ifStmt->thenBlock;
+			
+			if (dropped && dropped->getNodeType() == ASTBaseNode::VAR_DECL)
+				return false;
+				
+			*slot = kept ? kept : context.create<Statement>(Statement::EMPTY);
+			prunedIfs++;
+			return true;
+		}
+		
+	public:
+		ASTFolder(ASTContext& context) : context(context), foldedExprs(0), prunedIfs(0) {}
+		
+		void fold(ASTBaseNode* root) {
+			if (!root)
+				return;
+				
+			pushChildren(root);
+			
+			while (!slots.empty()) {
+				ASTBaseNode** slot = slots.back();
+				slots.pop_back();
+				ASTBaseNode* node = *slot;
+				
+				if (!node)
+					continue;
+					
+				switch (node->getNodeType()) {
+					case ASTBaseNode::STMT_BLOCK:
+					case ASTBaseNode::FUNC_DECL:
+						pushChildren(node);
+						break;
+						
+					case ASTBaseNode::STATEMENT:
+						for (ASTBaseNode* child : node->getAllChildren()) {
+							foldExpression(static_cast<Expression*>(child));
+						}
+						
+						break;
+						
+					case ASTBaseNode::VAR_DECL:
+						foldExpression(static_cast<VariableDeclaration*>(node)->initExpr);
+						break;
+						
+					case ASTBaseNode::EXPRESSION:
+						foldExpression(static_cast<Expression*>(node));
+						break;
+						
+					case ASTBaseNode::IF_STATEMENT: {
+							IfStatement* ifStmt = static_cast<IfStatement*>(node);
+							foldExpression(ifStmt->condition);
+							
+							if (pruneIf(slot)) {
+								slots.push_back(slot); // 替换后的语句还要继续折叠
+								break;
+							}
+							
+							slots.push_back(&ifStmt->thenBlock);
+							slots.push_back(&ifStmt->elseBlock);
+							break;
+						}
+						
+					case ASTBaseNode::FOR_STATEMENT: {
+							ForStatement* forStmt = static_cast<ForStatement*>(node);
+							foldExpression(forStmt->condition);
+							slots.push_back(&forStmt->initStmt);
+							slots.push_back(&forStmt->updateStmt);
+							slots.push_back(&forStmt->body);
+							break;
+						}
+						
+					default:
+						break;
+				}
+			}
+		}
+		
+		size_t getFoldedExpressions() const {
+			return foldedExprs;
+		}
+		
+		size_t getPrunedIfs() const {
+			return prunedIfs;
+		}
+};
+
+// 稀疏条件常量传播（Wegman-Zadeck）：寄存器的格值为 未定(TOP) > 常量 > 非常量(BOTTOM)
+// 只沿可执行的边传播，PHI只合并可执行入边的值；结束后把常量定义改为CONST，
+// 删掉不可执行的边（常量条件的IF_GT变为Goto或顺序执行）和不可达的块，再合并留下的直线块
+// 不会删除原本的CONST定义，它们由死代码消除清理
+void sccp(SSAFunction& function) {
+	enum Lattice : uint8_t { TOP, CONSTANT, BOTTOM };
+	int regCount = function.regCount;
+	int blockCount = (int)function.blocks.size();
+	vector<uint8_t> state(regCount, BOTTOM);
+	vector<int> value(regCount, 0);
+	
+	// 有定义的寄存器从TOP开始；形参和未定义的寄存器在入口处取未知值
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			int d = irDef(instr);
+			
+			if (d >= 0)
+				state[d] = TOP;
+		}
+	}
+	
+	// 使用者列表（CSR）：寄存器 -> 读取它的(块, 指令下标)
+	vector<int> userStart(regCount + 1, 0);
+	vector<pair<int, int>> users;
+	
+	auto forEachUse = [&](const IRInstr& instr, auto f) {
+		if (instr.op == PHI) {
+			for (int k = 0; k < instr.b; k++) {
+				f(function.phiArgs[instr.a + k]);
+			}
+			
+			return;
+		}
+		
+		int uses[2];
+		int count = irUses(instr, uses);
+		
+		for (int k = 0; k < count; k++) {
+			f(uses[k]);
+		}
+	};
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			forEachUse(instr, [&](int reg) {
+				userStart[reg + 1]++;
+			});
+		}
+	}
+	
+	for (int reg = 0; reg < regCount; reg++) {
+		userStart[reg + 1] += userStart[reg];
+	}
+	
+	users.resize(userStart[regCount]);
+	vector<int> fill(userStart.begin(), userStart.end() - 1);
+	
+	for (int b = 0; b < blockCount; b++) {
+		for (int i = 0; i < (int)function.blocks[b].code.size(); i++) {
+			forEachUse(function.blocks[b].code[i], [&](int reg) {
+				users[fill[reg]++] = {b, i};
+			});
+		}
+	}
+	
+	vector<char> blockLive(blockCount, 0);
+	vector<vector<char>> edgeLive(blockCount); // 各块第s个后继的边是否可执行
+	vector<vector<char>> predLive(blockCount); // 各块第k个前驱的边是否可执行
+	
+	for (int b = 0; b < blockCount; b++) {
+		edgeLive[b].assign(function.blocks[b].succs.size(), 0);
+		predLive[b].assign(function.blocks[b].preds.size(), 0);
+	}
+	
+	vector<pair<int, int>> edgeWork; // (块, 后继序号)
+	vector<int> regWork;
+	
+	auto lower = [&](int reg, uint8_t newState, int newValue) {
+		if (newState == CONSTANT && state[reg] == CONSTANT && value[reg] != newValue)
+			newState = BOTTOM;
+			
+		if (newState <= state[reg])
+			return;
+			
+		state[reg] = newState;
+		value[reg] = newValue;
+		regWork.push_back(reg);
+	};
+	
+	auto markEdge = [&](int block, int s) {
+		if (!edgeLive[block][s]) {
+			edgeLive[block][s] = 1;
+			edgeWork.push_back({block, s});
+		}
+	};
+	
+	auto evaluate = [&](int b, int i) {
+		const SSABlock& block = function.blocks[b];
+		const IRInstr& instr = block.code[i];
+		
+		switch (instr.op) {
+			case PHI: {
+					uint8_t result = TOP;
+					int constant = 0;
+					
+					for (int k = 0; k < instr.b && result != BOTTOM; k++) {
+						if (!predLive[b][k])
+							continue;
+							
+						int arg = function.phiArgs[instr.a + k];
+						
+						if (state[arg] == BOTTOM || (state[arg] == CONSTANT && result == CONSTANT && value[arg] != constant))
+							result = BOTTOM;
+						else if (state[arg] == CONSTANT) {
+							result = CONSTANT;
+							constant = value[arg];
+						}
+					}
+					
+					lower(instr.dst, result, constant);
+					break;
+				}
+				
+			case CONST:
+				lower(instr.dst, CONSTANT, instr.a);
+				break;
+				
+			case IF_GT:
+				if (state[instr.a] == BOTTOM || state[instr.b] == BOTTOM) {
+					markEdge(b, 0);
+					markEdge(b, 1);
+				}
+				else if (state[instr.a] == CONSTANT && state[instr.b] == CONSTANT) {
+					markEdge(b, value[instr.a] > value[instr.b] ? 0 : 1);
+				}
+				
+				break;
+				
+			case Goto:
+				markEdge(b, 0);
+				break;
+				
+			case RET:
+			case ARG:
+			case STOREG:
+			case STOREA:
+			case VLOAD:
+			case VSTORE:
+			case VSPLAT:
+			case VADD:
+			case VSUB:
+			case VMUL:
+				break;
+				
+			case CALL:
+			case LOADG:
+			case LOADA:
+				lower(instr.dst, BOTTOM, 0);
+				break;
+				
+			default: {
+					int uses[2];
+					int count = irUses(instr, uses);
+					uint8_t result = CONSTANT;
+					
+					for (int k = 0; k < count; k++) {
+						if (state[uses[k]] == BOTTOM)
+							result = BOTTOM;
+						else if (state[uses[k]] == TOP && result != BOTTOM)
+							result = TOP;
+					}
+					
+					if (result == TOP)
+						break;
+						
+					int constant = 0;
+					
+					if (result == CONSTANT && !irEvaluate(instr.op, value[instr.a], count > 1 ? value[instr.b] : 0, constant))
+						result = BOTTOM;
+						
+					lower(instr.dst, result, constant);
+					break;
+				}
+		}
+		
+		// 没有跳转指令的块顺序执行到唯一的后继
+		if (i + 1 == (int)block.code.size() && instr.op != IF_GT && instr.op != Goto && instr.op != RET && !block.succs.empty())
+			markEdge(b, 0);
+	};
+	
+	auto visitBlock = [&](int b) {
+		blockLive[b] = 1;
+		const SSABlock& block = function.blocks[b];
+		
+		for (int i = 0; i < (int)block.code.size(); i++) {
+			evaluate(b, i);
+		}
+		
+		if (block.code.empty() && !block.succs.empty())
+			markEdge(b, 0);
+	};
+	
+	visitBlock(0);
+	
+	while (!edgeWork.empty() || !regWork.empty()) {
+		while (!edgeWork.empty()) {
+			auto [from, s] = edgeWork.back();
+			edgeWork.pop_back();
+			int to = function.blocks[from].succs[s];
+			const SSABlock& target = function.blocks[to];
+			
+			for (size_t k = 0; k < target.preds.size(); k++) {
+				if (target.preds[k] == from)
+					predLive[to][k] = 1;
+			}
+			
+			if (!blockLive[to]) {
+				visitBlock(to);
+			}
+			else { // 新的入边只影响PHI
+				for (int i = 0; i < (int)target.code.size() && target.code[i].op == PHI; i++) {
+					evaluate(to, i);
+				}
+			}
+		}
+		
+		if (!regWork.empty()) {
+			int reg = regWork.back();
+			regWork.pop_back();
+			
+			for (int u = userStart[reg]; u < userStart[reg + 1]; u++) {
+				if (blockLive[users[u].first])
+					evaluate(users[u].first, users[u].second);
+			}
+		}
+	}
+	
+	// 改写：常量定义变为CONST（常量PHI移到PHI之后），删掉不可执行的边
+	for (int b = 0; b < blockCount; b++) {
+		if (!blockLive[b])
+			continue;
+			
+		vector<IRInstr>& code = function.blocks[b].code;
+		vector<IRInstr> constPhis;
+		size_t phiEnd = 0;
+		
+		for (size_t i = 0; i < code.size(); i++) {
+			IRInstr& instr = code[i];
+			int d = irDef(instr);
+			
+			if (instr.op == PHI) {
+				if (state[d] == CONSTANT)
+					constPhis.push_back({CONST, d, value[d], 0});
+				else
+					code[phiEnd++] = instr;
+					
+				continue;
+			}
+			
+			if (d >= 0 && state[d] == CONSTANT)
+				instr = {CONST, d, value[d], 0};
+		}
+		
+		if (!constPhis.empty()) {
+			size_t phiCount = phiEnd + constPhis.size();
+			code.erase(code.begin() + phiEnd, code.begin() + phiCount);
+			code.insert(code.begin() + phiEnd, constPhis.begin(), constPhis.end());
+		}
+	}
+	
+	for (int b = 0; b < blockCount; b++) {
+		if (!blockLive[b])
+			continue;
+			
+		for (int s = (int)edgeLive[b].size() - 1; s >= 0; s--) {
+			if (!edgeLive[b][s])
+				function.removeEdge(b, function.blocks[b].succs[s]);
+		}
+	}
+	
+	function.removeUnreachable();
+	function.mergeBlocks(); // 删掉分支后留下的直线块
+}
+
+#endif /*OPT_CONSTANT_FOLDING_H*/
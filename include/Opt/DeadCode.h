@@ -0,0 +1,275 @@
+#ifndef OPT_DEAD_CODE_H
+#define OPT_DEAD_CODE_H
+
+#include<string>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"../IR/SSA.h"
+#include"../Symbol.h"
+using namespace std;
+
+// 指令是否有副作用（即使结果没人用也必须保留）
+// DIV的除数不是非零常量时可能在运行时报错，同样保留；constValue[r]为r的CONST值，known[r]表示r是否为常量
+// LOADA可能下标越界，也保留；向量寄存器不参与这里的活跃性分析，向量指令一律保留
+bool irHasSideEffect(const IRInstr& instr, const vector<char>& known, const vector<int>& constValue) {
+	switch (instr.op) {
+		case IF_GT:
+		case Goto:
+		case ARG:
+		case CALL:
+		case RET:
+		case STOREG:
+		case LOADA:
+		case STOREA:
+		case VLOAD:
+		case VSTORE:
+		case VSPLAT:
+		case VADD:
+		case VSUB:
+		case VMUL:
+			return true;
+			
+		case DIV:
+			return !known[instr.b] || constValue[instr.b] == 0;
+			
+		default:
+			return false;
+	}
+}
+
+// 基于活跃性的死代码删除（标记-清除）：从有副作用的指令出发，沿操作数和PHI参数标记被用到的定义，其余指令删除
+// 只被死代码使用的值同样会被删除，因此声明后从未读取的局部变量、只在循环里自增却从不读取的变量（PHI环）都会消失
+void eliminateDeadCode(SSAFunction& function) {
+	int regCount = function.regCount;
+	vector<const IRInstr*> def(regCount, nullptr);
+	vector<char> known(regCount, 0);
+	vector<int> constValue(regCount, 0);
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			int d = irDef(instr);
+			
+			if (d < 0)
+				continue;
+				
+			def[d] = &instr;
+			
+			if (instr.op == CONST) {
+				known[d] = 1;
+				constValue[d] = instr.a;
+			}
+		}
+	}
+	
+	vector<char> live(regCount, 0);
+	vector<int> work;
+	auto markUses = [&](const IRInstr& instr) {
+		auto mark = [&](int reg) {
+			if (!live[reg]) {
+				live[reg] = 1;
+				work.push_back(reg);
+			}
+		};
+		
+		if (instr.op == PHI) {
+			for (int k = 0; k < instr.b; k++) {
+				mark(function.phiArgs[instr.a + k]);
+			}
+			
+			return;
+		}
+		
+		int uses[2];
+		int count = irUses(instr, uses);
+		
+		for (int k = 0; k < count; k++) {
+			mark(uses[k]);
+		}
+	};
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			if (irHasSideEffect(instr, known, constValue))
+				markUses(instr);
+		}
+	}
+	
+	while (!work.empty()) {
+		int reg = work.back();
+		work.pop_back();
+		
+		if (def[reg]) // 形参和未定义就使用的寄存器没有定义指令
+			markUses(*def[reg]);
+	}
+	
+	for (SSABlock& block : function.blocks) {
+		size_t kept = 0;
+		
+		for (const IRInstr& instr : block.code) {
+			int d = irDef(instr);
+			
+			if (irHasSideEffect(instr, known, constValue) || (d >= 0 && live[d]))
+				block.code[kept++] = instr;
+		}
+		
+		block.code.resize(kept);
+	}
+}
+
+// 块内的全局变量死存储删除：同一个全局变量被再次写入之前没有被读取（中间也没有CALL），前一次写入就是死的
+// 从块尾向前扫描，overwritten记录"在此之后、被读取之前会被覆盖"的全局变量；跨块时保守地认为都会被读取
+void eliminateDeadStores(SSAFunction& function) {
+	int globalCount = 0;
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			if (instr.op == STOREG)
+				globalCount = max(globalCount, instr.dst + 1);
+		}
+	}
+	
+	if (globalCount == 0)
+		return;
+		
+	vector<char> overwritten(globalCount, 0);
+	vector<int> marked; // overwritten中被置位的下标，便于清空
+	
+	for (SSABlock& block : function.blocks) {
+		vector<IRInstr>& code = block.code;
+		size_t kept = code.size();
+		
+		for (size_t i = code.size(); i > 0; i--) {
+			IRInstr instr = code[i - 1];
+			
+			if (instr.op == STOREG) {
+				if (overwritten[instr.dst])
+					continue;
+					
+				overwritten[instr.dst] = 1;
+				marked.push_back(instr.dst);
+			}
+			else if (instr.op == LOADG && instr.a < globalCount) {
+				overwritten[instr.a] = 0;
+			}
+			else if (instr.op == CALL) { // 被调函数可能读取任何全局变量
+				for (int g : marked) {
+					overwritten[g] = 0;
+				}
+				
+				marked.clear();
+			}
+			
+			code[--kept] = instr;
+		}
+		
+		code.erase(code.begin(), code.begin() + kept);
+		
+		for (int g : marked) {
+			overwritten[g] = 0;
+		}
+		
+		marked.clear();
+	}
+}
+
+// 程序级：删除从顶层语句出发、沿CALL永远到达不了的函数
+void removeUnreachableFunctions(vector<IRInstr>& IR) {
+	vector<size_t> begin(SymbolTable.size(), SIZE_MAX); // 函数名 -> FUNC的位置
+	Symbol topName = SymbolTable.intern(TOP_LEVEL_NAME);
+	
+	for (size_t i = 0; i < IR.size(); i++) {
+		if (IR[i].op != FUNC)
+			continue;
+			
+		if ((size_t)IR[i].a >= begin.size())
+			begin.resize(IR[i].a + 1, SIZE_MAX);
+			
+		begin[IR[i].a] = i;
+	}
+	
+	if (topName >= begin.size() || begin[topName] == SIZE_MAX)
+		return;
+		
+	vector<char> reachable(begin.size(), 0);
+	vector<Symbol> work = {topName};
+	reachable[topName] = 1;
+	
+	while (!work.empty()) {
+		size_t start = begin[work.back()];
+		work.pop_back();
+		
+		for (size_t i = start + 1, end = irFunctionEnd(IR, start); i < end; i++) {
+			Symbol callee = (Symbol)IR[i].a;
+			
+			// 调用未定义的函数留给加载时报错
+			if (IR[i].op == CALL && callee < begin.size() && begin[callee] != SIZE_MAX && !reachable[callee]) {
+				reachable[callee] = 1;
+				work.push_back(callee);
+			}
+		}
+	}
+	
+	size_t kept = 0;
+	
+	for (size_t i = 0; i < IR.size();) {
+		size_t end = IR[i].op == FUNC ? irFunctionEnd(IR, i) : i + 1;
+		
+		if (IR[i].op != FUNC || reachable[IR[i].a]) {
+			for (; i < end; i++) {
+				IR[kept++] = IR[i];
+			}
+		}
+		
+		i = end;
+	}
+	
+	IR.resize(kept);
+}
+
+// 程序级：删除从未被读取的全局变量，连同对它的所有STOREG；剩下的全局变量重新紧凑编号
+// 被存储的值因此可能变成死代码，交给随后的eliminateDeadCode
+void removeUnusedGlobals(vector<IRInstr>& IR) {
+	int globalCount = 0;
+	
+	for (const IRInstr& instr : IR) {
+		if (instr.op == GLOBAL)
+			globalCount = max(globalCount, instr.dst + 1);
+	}
+	
+	vector<int> index(globalCount, -1);
+	
+	for (const IRInstr& instr : IR) {
+		if (instr.op == LOADG)
+			index[instr.a] = 0;
+	}
+	
+	int count = 0;
+	
+	for (int& g : index) {
+		if (g == 0)
+			g = count++;
+	}
+	
+	if (count == globalCount)
+		return;
+		
+	size_t kept = 0;
+	
+	for (IRInstr instr : IR) {
+		if (instr.op == GLOBAL || instr.op == STOREG) {
+			if (index[instr.dst] < 0)
+				continue;
+				
+			instr.dst = index[instr.dst];
+		}
+		else if (instr.op == LOADG) {
+			instr.a = index[instr.a];
+		}
+		
+		IR[kept++] = instr;
+	}
+	
+	IR.resize(kept);
+}
+
+#endif /*OPT_DEAD_CODE_H*/
@@ -0,0 +1,274 @@
+#ifndef OPT_INLINER_H
+#define OPT_INLINER_H
+
+#include<algorithm>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"../IR/SSA.h"
+#include"../Symbol.h"
+using namespace std;
+
+// 内联的代价模型：被调函数的大小按指令数计（不含FUNC和LABEL）
+struct InlineOptions {
+	int maxCalleeSize = 40; // 被调函数不超过这个大小才内联
+	int constantArgBonus = 8; // 每个常量实参放宽的大小：内联后SCCP会按实参特化，实际代码更小
+	int maxFunctionSize = 4000; // 调用方增长到这个大小后不再往里内联
+};
+
+// 程序级内联：在FUNC/CALL构成的调用图（即FunctionDeclaration和FunctionCall）上自底向上进行，被调函数先完成自己的内联
+// 调用处的ARG改为给被调函数形参的副本赋值，被调函数的寄存器和标签整体平移到调用方之后；
+// RET改为给CALL的结果赋值并跳到调用处之后。常量实参随后由SCCP传播进内联的函数体
+// 同一个强连通分量内的调用（递归）不内联
+class Inliner {
+		struct Function {
+			vector<IRInstr> code; // code[0]为FUNC
+			vector<int> callees; // 依次为每条CALL的被调函数编号，-1表示未定义
+			int size;
+			int labelCount;
+		};
+		
+		InlineOptions options;
+		vector<Function> functions;
+		vector<int> component; // 函数 -> 所在强连通分量
+		size_t inlinedCalls;
+		
+		static void measure(Function& function) {
+			function.size = 0;
+			function.labelCount = 0;
+			
+			for (const IRInstr& instr : function.code) {
+				if (instr.op == LABEL)
+					function.labelCount = max(function.labelCount, instr.dst + 1);
+				else if (instr.op != FUNC)
+					function.size++;
+			}
+		}
+		
+		// Tarjan强连通分量（显式栈），返回自底向上的处理顺序：每个分量都排在调用它的分量之前
+		vector<int> bottomUpOrder() {
+			int n = (int)functions.size();
+			vector<int> order(n, -1), low(n, 0), stack, result;
+			vector<pair<int, size_t>> dfs; // (函数, 下一个要看的callees下标)
+			component.assign(n, -1);
+			int counter = 0, componentCount = 0;
+			
+			for (int root = 0; root < n; root++) {
+				if (order[root] >= 0)
+					continue;
+					
+				order[root] = low[root] = counter++;
+				stack.push_back(root);
+				dfs.push_back({root, 0});
+				
+				while (!dfs.empty()) {
+					int v = dfs.back().first;
+					
+					if (dfs.back().second < functions[v].callees.size()) {
+						int w = functions[v].callees[dfs.back().second++];
+						
+						if (w < 0)
+							continue;
+							
+						if (order[w] < 0) {
+							order[w] = low[w] = counter++;
+							stack.push_back(w);
+							dfs.push_back({w, 0});
+						}
+						else if (component[w] < 0) { // w仍在栈上
+							low[v] = min(low[v], order[w]);
+						}
+						
+						continue;
+					}
+					
+					dfs.pop_back();
+					
+					if (!dfs.empty())
+						low[dfs.back().first] = min(low[dfs.back().first], low[v]);
+						
+					if (low[v] == order[v]) {
+						int w;
+						
+						do {
+							w = stack.back();
+							stack.pop_back();
+							component[w] = componentCount;
+							result.push_back(w);
+						}
+						while (w != v);
+						
+						componentCount++;
+					}
+				}
+			}
+			
+			return result;
+		}
+		
+		// 把被调函数的代码接到out末尾：寄存器加regBase，标签加labelBase，返回值写入result后跳到endLabel
+		static void copyBody(const Function& callee, int regBase, int labelBase, int result, int endLabel, vector<IRInstr>& out) {
+			auto shift = [regBase](int reg) {
+				return reg + regBase;
+			};
+			
+			for (size_t i = 1; i < callee.code.size(); i++) {
+				IRInstr instr = callee.code[i];
+				
+				if (instr.op == RET) {
+					out.push_back({ASSIGN, result, instr.a + regBase, 0});
+					
+					if (i + 1 < callee.code.size()) // 函数末尾的RET直接顺序执行到endLabel
+						out.push_back({Goto, endLabel, 0, 0});
+						
+					continue;
+				}
+				
+				irRenameUses(instr, shift);
+				
+				if (instr.op == LABEL || instr.op == Goto || instr.op == IF_GT)
+					instr.dst += labelBase;
+				else if (irDef(instr) >= 0)
+					instr.dst += regBase;
+					
+				out.push_back(instr);
+			}
+			
+			out.push_back({LABEL, endLabel, 0, 0});
+		}
+		
+		void inlineInto(int caller) {
+			Function& function = functions[caller];
+			vector<IRInstr>& code = function.code;
+			vector<int> defCount(code[0].dst, 0);
+			
+			for (const IRInstr& instr : code) {
+				int d = irDef(instr);
+				
+				if (d >= 0)
+					defCount[d]++;
+			}
+			
+			// 只被定义一次且由CONST定义的寄存器
+			vector<char> constant(code[0].dst, 0);
+			
+			for (const IRInstr& instr : code) {
+				if (instr.op == CONST && defCount[instr.dst] == 1)
+					constant[instr.dst] = 1;
+			}
+			
+			vector<IRInstr> out;
+			out.reserve(code.size());
+			int regCount = code[0].dst;
+			int labelCount = function.labelCount;
+			int size = function.size;
+			bool changed = false;
+			size_t callIndex = 0; // 与callees一一对应
+			
+			for (const IRInstr& instr : code) {
+				if (instr.op != CALL) {
+					out.push_back(instr);
+					continue;
+				}
+				
+				int target = function.callees[callIndex++];
+				
+				if (target < 0 || component[target] == component[caller]) {
+					out.push_back(instr);
+					continue;
+				}
+				
+				const Function& callee = functions[target];
+				int argc = instr.b;
+				int constantArgs = 0;
+				
+				for (int k = 0; k < argc; k++) {
+					constantArgs += constant[out[out.size() - argc + k].a];
+				}
+				
+				bool profitable = callee.size <= options.maxCalleeSize + options.constantArgBonus * constantArgs &&
+				                  size + callee.size <= options.maxFunctionSize;
+				
+				if (!profitable) {
+					out.push_back(instr);
+					continue;
+				}
+				
+				// 实参的ARG紧挨在CALL之前，改为给形参的副本赋值
+				int regBase = regCount;
+				size_t first = out.size() - argc;
+				
+				for (int k = 0; k < argc; k++) {
+					out[first + k] = {ASSIGN, regBase + k, out[first + k].a, 0};
+				}
+				
+				copyBody(callee, regBase, labelCount, instr.dst, labelCount + callee.labelCount, out);
+				regCount += callee.code[0].dst;
+				labelCount += callee.labelCount + 1;
+				size += callee.size;
+				inlinedCalls++;
+				changed = true;
+			}
+			
+			if (!changed)
+				return;
+				
+			out[0].dst = regCount;
+			code.swap(out);
+			measure(function);
+		}
+		
+	public:
+		Inliner(const InlineOptions& options = InlineOptions()) : options(options), inlinedCalls(0) {}
+		
+		// 内联后不再被调用的函数留给removeUnreachableFunctions删除
+		void run(vector<IRInstr>& IR) {
+			vector<int> index(SymbolTable.size(), -1); // 函数名 -> 函数编号
+			vector<IRInstr> globals;
+			functions.clear();
+			
+			for (size_t i = 0; i < IR.size();) {
+				if (IR[i].op != FUNC) {
+					globals.push_back(IR[i++]);
+					continue;
+				}
+				
+				size_t end = irFunctionEnd(IR, i);
+				
+				if ((size_t)IR[i].a >= index.size())
+					index.resize(IR[i].a + 1, -1);
+					
+				index[IR[i].a] = (int)functions.size();
+				functions.push_back({vector<IRInstr>(IR.begin() + i, IR.begin() + end), {}, 0, 0});
+				measure(functions.back());
+				i = end;
+			}
+			
+			for (Function& function : functions) {
+				for (const IRInstr& instr : function.code) {
+					if (instr.op != CALL)
+						continue;
+						
+					// 调用未定义的函数记为-1，留给加载时报错
+					function.callees.push_back((size_t)instr.a < index.size() ? index[instr.a] : -1);
+				}
+			}
+			
+			vector<int> order = bottomUpOrder();
+			
+			for (int f : order) {
+				inlineInto(f);
+			}
+			
+			IR.swap(globals);
+			
+			for (const Function& function : functions) {
+				IR.insert(IR.end(), function.code.begin(), function.code.end());
+			}
+		}
+		
+		size_t getInlinedCalls() const {
+			return inlinedCalls;
+		}
+};
+
+#endif /*OPT_INLINER_H*/
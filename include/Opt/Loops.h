@@ -0,0 +1,526 @@
+#ifndef OPT_LOOPS_H
+#define OPT_LOOPS_H
+
+#include<algorithm>
+#include<cstdint>
+#include<vector>
+#include"../IR/CFG.h"
+#include"../IR/IRbase.h"
+#include"../IR/SSA.h"
+using namespace std;
+
+// 循环优化的参数
+struct LoopOptions {
+	bool hoistInvariants = true; // 循环不变量外提
+	bool reduceStrength = true; // 归纳变量的强度削减
+	bool vectorize = true; // 数组上逐元素运算的最内层循环改为一次处理VECTOR_WIDTH个元素（见Vectorize.h）
+	int unrollFactor = 4; // 次数为常量的循环最多展开几倍，1表示不展开
+	int maxUnrolledSize = 256; // 展开一个循环最多新增的指令数
+};
+
+// 循环的前置块：header在循环外唯一的前驱，且只有header一个后继；没有时返回-1
+int loopPreheader(const SSAFunction& function, const NaturalLoop& loop) {
+	int preheader = -1;
+	
+	for (int pred : function.blocks[loop.header].preds) {
+		if (loop.contains(pred))
+			continue;
+			
+		if (preheader >= 0)
+			return -1;
+			
+		preheader = pred;
+	}
+	
+	if (preheader < 0 || function.blocks[preheader].succs.size() != 1)
+		return -1;
+		
+	return preheader;
+}
+
+// 块末尾跳转指令的位置，没有跳转时为块的长度
+size_t terminatorPosition(const SSABlock& block) {
+	size_t end = block.code.size();
+	
+	if (end > 0 && (block.code[end - 1].op == IF_GT || block.code[end - 1].op == Goto || block.code[end - 1].op == RET))
+		return end - 1;
+		
+	return end;
+}
+
+// 每个寄存器的定义所在的块；形参和未定义就使用的寄存器为-1
+vector<int> definingBlocks(const SSAFunction& function) {
+	vector<int> defBlock(function.regCount, -1);
+	
+	for (int b = 0; b < (int)function.blocks.size(); b++) {
+		for (const IRInstr& instr : function.blocks[b].code) {
+			int d = irDef(instr);
+			
+			if (d >= 0)
+				defBlock[d] = b;
+		}
+	}
+	
+	return defBlock;
+}
+
+// 由CONST定义的寄存器：known[r]表示r是常量，值为value[r]
+void findConstants(const SSAFunction& function, vector<char>& known, vector<int>& value) {
+	known.assign(function.regCount, 0);
+	value.assign(function.regCount, 0);
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			if (instr.op == CONST) {
+				known[instr.dst] = 1;
+				value[instr.dst] = instr.a;
+			}
+		}
+	}
+}
+
+// 循环不变量外提：操作数都在循环外定义的纯运算移到前置块，由内向外逐层进行，提到内层前置块的指令随后还可以继续外提
+// 没有副作用的指令即使循环一次也不执行，提前计算也不改变结果；可能出错的DIV（除数不是非零常量）不移动，
+// LOADG只在循环内没有CALL、也没有写同一个全局变量时移动
+void hoistLoopInvariants(SSAFunction& function) {
+	DominatorTree dom(function.blocks);
+	vector<NaturalLoop> loops = findLoops(function.blocks, dom);
+	
+	if (loops.empty())
+		return;
+		
+	vector<int> defBlock = definingBlocks(function);
+	vector<char> known;
+	vector<int> constValue;
+	findConstants(function, known, constValue);
+	
+	for (size_t l = loops.size(); l > 0; l--) {
+		const NaturalLoop& loop = loops[l - 1];
+		int preheader = loopPreheader(function, loop);
+		
+		if (preheader < 0)
+			continue;
+			
+		bool hasCall = false;
+		vector<int> stored;
+		
+		for (int b : loop.blocks) {
+			for (const IRInstr& instr : function.blocks[b].code) {
+				if (instr.op == CALL)
+					hasCall = true;
+				else if (instr.op == STOREG)
+					stored.push_back(instr.dst);
+			}
+		}
+		
+		auto invariant = [&](int reg) {
+			return defBlock[reg] < 0 || !loop.contains(defBlock[reg]);
+		};
+		auto hoistable = [&](const IRInstr& instr) {
+			switch (instr.op) {
+				case DIV:
+					if (!known[instr.b] || constValue[instr.b] == 0)
+						return false;
+						
+					break;
+					
+				case LOADG:
+					if (hasCall || find(stored.begin(), stored.end(), instr.a) != stored.end())
+						return false;
+						
+					break;
+					
+				case ADD:
+				case SUB:
+				case MUL:
+				case EQ:
+				case NE:
+				case LT:
+				case LE:
+				case GT:
+				case GE:
+				case ASSIGN:
+				case INC:
+				case NOT:
+				case CONST:
+					break;
+					
+				default:
+					return false;
+			}
+			
+			int uses[2];
+			int count = irUses(instr, uses);
+			
+			for (int k = 0; k < count; k++) {
+				if (!invariant(uses[k]))
+					return false;
+			}
+			
+			return true;
+		};
+		
+		// 按逆后序访问，操作数的定义先于使用被处理，一遍即可
+		vector<int> order = loop.blocks;
+		sort(order.begin(), order.end(), [&](int x, int y) {
+			return dom.rpoIndex[x] < dom.rpoIndex[y];
+		});
+		vector<IRInstr> hoisted;
+		
+		for (int b : order) {
+			vector<IRInstr>& code = function.blocks[b].code;
+			size_t kept = 0;
+			
+			for (size_t i = 0; i < code.size(); i++) {
+				if (hoistable(code[i])) {
+					hoisted.push_back(code[i]);
+					defBlock[code[i].dst] = preheader;
+				}
+				else {
+					code[kept++] = code[i];
+				}
+			}
+			
+			code.resize(kept);
+		}
+		
+		SSABlock& target = function.blocks[preheader];
+		target.code.insert(target.code.begin() + terminatorPosition(target), hoisted.begin(), hoisted.end());
+	}
+}
+
+// 归纳变量的强度削减：基本归纳变量i = φ(init, i + 1)（更新为INC），循环内的乘法i * k（k为循环不变量）
+// 改为新的归纳变量d = φ(init * k, d + k)：乘法只在前置块执行一次，每次迭代在i自增的位置做一次加法
+// 与虚拟机一样按32位回绕，(i + 1) * k与i * k + k总是相等
+void reduceInductionVariables(SSAFunction& function) {
+	DominatorTree dom(function.blocks);
+	vector<NaturalLoop> loops = findLoops(function.blocks, dom);
+	
+	if (loops.empty())
+		return;
+		
+	vector<int> defBlock = definingBlocks(function);
+	vector<int> replacement(function.regCount, -1); // 被削减的乘法 -> 代替它的φ
+	
+	for (const NaturalLoop& loop : loops) {
+		int preheader = loopPreheader(function, loop);
+		
+		if (preheader < 0 || loop.latches.size() != 1 || function.blocks[loop.header].preds.size() != 2)
+			continue;
+			
+		int inside = function.blocks[loop.header].preds[0] == preheader ? 1 : 0; // 来自latch的PHI参数
+		auto invariant = [&](int reg) {
+			return defBlock[reg] < 0 || !loop.contains(defBlock[reg]);
+		};
+		
+		struct Induction {
+			int reg; // header中的φ
+			int init;
+			int next; // INC reg
+			int incBlock;
+		};
+		vector<Induction> inductions;
+		
+		for (const IRInstr& phi : function.blocks[loop.header].code) {
+			if (phi.op != PHI)
+				break;
+				
+			int next = function.phiArgs[phi.a + inside];
+			int block = defBlock[next];
+			
+			if (block < 0 || !loop.contains(block))
+				continue;
+				
+			for (const IRInstr& instr : function.blocks[block].code) {
+				if (instr.op == INC && instr.dst == next && instr.a == phi.dst)
+					inductions.push_back({phi.dst, function.phiArgs[phi.a + 1 - inside], next, block});
+			}
+		}
+		
+		for (const Induction& induction : inductions) {
+			vector<pair<int, int>> reduced; // (k, d)：同一个k只建一个新的归纳变量
+			defBlock.resize(function.regCount, -1); // 前面新建的寄存器
+			replacement.resize(function.regCount, -1);
+			vector<pair<int, int>> products; // (乘法的结果, k)
+			
+			for (int b : loop.blocks) {
+				for (const IRInstr& instr : function.blocks[b].code) {
+					if (instr.op != MUL || replacement[instr.dst] >= 0)
+						continue;
+						
+					if (instr.a == induction.reg && invariant(instr.b))
+						products.push_back({instr.dst, instr.b});
+					else if (instr.b == induction.reg && invariant(instr.a))
+						products.push_back({instr.dst, instr.a});
+				}
+			}
+			
+			for (auto [product, k] : products) {
+				int d = -1;
+				
+				for (auto [factor, reg] : reduced) {
+					if (factor == k)
+						d = reg;
+				}
+				
+				if (d < 0) {
+					int start = function.newReg(), next = function.newReg();
+					d = function.newReg();
+					defBlock.resize(function.regCount, -1);
+					defBlock[start] = preheader;
+					defBlock[d] = loop.header;
+					defBlock[next] = induction.incBlock;
+					SSABlock& entry = function.blocks[preheader];
+					entry.code.insert(entry.code.begin() + terminatorPosition(entry), {MUL, start, induction.init, k});
+					IRInstr& phi = function.addPhi(loop.header, d, start);
+					function.phiArg(phi, inside) = next;
+					vector<IRInstr>& code = function.blocks[induction.incBlock].code;
+					
+					for (size_t i = 0; i < code.size(); i++) {
+						if (code[i].op == INC && code[i].dst == induction.next) {
+							code.insert(code.begin() + i + 1, {ADD, next, d, k});
+							break;
+						}
+					}
+					
+					reduced.push_back({k, d});
+				}
+				
+				replacement[product] = d;
+			}
+		}
+	}
+	
+	// 被削减的乘法改为复制，由复制传播消去
+	for (SSABlock& block : function.blocks) {
+		for (IRInstr& instr : block.code) {
+			if (instr.op == MUL && instr.dst < (int)replacement.size() && replacement[instr.dst] >= 0)
+				instr = {ASSIGN, instr.dst, replacement[instr.dst], 0};
+		}
+	}
+}
+
+// 常量次数循环的迭代次数：header以IF_GT结尾、一侧留在循环内，比较的是基本归纳变量i = φ(c, i + 1)和常量
+// 能确定时返回次数（可能为0），否则返回-1。只识别i < n（IF_GT n > i进入循环）和i <= n（IF_GT i > n离开循环）
+int64_t loopTripCount(const SSAFunction& function, const NaturalLoop& loop, const vector<char>& known,
+                      const vector<int>& constValue, const vector<int>& defBlock) {
+	const SSABlock& header = function.blocks[loop.header];
+	
+	if (header.code.empty() || header.code.back().op != IF_GT || header.preds.size() != 2 || loop.latches.size() != 1)
+		return -1;
+		
+	const IRInstr& branch = header.code.back();
+	bool stayWhenTrue = loop.contains(header.succs[0]);
+	
+	if (stayWhenTrue == loop.contains(header.succs[1]))
+		return -1;
+		
+	int inside = header.preds[0] == loop.latches[0] ? 0 : 1;
+	
+	for (const IRInstr& phi : header.code) {
+		if (phi.op != PHI)
+			break;
+			
+		int init = function.phiArgs[phi.a + 1 - inside];
+		int next = function.phiArgs[phi.a + inside];
+		
+		if (!known[init] || defBlock[next] < 0 || !loop.contains(defBlock[next]))
+			continue;
+			
+		bool increments = false;
+		
+		for (const IRInstr& instr : function.blocks[defBlock[next]].code) {
+			if (instr.op == INC && instr.dst == next && instr.a == phi.dst)
+				increments = true;
+		}
+		
+		if (!increments)
+			continue;
+			
+		int64_t start = constValue[init];
+		
+		if (branch.b == phi.dst && known[branch.a] && stayWhenTrue) // n > i
+			return max<int64_t>(0, constValue[branch.a] - start);
+			
+		if (branch.a == phi.dst && known[branch.b] && !stayWhenTrue && constValue[branch.b] != INT32_MAX) // !(i > n)
+			return max<int64_t>(0, (int64_t)constValue[branch.b] - start + 1);
+	}
+	
+	return -1;
+}
+
+// 展开次数为常量T的最内层循环：选不超过unrollFactor、能整除T的最大倍数f，把循环体（含header）再复制f-1份首尾相接
+// 副本中header的比较一定成立，改为直接进入循环体，φ改为取上一份的值；只允许从header离开循环，
+// 因此循环外只能用到原header中的值，不需要新的φ。副本放在原循环之后，最后由mergeBlocks合并直线相连的块
+void unrollLoops(SSAFunction& function, const LoopOptions& options) {
+	if (options.unrollFactor < 2)
+		return;
+		
+	DominatorTree dom(function.blocks);
+	vector<NaturalLoop> loops = findLoops(function.blocks, dom);
+	
+	if (loops.empty())
+		return;
+		
+	vector<int> defBlock = definingBlocks(function);
+	vector<char> known;
+	vector<int> constValue;
+	findConstants(function, known, constValue);
+	int originalBlocks = (int)function.blocks.size();
+	vector<vector<int>> placedAfter(originalBlocks); // 原块 -> 紧跟其后的副本
+	bool unrolled = false;
+	
+	for (const NaturalLoop& loop : loops) {
+		if (!loop.innermost)
+			continue;
+			
+		bool singleExit = true;
+		size_t size = 0;
+		
+		for (int b : loop.blocks) {
+			size += function.blocks[b].code.size();
+			
+			for (int succ : function.blocks[b].succs) {
+				if (b != loop.header && !loop.contains(succ))
+					singleExit = false;
+			}
+		}
+		
+		int64_t trips = singleExit ? loopTripCount(function, loop, known, constValue, defBlock) : -1;
+		int factor = (int)min<int64_t>(options.unrollFactor, trips);
+		
+		while (factor >= 2 && (trips % factor != 0 || size * (factor - 1) > (size_t)options.maxUnrolledSize)) {
+			factor--;
+		}
+		
+		if (factor < 2)
+			continue;
+			
+		const vector<int>& blocks = loop.blocks;
+		int n = (int)blocks.size();
+		int header = loop.header, latch = loop.latches[0];
+		auto position = [&](int block) {
+			return (int)(lower_bound(blocks.begin(), blocks.end(), block) - blocks.begin());
+		};
+		const SSABlock& original = function.blocks[header];
+		int inside = original.preds[0] == latch ? 0 : 1;
+		int stay = loop.contains(original.succs[0]) ? original.succs[0] : original.succs[1];
+		int originalRegs = function.regCount;
+		vector<int> previous(originalRegs, -1); // 上一份中的寄存器，-1表示与原循环相同（或在循环外定义）
+		auto value = [](const vector<int>& map, int reg) {
+			return reg < (int)map.size() && map[reg] >= 0 ? map[reg] : reg;
+		};
+		int first = (int)function.blocks.size();
+		
+		for (int copy = 1; copy < factor; copy++) {
+			vector<int> current(originalRegs, -1);
+			
+			for (int b : blocks) {
+				for (const IRInstr& instr : function.blocks[b].code) {
+					int d = irDef(instr);
+					
+					if (d >= 0)
+						current[d] = function.newReg();
+				}
+			}
+			
+			int base = (int)function.blocks.size();
+			int nextHeader = copy + 1 < factor ? base + n + position(header) : header;
+			auto target = [&](int succ) {
+				return succ == header ? nextHeader : base + position(succ);
+			};
+			auto rename = [&](int reg) {
+				return value(current, reg);
+			};
+			
+			for (int b : blocks) {
+				SSABlock block;
+				
+				for (const IRInstr& instr : function.blocks[b].code) {
+					if (instr.op == PHI && b == header) {
+						block.code.push_back({ASSIGN, current[instr.dst], value(previous, function.phiArgs[instr.a + inside]), 0});
+					}
+					else if (instr.op == PHI) {
+						IRInstr phi = {PHI, current[instr.dst], (int)function.phiArgs.size(), instr.b};
+						
+						for (int k = 0; k < instr.b; k++) {
+							int arg = function.phiArgs[instr.a + k];
+							function.phiArgs.push_back(value(current, arg));
+						}
+						
+						block.code.push_back(phi);
+					}
+					else if (instr.op == IF_GT && b == header) { // 副本中比较一定成立
+						continue;
+					}
+					else {
+						IRInstr clone = instr;
+						irRenameUses(clone, rename);
+						
+						if (irDef(clone) >= 0)
+							clone.dst = current[clone.dst];
+							
+						block.code.push_back(clone);
+					}
+				}
+				
+				if (b == header) {
+					block.succs = {target(stay)};
+					block.preds = {copy == 1 ? latch : base - n + position(latch)};
+				}
+				else {
+					for (int succ : function.blocks[b].succs) {
+						block.succs.push_back(target(succ));
+					}
+					
+					for (int pred : function.blocks[b].preds) { // 非header块的前驱都在循环内
+						block.preds.push_back(base + position(pred));
+					}
+				}
+				
+				function.blocks.push_back(move(block));
+			}
+			
+			previous.swap(current);
+		}
+		
+		int lastLatch = (int)function.blocks.size() - n + position(latch);
+		
+		for (int& succ : function.blocks[latch].succs) {
+			if (succ == header)
+				succ = first + position(header);
+		}
+		
+		SSABlock& entry = function.blocks[header];
+		entry.preds[inside] = lastLatch;
+		
+		for (const IRInstr& phi : entry.code) {
+			if (phi.op != PHI)
+				break;
+				
+			function.phiArgs[phi.a + inside] = value(previous, function.phiArgs[phi.a + inside]);
+		}
+		
+		for (int b = first; b < (int)function.blocks.size(); b++) {
+			placedAfter[blocks.back()].push_back(b);
+		}
+		
+		unrolled = true;
+	}
+	
+	if (!unrolled)
+		return;
+		
+	vector<int> order;
+	order.reserve(function.blocks.size());
+	
+	for (int b = 0; b < originalBlocks; b++) {
+		order.push_back(b);
+		order.insert(order.end(), placedAfter[b].begin(), placedAfter[b].end());
+	}
+	
+	function.reorderBlocks(order);
+	function.mergeBlocks();
+}
+
+#endif /*OPT_LOOPS_H*/
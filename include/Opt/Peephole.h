@@ -0,0 +1,392 @@
+#ifndef OPT_PEEPHOLE_H
+#define OPT_PEEPHOLE_H
+
+#include<cstdint>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"../IR/SSA.h"
+#include"./DeadCode.h"
+using namespace std;
+
+// 线性IR上的窥孔优化，每个函数只扫描常数遍，不构造CFG和SSA，不做其他优化时也可以一直开着
+// 线性IR中同一个寄存器可以被多次定义，所以传播的事实只在基本块内（两个被引用的标签之间）有效，源寄存器被重新定义后失效
+class Peephole {
+		// 寄存器r的值：epoch不是当前的基本块时无效；source >= 0表示与source（其第sourceVersion次定义）相同
+		struct Fact {
+			int epoch;
+			int source;
+			int sourceVersion;
+			bool constant;
+			int value;
+		};
+		
+		vector<IRInstr> out;
+		vector<Fact> facts;
+		vector<int> version; // 寄存器被定义的次数
+		vector<int> position; // 标签 -> 所在位置
+		vector<int> target; // 标签 -> 跳转穿透后的最终目标
+		vector<char> state; // 跳转穿透的访问状态：0未访问，1在当前路径上，2已完成
+		vector<int> refs; // 标签被跳转引用的次数
+		vector<int> path;
+		int epoch;
+		size_t removed;
+		
+		// 跳到label等价于跳到哪个标签：label之后（跳过连续的标签）若是Goto则沿着它继续，成环时停在环上
+		// 连续的标签统一为最后一个，同一目标只算一次
+		int resolve(const vector<IRInstr>& IR, size_t end, int label) {
+			path.clear();
+			int current = label, result;
+			
+			while (true) {
+				if (current >= (int)position.size() || position[current] < 0) { // 未定义的标签留给加载时报错
+					result = current;
+					break;
+				}
+				
+				if (state[current] == 2) {
+					result = target[current];
+					break;
+				}
+				
+				if (state[current] == 1) {
+					result = current;
+					break;
+				}
+				
+				state[current] = 1;
+				path.push_back(current);
+				size_t k = position[current];
+				
+				while (k < end && IR[k].op == LABEL) {
+					k++;
+				}
+				
+				if (k < end && IR[k].op == Goto) {
+					current = IR[k].dst;
+				}
+				else {
+					result = IR[k - 1].dst;
+					break;
+				}
+			}
+			
+			for (int label : path) {
+				state[label] = 2;
+				target[label] = result;
+			}
+			
+			return result;
+		}
+		
+		int sourceOf(int reg) const {
+			const Fact& fact = facts[reg];
+			return fact.epoch == epoch && fact.source >= 0 && version[fact.source] == fact.sourceVersion ? fact.source : reg;
+		}
+		
+		bool constantOf(int reg, int& value) const {
+			if (facts[reg].epoch != epoch || !facts[reg].constant)
+				return false;
+				
+			value = facts[reg].value;
+			return true;
+		}
+		
+		// dst被重新定义，之后的值与source相同（-1表示不知道），是否为常量由constant、value给出
+		void define(int dst, int source, bool constant, int value) {
+			version[dst]++;
+			facts[dst] = {epoch, source, source >= 0 ? version[source] : 0, constant, value};
+		}
+		
+		// 代数化简和常量折叠，操作数已换成源寄存器
+		void simplify(IRInstr& instr) {
+			int operands[2], x = 0, y = 0, result;
+			int count = irUses(instr, operands);
+			bool cx = count >= 1 && constantOf(instr.a, x);
+			bool cy = count >= 2 && constantOf(instr.b, y);
+			
+			if (cx && (cy || instr.op == ASSIGN || instr.op == INC || instr.op == NOT) && irEvaluate(instr.op, x, y, result)) {
+				instr = {CONST, instr.dst, result, 0};
+				return;
+			}
+			
+			switch (instr.op) {
+				case ADD:
+					if (cy && y == 0)
+						instr = {ASSIGN, instr.dst, instr.a, 0};
+					else if (cx && x == 0)
+						instr = {ASSIGN, instr.dst, instr.b, 0};
+						
+					break;
+					
+				case SUB:
+					if (cy && y == 0)
+						instr = {ASSIGN, instr.dst, instr.a, 0};
+					else if (instr.a == instr.b)
+						instr = {CONST, instr.dst, 0, 0};
+						
+					break;
+					
+				case MUL:
+					if ((cx && x == 0) || (cy && y == 0))
+						instr = {CONST, instr.dst, 0, 0};
+					else if (cy && y == 1)
+						instr = {ASSIGN, instr.dst, instr.a, 0};
+					else if (cx && x == 1)
+						instr = {ASSIGN, instr.dst, instr.b, 0};
+						
+					break;
+					
+				case DIV:
+					if (cy && y == 1)
+						instr = {ASSIGN, instr.dst, instr.a, 0};
+						
+					break;
+					
+				default:
+					break;
+			}
+		}
+		
+		// 跳到这个标签的紧邻跳转（中间只隔着标签）是多余的
+		void removeJumpsTo(int label, size_t functionStart) {
+			size_t j = out.size();
+			
+			while (j > functionStart + 1 && out[j - 1].op == LABEL) {
+				j--;
+			}
+			
+			while (j > functionStart + 1 && (out[j - 1].op == Goto || out[j - 1].op == IF_GT) && out[j - 1].dst == label) {
+				out.erase(out.begin() + (j - 1));
+				refs[label]--;
+				removed++;
+				j--;
+			}
+		}
+		
+		// 删除结果没人用且没有副作用的指令，被删指令的操作数随之可能变成没人用（工作表，线性）
+		void removeDeadDefinitions(size_t functionStart) {
+			size_t count = out.size() - functionStart;
+			int regCount = out[functionStart].dst;
+			vector<int> uses(regCount, 0), defStart(regCount + 1, 0), defs(count), worklist;
+			vector<char> known(regCount, 0), dead(count, 0);
+			vector<int> constValue(regCount, 0);
+			int operands[2];
+			
+			for (size_t i = functionStart + 1; i < out.size(); i++) {
+				int n = irUses(out[i], operands);
+				
+				for (int k = 0; k < n; k++) {
+					uses[operands[k]]++;
+				}
+				
+				int d = irDef(out[i]);
+				
+				if (d >= 0)
+					defStart[d + 1]++;
+			}
+			
+			for (int r = 0; r < regCount; r++) {
+				defStart[r + 1] += defStart[r];
+			}
+			
+			vector<int> fill(defStart.begin(), defStart.end() - 1);
+			
+			for (size_t i = functionStart + 1; i < out.size(); i++) {
+				int d = irDef(out[i]);
+				
+				if (d < 0)
+					continue;
+					
+				defs[fill[d]++] = (int)i;
+				
+				// 只被定义一次的CONST，供irHasSideEffect判断DIV
+				if (out[i].op == CONST && defStart[d + 1] - defStart[d] == 1) {
+					known[d] = 1;
+					constValue[d] = out[i].a;
+				}
+			}
+			
+			auto tryRemove = [&](int i) {
+				const IRInstr& instr = out[i];
+				
+				if (!dead[i - functionStart] && uses[instr.dst] == 0 && !irHasSideEffect(instr, known, constValue)) {
+					dead[i - functionStart] = 1;
+					worklist.push_back(i);
+				}
+			};
+			
+			for (size_t i = functionStart + 1; i < out.size(); i++) {
+				if (irDef(out[i]) >= 0)
+					tryRemove((int)i);
+			}
+			
+			while (!worklist.empty()) {
+				int i = worklist.back();
+				worklist.pop_back();
+				int n = irUses(out[i], operands);
+				
+				for (int k = 0; k < n; k++) {
+					int r = operands[k];
+					
+					if (--uses[r] > 0)
+						continue;
+						
+					for (int d = defStart[r]; d < defStart[r + 1]; d++) {
+						tryRemove(defs[d]);
+					}
+				}
+			}
+			
+			size_t write = functionStart + 1;
+			
+			for (size_t i = functionStart + 1; i < out.size(); i++) {
+				if (dead[i - functionStart])
+					removed++;
+				else
+					out[write++] = out[i];
+			}
+			
+			out.resize(write);
+		}
+		
+		void runFunction(const vector<IRInstr>& IR, size_t begin, size_t end) {
+			int regCount = IR[begin].dst, labelCount = 0;
+			
+			for (size_t i = begin + 1; i < end; i++) {
+				if (IR[i].op == LABEL || IR[i].op == Goto || IR[i].op == IF_GT)
+					labelCount = max(labelCount, IR[i].dst + 1);
+			}
+			
+			position.assign(labelCount, -1);
+			target.assign(labelCount, -1);
+			state.assign(labelCount, 0);
+			refs.assign(labelCount, 0);
+			facts.assign(regCount, {-1, -1, 0, false, 0});
+			version.assign(regCount, 0);
+			
+			for (size_t i = begin + 1; i < end; i++) {
+				if (IR[i].op == LABEL)
+					position[IR[i].dst] = (int)i;
+			}
+			
+			// 第一遍：跳转穿透，统计每个标签被引用的次数
+			vector<IRInstr> code(IR.begin() + begin + 1, IR.begin() + end);
+			
+			for (IRInstr& instr : code) {
+				if (instr.op == Goto || instr.op == IF_GT) {
+					instr.dst = resolve(IR, end, instr.dst);
+					refs[instr.dst]++;
+				}
+			}
+			
+			// 第二遍：顺序改写，结果接在out末尾
+			size_t functionStart = out.size();
+			out.push_back(IR[begin]);
+			epoch++;
+			
+			for (IRInstr& instr : code) {
+				bool reachable = out.back().op != Goto && out.back().op != RET;
+				
+				if (instr.op == LABEL) {
+					removeJumpsTo(instr.dst, functionStart);
+					
+					if (refs[instr.dst] == 0) { // 只能顺序执行到这里，不是基本块的开始
+						removed++;
+						continue;
+					}
+					
+					epoch++;
+					out.push_back(instr);
+					continue;
+				}
+				
+				if (!reachable) { // Goto/RET之后、下一个被引用的标签之前
+					if (instr.op == Goto || instr.op == IF_GT)
+						refs[instr.dst]--;
+						
+					removed++;
+					continue;
+				}
+				
+				irRenameUses(instr, [this](int reg) {
+					return sourceOf(reg);
+				});
+				
+				if (instr.op == IF_GT) {
+					int x, y;
+					bool decided = instr.a == instr.b || (constantOf(instr.a, x) && constantOf(instr.b, y));
+					
+					if (decided && instr.a != instr.b && x > y) {
+						instr = {Goto, instr.dst, 0, 0};
+					}
+					else if (decided) {
+						refs[instr.dst]--;
+						removed++;
+						continue;
+					}
+				}
+				
+				int d = irDef(instr);
+				
+				if (d < 0) {
+					out.push_back(instr);
+					continue;
+				}
+				
+				simplify(instr);
+				
+				if (instr.op == ASSIGN && instr.a == d) { // 复制给自己
+					removed++;
+					continue;
+				}
+				
+				if (instr.op == CONST)
+					define(d, -1, true, instr.a);
+				else if (instr.op == ASSIGN)
+					define(d, instr.a, false, 0);
+				else
+					define(d, -1, false, 0);
+					
+				out.push_back(instr);
+			}
+			
+			removeDeadDefinitions(functionStart);
+		}
+		
+	public:
+		Peephole() : epoch(0), removed(0) {}
+		
+		// 共扫描两轮：第一轮删掉死代码后会露出新的机会（只剩Goto的块、变得紧邻的跳转），第二轮处理它们
+		void run(vector<IRInstr>& IR) {
+			for (int round = 0; round < 2; round++) {
+				out.clear();
+				out.reserve(IR.size());
+				
+				for (size_t i = 0; i < IR.size();) {
+					if (IR[i].op != FUNC) {
+						out.push_back(IR[i++]);
+						continue;
+					}
+					
+					size_t end = irFunctionEnd(IR, i);
+					runFunction(IR, i, end);
+					i = end;
+				}
+				
+				IR.swap(out);
+			}
+		}
+		
+		size_t getRemoved() const {
+			return removed;
+		}
+};
+
+// 窥孔优化：跳转穿透；基本块内的复制传播、常量折叠和代数化简（x + 0、x - 0、x * 1、x / 1、x * 0、x - x）；
+// 删除跳到下一条指令的跳转、条件为常量的IF_GT、不可达的指令、没有引用的标签，以及结果没人用的指令
+void peephole(vector<IRInstr>& IR) {
+	Peephole pass;
+	pass.run(IR);
+}
+
+#endif /*OPT_PEEPHOLE_H*/
@@ -0,0 +1,48 @@
+#ifndef OPT_PIPELINE_H
+#define OPT_PIPELINE_H
+
+#include"../IR/PassManager.h"
+#include"./ConstantFolding.h"
+#include"./DeadCode.h"
+#include"./Inliner.h"
+#include"./Loops.h"
+#include"./Peephole.h"
+#include"./Vectorize.h"
+using namespace std;
+
+// 默认的优化流水线，按执行顺序登记
+// 先做线性的窥孔优化，再在整个程序上内联小函数，删掉不可达的函数和没人读的全局变量，再逐个函数优化（常量传播之后做循环优化）
+void addStandardPasses(PassManager& passes, const InlineOptions& inlineOptions = InlineOptions(),
+                       const LoopOptions& loopOptions = LoopOptions()) {
+	passes.addProgramPass("peephole", peephole);
+	passes.addProgramPass("inline", [inlineOptions](vector<IRInstr>& IR) {
+		Inliner inliner(inlineOptions);
+		inliner.run(IR);
+	});
+	passes.addProgramPass("unreachable functions", removeUnreachableFunctions);
+	passes.addProgramPass("unused globals", removeUnusedGlobals);
+	passes.addFunctionPass("sccp", sccp);
+	
+	if (loopOptions.hoistInvariants)
+		passes.addFunctionPass("loop invariant motion", hoistLoopInvariants);
+		
+	if (loopOptions.reduceStrength)
+		passes.addFunctionPass("induction variables", reduceInductionVariables);
+		
+	if (loopOptions.vectorize)
+		passes.addFunctionPass("vectorization", vectorizeLoops);
+		
+	if (loopOptions.unrollFactor > 1) {
+		passes.addFunctionPass("loop unrolling", [loopOptions](SSAFunction& function) {
+			unrollLoops(function, loopOptions);
+		});
+	}
+	
+	passes.addFunctionPass("copy propagation", [](SSAFunction& function) {
+		function.propagateCopies();
+	});
+	passes.addFunctionPass("dead stores", eliminateDeadStores);
+	passes.addFunctionPass("dead code", eliminateDeadCode);
+}
+
+#endif /*OPT_PIPELINE_H*/
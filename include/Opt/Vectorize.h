@@ -0,0 +1,313 @@
+#ifndef OPT_VECTORIZE_H
+#define OPT_VECTORIZE_H
+
+#include<algorithm>
+#include<cstdint>
+#include<vector>
+#include"../IR/CFG.h"
+#include"../IR/IRbase.h"
+#include"../IR/SSA.h"
+#include"./Loops.h"
+using namespace std;
+
+// 向量化一个最内层循环 for (int i = s; i < n; i++;) { ... }，成功时返回新加的四个块（放在原header之前）
+// 形状：只有header和一个循环体块，header中只有i = φ(s, i + 1)和IF_GT n > i（n为循环不变量）；
+// 循环体只读写下标为i + c（c为常量）的数组元素，并对读出的值做逐元素的+ - *，另一侧可以是循环不变量（广播到每个分量）
+// 被写的数组的所有访问下标都相同，不同迭代之间没有依赖；只读的数组下标可以不同
+// 其他情况（DIV、比较、调用、全局变量、把i当作值、下标不是i + c、可能的跨迭代依赖、向量寄存器不够）保持标量代码
+// 新的向量循环每次处理VECTOR_WIDTH次迭代，在i + (VECTOR_WIDTH - 1)不溢出且小于n时执行，剩下的迭代由原循环（标量尾循环）完成
+vector<int> vectorizeLoop(SSAFunction& function, const NaturalLoop& loop, const vector<int>& defBlock,
+                          const vector<char>& known, const vector<int>& constValue) {
+	if (!loop.innermost || loop.blocks.size() != 2 || loop.latches.size() != 1 || loop.latches[0] == loop.header)
+		return {};
+		
+	int preheader = loopPreheader(function, loop);
+	int header = loop.header, body = loop.latches[0];
+	const SSABlock& head = function.blocks[header];
+	const vector<IRInstr>& code = function.blocks[body].code;
+	
+	if (preheader < 0 || head.preds.size() != 2 || head.code.size() != 2 || head.code[0].op != PHI ||
+	        head.code[1].op != IF_GT || head.succs[0] != body || function.blocks[body].preds.size() != 1)
+		return {};
+		
+	const IRInstr& phi = head.code[0];
+	int inside = head.preds[0] == body ? 0 : 1;
+	int i = phi.dst, init = function.phiArgs[phi.a + 1 - inside], next = function.phiArgs[phi.a + inside];
+	int bound = head.code[1].a;
+	auto invariant = [&](int reg) {
+		return defBlock[reg] < 0 || !loop.contains(defBlock[reg]);
+	};
+	
+	if (head.code[1].b != i || !invariant(bound))
+		return {};
+		
+	// 循环体内每个值的类别：INDEX为i + offset，VECTOR为逐元素的值；ASSIGN只是别名，source指向被复制的值
+	enum Kind : uint8_t { OTHER, INVARIANT, INDEX, VECTOR };
+	int regCount = function.regCount;
+	vector<uint8_t> kind(regCount, OTHER);
+	vector<int64_t> offset(regCount, 0);
+	vector<int> source(regCount, -1);
+	auto resolve = [&](int reg) {
+		return source[reg] >= 0 ? source[reg] : reg;
+	};
+	auto kindOf = [&](int reg) {
+		return reg == i ? INDEX : invariant(reg) ? INVARIANT : (Kind)kind[reg];
+	};
+	auto isOperand = [&](int reg) { // 逐元素运算的操作数
+		return kindOf(reg) == VECTOR || kindOf(reg) == INVARIANT;
+	};
+	
+	struct Access {
+		int array;
+		int64_t offset;
+		bool store;
+	};
+	vector<Access> accesses;
+	size_t end = terminatorPosition(function.blocks[body]);
+	bool incremented = false, stores = false;
+	
+	for (size_t k = 0; k < end; k++) {
+		const IRInstr& instr = code[k];
+		bool binary = instr.op == STOREA || instr.op == ADD || instr.op == SUB || instr.op == MUL;
+		int x = binary || instr.op == ASSIGN || instr.op == LOADA ? resolve(instr.a) : -1;
+		int y = binary ? resolve(instr.b) : -1;
+		
+		switch (instr.op) {
+			case INC:
+				if (instr.dst != next || instr.a != i || incremented)
+					return {};
+					
+				incremented = true;
+				break;
+				
+			case ASSIGN:
+				source[instr.dst] = x;
+				break;
+				
+			case LOADA:
+				if (kindOf(x) != INDEX)
+					return {};
+					
+				kind[instr.dst] = VECTOR;
+				accesses.push_back({instr.b, offset[x], false});
+				break;
+				
+			case STOREA:
+				if (kindOf(x) != INDEX || !isOperand(y))
+					return {};
+					
+				accesses.push_back({instr.dst, offset[x], true});
+				stores = true;
+				break;
+				
+			case ADD:
+			case SUB:
+			case MUL:
+				if (instr.op != MUL && kindOf(x) == INDEX && kindOf(y) == INVARIANT && known[y]) { // 下标i + c、i - c
+					kind[instr.dst] = INDEX;
+					offset[instr.dst] = instr.op == ADD ? offset[x] + constValue[y] : offset[x] - constValue[y];
+				}
+				else if (instr.op == ADD && kindOf(y) == INDEX && kindOf(x) == INVARIANT && known[x]) {
+					kind[instr.dst] = INDEX;
+					offset[instr.dst] = offset[y] + constValue[x];
+				}
+				else if (isOperand(x) && isOperand(y) && (kindOf(x) == VECTOR || kindOf(y) == VECTOR)) {
+					kind[instr.dst] = VECTOR;
+				}
+				else {
+					return {};
+				}
+				
+				if (kind[instr.dst] == INDEX && (offset[instr.dst] > (1 << 20) || offset[instr.dst] < -(1 << 20)))
+					return {};
+					
+				break;
+				
+			default:
+				return {};
+		}
+	}
+	
+	if (!incremented || !stores)
+		return {};
+		
+	for (const Access& store : accesses) {
+		for (const Access& other : accesses) {
+			if (store.store && other.array == store.array && other.offset != store.offset)
+				return {};
+		}
+	}
+	
+	// 分配向量寄存器：被广播的不变量占用整个循环，其余的值在最后一次使用之后归还
+	vector<int> vreg(regCount, -1), lastUse(regCount, -1), splats;
+	int used = 0;
+	
+	for (size_t k = 0; k < end; k++) {
+		const IRInstr& instr = code[k];
+		bool elementwise = instr.op == STOREA || ((instr.op == ADD || instr.op == SUB || instr.op == MUL) && kind[instr.dst] == VECTOR);
+		
+		if (!elementwise)
+			continue;
+			
+		for (int reg : {instr.op == STOREA ? -1 : resolve(instr.a), resolve(instr.b)}) {
+			if (reg < 0)
+				continue;
+				
+			if (kindOf(reg) == INVARIANT && vreg[reg] < 0) {
+				vreg[reg] = used++;
+				splats.push_back(reg);
+			}
+			
+			lastUse[reg] = (int)k;
+		}
+	}
+	
+	vector<int> scalar(regCount, -1); // 循环体中的下标值 -> 向量循环中对应的寄存器
+	vector<int> freeRegs;
+	vector<IRInstr> vectorBody;
+	int vi = function.newReg();
+	scalar[i] = vi;
+	auto release = [&](int reg, int k) {
+		if (kindOf(reg) == VECTOR && lastUse[reg] == k)
+			freeRegs.push_back(vreg[reg]);
+	};
+	auto allocate = [&](int reg, int k) {
+		if (!freeRegs.empty()) {
+			vreg[reg] = freeRegs.back();
+			freeRegs.pop_back();
+		}
+		else {
+			vreg[reg] = used++;
+		}
+		
+		if (lastUse[reg] < k) // 结果没人用
+			freeRegs.push_back(vreg[reg]);
+	};
+	
+	for (size_t k = 0; k < end; k++) {
+		const IRInstr& instr = code[k];
+		int x = instr.op == INC || instr.op == ASSIGN ? -1 : resolve(instr.a);
+		int y = instr.op == INC || instr.op == ASSIGN || instr.op == LOADA ? -1 : resolve(instr.b);
+		
+		switch (instr.op) {
+			case LOADA:
+				allocate(instr.dst, (int)k);
+				vectorBody.push_back({VLOAD, vreg[instr.dst], scalar[x], instr.b});
+				break;
+				
+			case STOREA:
+				vectorBody.push_back({VSTORE, instr.dst, scalar[x], vreg[y]});
+				release(y, (int)k);
+				break;
+				
+			case ADD:
+			case SUB:
+			case MUL:
+				if (kind[instr.dst] == INDEX) {
+					IRInstr clone = instr;
+					clone.dst = scalar[instr.dst] = function.newReg();
+					irRenameUses(clone, [&](int reg) {
+						return scalar[resolve(reg)] >= 0 ? scalar[resolve(reg)] : resolve(reg);
+					});
+					vectorBody.push_back(clone);
+					break;
+				}
+				
+				release(x, (int)k);
+				
+				if (y != x)
+					release(y, (int)k);
+					
+				allocate(instr.dst, (int)k);
+				vectorBody.push_back({instr.op == ADD ? VADD : instr.op == SUB ? VSUB : VMUL, vreg[instr.dst], vreg[x], vreg[y]});
+				break;
+				
+			default:
+				break;
+		}
+	}
+	
+	if (used > VECTOR_REGS) // 放弃，vi留作未使用的寄存器
+		return {};
+		
+	// 向量循环的四个块：VH为φ和溢出检查，VC比较边界，VB为循环体，VE汇合后进入原header
+	int VH = (int)function.blocks.size(), VC = VH + 1, VB = VH + 2, VE = VH + 3;
+	int lastLane = function.newReg(), width = function.newReg(), limit = function.newReg(), vnext = function.newReg();
+	SSABlock& entry = function.blocks[preheader];
+	vector<IRInstr> setup = {{CONST, lastLane, VECTOR_WIDTH - 1, 0}, {CONST, width, VECTOR_WIDTH, 0}};
+	
+	for (int reg : splats) {
+		setup.push_back({VSPLAT, vreg[reg], reg, 0});
+	}
+	
+	entry.code.insert(entry.code.begin() + terminatorPosition(entry), setup.begin(), setup.end());
+	replace(entry.succs.begin(), entry.succs.end(), header, VH);
+	
+	vectorBody.push_back({ADD, vnext, vi, width});
+	vectorBody.push_back({Goto, 0, 0, 0});
+	IRInstr vphi = {PHI, vi, (int)function.phiArgs.size(), 2};
+	function.phiArgs.push_back(init);
+	function.phiArgs.push_back(vnext);
+	function.blocks.push_back({{vphi, {ADD, limit, vi, lastLane}, {IF_GT, 0, limit, vi}}, {VC, VE}, {preheader, VB}});
+	function.blocks.push_back({{{IF_GT, 0, bound, limit}}, {VB, VE}, {VH}});
+	function.blocks.push_back({vectorBody, {VH}, {VC}});
+	function.blocks.push_back({{{Goto, 0, 0, 0}}, {header}, {VH, VC}});
+	
+	SSABlock& original = function.blocks[header];
+	original.preds[1 - inside] = VE;
+	function.phiArgs[original.code[0].a + 1 - inside] = vi;
+	return {VH, VC, VB, VE};
+}
+
+// 对每个函数中所有可向量化的最内层循环做向量化，新块放在各自的原循环之前
+void vectorizeLoops(SSAFunction& function) {
+	bool stores = false; // 没有写数组的函数不用找循环
+	
+	for (const SSABlock& block : function.blocks) {
+		for (const IRInstr& instr : block.code) {
+			stores |= instr.op == STOREA;
+		}
+	}
+	
+	if (!stores)
+		return;
+		
+	DominatorTree dom(function.blocks);
+	vector<NaturalLoop> loops = findLoops(function.blocks, dom);
+	
+	if (loops.empty())
+		return;
+		
+	vector<int> defBlock = definingBlocks(function);
+	vector<char> known;
+	vector<int> constValue;
+	findConstants(function, known, constValue);
+	int originalBlocks = (int)function.blocks.size();
+	vector<vector<int>> placedBefore(originalBlocks);
+	bool vectorized = false;
+	
+	for (const NaturalLoop& loop : loops) {
+		vector<int> added = vectorizeLoop(function, loop, defBlock, known, constValue);
+		
+		if (added.empty())
+			continue;
+			
+		placedBefore[loop.header] = added;
+		vectorized = true;
+	}
+	
+	if (!vectorized)
+		return;
+		
+	vector<int> order;
+	order.reserve(function.blocks.size());
+	
+	for (int b = 0; b < originalBlocks; b++) {
+		order.insert(order.end(), placedBefore[b].begin(), placedBefore[b].end());
+		order.push_back(b);
+	}
+	
+	function.reorderBlocks(order);
+}
+
+#endif /*OPT_VECTORIZE_H*/
@@ -0,0 +1,82 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include<atomic>
+#include<cstdint>
+#include<stdexcept>
+#include<vector>
+using namespace std;
+
+// 单生产者单消费者的无锁环形队列，槽位预先分配，生产者和消费者都在槽位上原地读写，不拷贝也不分配内存
+// 生产者：acquire()取得一个空槽，填好后publish()；消费者：front()取得最早发布的槽，用完后release()
+// head、tail只增不减（按2^32回绕），各自只由一方写入，另一方用acquire读取；二者放在不同的缓存行，避免伪共享
+// 队列满/空时先自旋一小段，再用atomic::wait睡眠（Linux上是futex），不会一直占着核
+template<typename T>
+class RingBuffer {
+		static const int SPIN_COUNT = 256;
+		
+		vector<T> slots;
+		uint32_t mask;
+		alignas(64) atomic<uint32_t> head; // 已发布的槽数，只由生产者写
+		alignas(64) atomic<uint32_t> tail; // 已释放的槽数，只由消费者写
+		
+		// 等到counter不再等于old
+		static void waitWhileEqual(const atomic<uint32_t>& counter, uint32_t old) {
+			for (int i = 0; i < SPIN_COUNT; i++) {
+				if (counter.load(memory_order_acquire) != old)
+					return;
+			}
+			
+			counter.wait(old, memory_order_acquire);
+		}
+		
+	public:
+		// capacity须为2的幂
+		explicit RingBuffer(uint32_t capacity) : slots(capacity), mask(capacity - 1), head(0), tail(0) {
+			if (capacity == 0 || (capacity & mask) != 0)
+				throw invalid_argument("RingBuffer capacity must be a power of two");
+		}
+		
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+		
+		// 生产者：等到有空槽，返回它（内容是这个槽上一次的数据，可以复用其中已分配的内存）
+		T& acquire() {
+			uint32_t h = head.load(memory_order_relaxed);
+			
+			while (true) {
+				uint32_t t = tail.load(memory_order_acquire);
+				
+				if (h - t <= mask)
+					return slots[h & mask];
+					
+				waitWhileEqual(tail, t);
+			}
+		}
+		
+		void publish() {
+			head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+			head.notify_one();
+		}
+		
+		// 消费者：等到有已发布的槽，返回最早的一个
+		T& front() {
+			uint32_t t = tail.load(memory_order_relaxed);
+			
+			while (true) {
+				uint32_t h = head.load(memory_order_acquire);
+				
+				if (h != t)
+					return slots[t & mask];
+					
+				waitWhileEqual(head, h);
+			}
+		}
+		
+		void release() {
+			tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+			tail.notify_one();
+		}
+};
+
+#endif /*RING_BUFFER_H*/
@@ -0,0 +1,180 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include<string>
+#include<string_view>
+#include<fstream>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include<windows.h>
+#else
+	#include<sys/mman.h>
+	#include<sys/stat.h>
+	#include<fcntl.h>
+	#include<unistd.h>
+#endif
+using namespace std;
+
+// 源码缓冲区：优先把文件整体mmap进内存，Token直接以string_view引用其中的字节
+// 映射失败（空文件、特殊文件等）时回退为一次性读入自有缓冲区
+class SourceBuffer {
+		const char* data;
+		size_t length;
+		bool mapped;
+		string owned; // 回退模式下持有的源码
+		#ifdef _WIN32
+		HANDLE fileHandle;
+		HANDLE mappingHandle;
+		#endif
+		
+		bool mapFile(const string& fileName) {
+			#ifdef _WIN32
+			fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			
+			if (fileHandle == INVALID_HANDLE_VALUE) {
+				fileHandle = nullptr;
+				return false;
+			}
+			
+			LARGE_INTEGER size;
+			
+			if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+				return false;
+			}
+			
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			
+			if (!mappingHandle) {
+				return false;
+			}
+			
+			void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+			
+			if (!view) {
+				return false;
+			}
+			
+			data = (const char*)view;
+			length = (size_t)size.QuadPart;
+			#else
+			int fd = ::open(fileName.c_str(), O_RDONLY);
+			
+			if (fd < 0) {
+				return false;
+			}
+			
+			struct stat st;
+			
+			if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+				::close(fd);
+				return false;
+			}
+			
+			void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd); // 映射建立后即可关闭描述符
+			
+			if (view == MAP_FAILED) {
+				return false;
+			}
+			
+			madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+			data = (const char*)view;
+			length = (size_t)st.st_size;
+			#endif
+			mapped = true;
+			return true;
+		}
+		
+		void unmap() {
+			#ifdef _WIN32
+			if (mapped) {
+				UnmapViewOfFile(data);
+			}
+			
+			if (mappingHandle) {
+				CloseHandle(mappingHandle);
+			}
+			
+			if (fileHandle) {
+				CloseHandle(fileHandle);
+			}
+			
+			fileHandle = nullptr;
+			mappingHandle = nullptr;
+			#else
+			if (mapped) {
+				munmap((void*)data, length);
+			}
+			
+			#endif
+			mapped = false;
+			data = nullptr;
+			length = 0;
+		}
+		
+	public:
+		SourceBuffer() : data(nullptr), length(0), mapped(false) {
+			#ifdef _WIN32
+			fileHandle = nullptr;
+			mappingHandle = nullptr;
+			#endif
+		}
+		
+		SourceBuffer(const SourceBuffer&) = delete;
+		SourceBuffer& operator=(const SourceBuffer&) = delete;
+		
+		// 打开源文件，返回是否成功
+		bool open(const string& fileName) {
+			unmap();
+			owned.clear();
+			
+			if (mapFile(fileName)) {
+				return true;
+			}
+			
+			unmap();
+			ifstream in(fileName, ios::in | ios::binary);
+			
+			if (!in) {
+				return false;
+			}
+			
+			in.seekg(0, ios::end);
+			streamoff size = in.tellg();
+			in.seekg(0, ios::beg);
+			owned.resize(size > 0 ? (size_t)size : 0);
+			in.read(&owned[0], owned.size());
+			data = owned.data();
+			length = owned.size();
+			return true;
+		}
+		
+		// 直接使用内存中的源码
+		void assign(string text) {
+			unmap();
+			owned = std::move(text);
+			data = owned.data();
+			length = owned.size();
+		}
+		
+		string_view view() const {
+			return string_view(data ? data : "", length);
+		}
+		
+		bool isMapped() const {
+			return mapped;
+		}
+		
+		~SourceBuffer() {
+			unmap();
+		}
+};
+
+#endif /*SOURCE_BUFFER_H*/
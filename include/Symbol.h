@@ -0,0 +1,148 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<string>
+#include<string_view>
+#include<vector>
+using namespace std;
+
+typedef uint32_t Symbol; // 驻留字符串的编号
+
+// 字符串驻留表：每个不同的词素只保存一份，并分配一个32位编号
+// 编号从0开始连续分配，文本存放在按块分配的内存里，返回的string_view在表的生命周期内一直有效
+class StringInterner {
+		vector<uint32_t> slots; // 开放寻址哈希表，存 编号+1，0表示空槽
+		vector<uint32_t> hashes; // 每个编号对应的哈希值，扩容时免去重新计算
+		vector<string_view> names; // 编号 -> 文本
+		vector<unique_ptr<char[]>> chunks; // 文本存储块
+		char* chunkPos;
+		size_t chunkLeft;
+		
+		static const size_t CHUNK_SIZE = 64 * 1024;
+		
+		static uint32_t hashString(string_view str) {
+			uint32_t h = 2166136261u; // FNV-1a
+			
+			for (char c : str) {
+				h ^= (unsigned char)c;
+				h *= 16777619u;
+			}
+			
+			return h;
+		}
+		
+		string_view store(string_view str) {
+			if (str.size() > chunkLeft) {
+				size_t size = str.size() > CHUNK_SIZE ? str.size() : CHUNK_SIZE;
+				chunks.emplace_back(new char[size]);
+				chunkPos = chunks.back().get();
+				chunkLeft = size;
+			}
+			
+			if (!str.empty()) {
+				memcpy(chunkPos, str.data(), str.size());
+			}
+			
+			string_view stored(chunkPos, str.size());
+			chunkPos += str.size();
+			chunkLeft -= str.size();
+			return stored;
+		}
+		
+		void grow() {
+			vector<uint32_t> newSlots(slots.empty() ? 1024 : slots.size() * 2, 0);
+			size_t mask = newSlots.size() - 1;
+			
+			for (uint32_t id = 0; id < names.size(); id++) {
+				size_t i = hashes[id] & mask;
+				
+				while (newSlots[i]) {
+					i = (i + 1) & mask;
+				}
+				
+				newSlots[i] = id + 1;
+			}
+			
+			slots.swap(newSlots);
+		}
+		
+	public:
+		StringInterner() : chunkPos(nullptr), chunkLeft(0) {
+			grow();
+		}
+		
+		StringInterner(const StringInterner&) = delete;
+		StringInterner& operator=(const StringInterner&) = delete;
+		
+		// 返回str的编号，首次出现时登记
+		Symbol intern(string_view str) {
+			uint32_t h = hashString(str);
+			size_t mask = slots.size() - 1;
+			size_t i = h & mask;
+			
+			while (uint32_t slot = slots[i]) {
+				if (hashes[slot - 1] == h && names[slot - 1] == str) {
+					return slot - 1;
+				}
+				
+				i = (i + 1) & mask;
+			}
+			
+			Symbol id = (Symbol)names.size();
+			names.push_back(store(str));
+			hashes.push_back(h);
+			slots[i] = id + 1;
+			
+			if (names.size() * 2 > slots.size()) { // 装载因子超过1/2时扩容
+				grow();
+			}
+			
+			return id;
+		}
+		
+		// 表的当前状态，release(mark)把之后登记的符号全部撤销
+		struct Mark {
+			size_t names;
+			size_t chunks;
+			char* chunkPos;
+			size_t chunkLeft;
+		};
+		
+		Mark mark() const {
+			return {names.size(), chunks.size(), chunkPos, chunkLeft};
+		}
+		
+		// 线性探测下先登记的编号不会探测经过后登记的编号的槽（扩容时也按编号顺序重新插入），直接清掉后者的槽即可
+		void release(const Mark& m) {
+			size_t mask = slots.size() - 1;
+			
+			for (size_t id = m.names; id < names.size(); id++) {
+				size_t i = hashes[id] & mask;
+				
+				while (slots[i] != id + 1) {
+					i = (i + 1) & mask;
+				}
+				
+				slots[i] = 0;
+			}
+			
+			names.resize(m.names);
+			hashes.resize(m.names);
+			chunks.resize(m.chunks);
+			chunkPos = m.chunkPos;
+			chunkLeft = m.chunkLeft;
+		}
+		
+		string_view str(Symbol id) const {
+			return names[id];
+		}
+		
+		size_t size() const {
+			return names.size();
+		}
+};
+
+#endif /*SYMBOL_H*/
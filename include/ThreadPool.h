@@ -0,0 +1,192 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<exception>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+using namespace std;
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，从队尾取自己的任务；自己的队列空了就从其他线程的队首偷
+// 外部提交的任务轮流放进各个队列，工作线程中提交的任务放进自己的队列（后提交的先执行，局部性更好）
+// 任务抛出的第一个异常在wait()中重新抛出
+class ThreadPool {
+		struct Worker {
+			mutex lock;
+			deque<function<void()>> tasks;
+		};
+		
+		vector<unique_ptr<Worker>> workers;
+		vector<thread> threads;
+		mutex stateLock;
+		condition_variable wakeup; // 有新任务或线程池要销毁
+		condition_variable finished; // 所有任务都已完成
+		atomic<size_t> queued; // 已提交、还没开始执行的任务数（包括正在放入队列的）
+		atomic<size_t> pending; // 已提交、尚未完成的任务数
+		size_t nextQueue;
+		bool stopping;
+		exception_ptr error;
+		
+		// 当前线程所属的线程池和编号，不是工作线程时为nullptr
+		static ThreadPool*& currentPool() {
+			static thread_local ThreadPool* pool = nullptr;
+			return pool;
+		}
+		
+		static int& currentIndex() {
+			static thread_local int index = -1;
+			return index;
+		}
+		
+		bool pop(int self, function<void()>& task) {
+			Worker& worker = *workers[self];
+			lock_guard<mutex> guard(worker.lock);
+			
+			if (worker.tasks.empty())
+				return false;
+				
+			task = move(worker.tasks.back());
+			worker.tasks.pop_back();
+			return true;
+		}
+		
+		bool steal(int self, function<void()>& task) {
+			int count = (int)workers.size();
+			
+			for (int k = 1; k < count; k++) {
+				Worker& victim = *workers[(self + k) % count];
+				lock_guard<mutex> guard(victim.lock);
+				
+				if (victim.tasks.empty())
+					continue;
+					
+				task = move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+			
+			return false;
+		}
+		
+		void execute(function<void()>& task) {
+			queued--;
+			
+			try {
+				task();
+			}
+			catch (...) {
+				lock_guard<mutex> guard(stateLock);
+				
+				if (!error)
+					error = current_exception();
+			}
+			
+			task = nullptr;
+			
+			if (--pending == 0) {
+				lock_guard<mutex> guard(stateLock);
+				finished.notify_all();
+			}
+		}
+		
+		void workerLoop(int self) {
+			currentPool() = this;
+			currentIndex() = self;
+			function<void()> task;
+			
+			while (true) {
+				if (pop(self, task) || steal(self, task)) {
+					execute(task);
+					continue;
+				}
+				
+				unique_lock<mutex> guard(stateLock);
+				wakeup.wait(guard, [this] {
+					return stopping || queued > 0;
+				});
+				
+				if (stopping && queued == 0)
+					return;
+			}
+		}
+		
+	public:
+		// threads为0时按硬件线程数
+		explicit ThreadPool(size_t threadCount = 0) : queued(0), pending(0), nextQueue(0), stopping(false) {
+			if (threadCount == 0)
+				threadCount = max(1u, thread::hardware_concurrency());
+				
+			for (size_t i = 0; i < threadCount; i++) {
+				workers.emplace_back(new Worker());
+			}
+			
+			for (size_t i = 0; i < threadCount; i++) {
+				threads.emplace_back(&ThreadPool::workerLoop, this, (int)i);
+			}
+		}
+		
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		
+		// 等队列中的任务全部执行完再退出
+		~ThreadPool() {
+			{
+				lock_guard<mutex> guard(stateLock);
+				stopping = true;
+				wakeup.notify_all();
+			}
+			
+			for (thread& t : threads) {
+				t.join();
+			}
+		}
+		
+		// queued在任务放入队列之前增加：否则别的线程可能先取走任务执行queued--，使计数暂时回绕成SIZE_MAX
+		void submit(function<void()> task) {
+			int target;
+			pending++;
+			queued++;
+			
+			if (currentPool() == this) {
+				target = currentIndex();
+			}
+			else {
+				lock_guard<mutex> guard(stateLock);
+				target = (int)(nextQueue++ % workers.size());
+			}
+			
+			{
+				lock_guard<mutex> guard(workers[target]->lock);
+				workers[target]->tasks.push_back(move(task));
+			}
+			
+			lock_guard<mutex> guard(stateLock);
+			wakeup.notify_one();
+		}
+		
+		// 等待所有已提交的任务完成（不能在工作线程中调用）
+		void wait() {
+			unique_lock<mutex> guard(stateLock);
+			finished.wait(guard, [this] {
+				return pending == 0;
+			});
+			
+			if (error) {
+				exception_ptr e = error;
+				error = nullptr;
+				rethrow_exception(e);
+			}
+		}
+		
+		size_t size() const {
+			return threads.size();
+		}
+};
+
+#endif /*THREAD_POOL_H*/
@@ -2,7 +2,8 @@
 #define TOKEN_H
 
 #include<string>
-#include<unordered_map>
+#include<string_view>
+#include"./Symbol.h"
 using namespace std;
 
 enum TokenType {
@@ -13,7 +14,14 @@ enum TokenType {
 	Punctuators, // 分隔符
 };
 
-unordered_map<string, TokenType> StringToTokenType = {
+// 关键字/运算符/分隔符表，编译期据此生成完美哈希
+// 表中下标同时就是该拼写的Symbol编号（见PredefinedSymbol）
+struct TokenSpelling {
+	string_view text;
+	TokenType type;
+};
+
+constexpr TokenSpelling TokenTable[] = {
 	{"int", Keywords}, {"return", Keywords},
 	{"if", Keywords}, {"else", Keywords},
 	{"for", Keywords}, // 关键字
@@ -24,6 +32,7 @@ unordered_map<string, TokenType> StringToTokenType = {
 	{">", Operators}, {"<", Operators}, {"==", Operators},
 	{"!=", Operators}, {">=", Operators}, {"<=", Operators}, // 新增比较运算符
 	{"++", Operators}, // 新增自增算符
+	{"=", Operators}, // 赋值
 	
 	{"(", Punctuators}, {")", Punctuators},
 	{"[", Punctuators}, {"]", Punctuators},
@@ -31,9 +40,96 @@ unordered_map<string, TokenType> StringToTokenType = {
 	{";", Punctuators}, {",", Punctuators} // 符号
 };
 
-bool isStringDigit(const string& str) {
+constexpr size_t TOKEN_TABLE_COUNT = sizeof(TokenTable) / sizeof(TokenTable[0]);
+
+// 预定义符号，顺序必须与TokenTable一致
+enum PredefinedSymbol : Symbol {
+	SYM_INT, SYM_RETURN, SYM_IF, SYM_ELSE, SYM_FOR,
+	SYM_ADD, SYM_SUB, SYM_MUL, SYM_DIV,
+	SYM_AND, SYM_OR, SYM_NOT,
+	SYM_GT, SYM_LT, SYM_EQ, SYM_NE, SYM_GE, SYM_LE,
+	SYM_INC, SYM_ASSIGN,
+	SYM_LPAREN, SYM_RPAREN, SYM_LBRACKET, SYM_RBRACKET,
+	SYM_LBRACE, SYM_RBRACE, SYM_SEMICOLON, SYM_COMMA,
+	PREDEFINED_SYMBOL_COUNT
+};
+
+static_assert(PREDEFINED_SYMBOL_COUNT == TOKEN_TABLE_COUNT, "PredefinedSymbol out of sync with TokenTable");
+static_assert(TokenTable[SYM_FOR].text == "for" && TokenTable[SYM_ASSIGN].text == "=" &&
+              TokenTable[SYM_COMMA].text == ",", "PredefinedSymbol out of sync with TokenTable");
+constexpr size_t TOKEN_HASH_SIZE = 64; // 哈希槽数（2的幂）
+
+// 表中最长的拼写，更长的串不可能是关键字/符号
+constexpr size_t tokenTableMaxLength() {
+	size_t len = 0;
+	
+	for (const TokenSpelling& t : TokenTable) {
+		len = t.text.size() > len ? t.text.size() : len;
+	}
+	
+	return len;
+}
+
+constexpr size_t TOKEN_MAX_LENGTH = tokenTableMaxLength();
+
+// 只看长度、首字符、末字符，str非空
+constexpr unsigned tokenHash(string_view str, unsigned seed) {
+	unsigned h = (unsigned)str.size() * 131u + (unsigned char)str[0];
+	h = h * seed + (unsigned char)str[str.size() - 1];
+	return (h ^ (h >> 7)) & (TOKEN_HASH_SIZE - 1);
+}
+
+// 编译期搜索一个使表内所有拼写互不冲突的种子
+constexpr unsigned findTokenHashSeed() {
+	for (unsigned seed = 1; seed < 4096; seed++) {
+		bool used[TOKEN_HASH_SIZE] = {};
+		bool ok = true;
+		
+		for (const TokenSpelling& t : TokenTable) {
+			unsigned h = tokenHash(t.text, seed);
+			
+			if (used[h]) {
+				ok = false;
+				break;
+			}
+			
+			used[h] = true;
+		}
+		
+		if (ok) {
+			return seed;
+		}
+	}
+	
+	return 0;
+}
+
+constexpr unsigned TOKEN_HASH_SEED = findTokenHashSeed();
+static_assert(TOKEN_HASH_SEED != 0, "no perfect hash seed for TokenTable");
+
+struct TokenHashTable {
+	signed char slot[TOKEN_HASH_SIZE]; // 槽 -> TokenTable下标，-1为空
+};
+
+constexpr TokenHashTable buildTokenHashTable() {
+	TokenHashTable table = {};
+	
+	for (size_t i = 0; i < TOKEN_HASH_SIZE; i++) {
+		table.slot[i] = -1;
+	}
+	
+	for (size_t i = 0; i < TOKEN_TABLE_COUNT; i++) {
+		table.slot[tokenHash(TokenTable[i].text, TOKEN_HASH_SEED)] = (signed char)i;
+	}
+	
+	return table;
+}
+
+constexpr TokenHashTable TokenTypeHash = buildTokenHashTable();
+
+bool isStringDigit(string_view str) {
 	for (const char& c : str) {
-		if (!isdigit(c)) {
+		if (!('0' <= c && c <= '9')) {
 			return 0;
 		}
 	}
@@ -41,35 +137,143 @@ bool isStringDigit(const string& str) {
 	return 1;
 }
 
-TokenType getTokenType(const string& str) {
-	if (StringToTokenType.find(str) != StringToTokenType.end()) {
-		return StringToTokenType[str];
+// 查找关键字/符号表，返回下标（即预定义Symbol），不在表中返回-1
+int findTokenSpelling(string_view str) {
+	if (!str.empty() && str.size() <= TOKEN_MAX_LENGTH) {
+		signed char idx = TokenTypeHash.slot[tokenHash(str, TOKEN_HASH_SEED)];
+		
+		if (idx >= 0 && TokenTable[idx].text == str) {
+			return idx;
+		}
+	}
+	
+	return -1;
+}
+
+// 一次哈希 + 一次比较完成分类，不再查unordered_map
+TokenType getTokenType(string_view str) {
+	int idx = findTokenSpelling(str);
+	
+	if (idx >= 0) {
+		return TokenTable[idx].type;
 	}
-	else if (isStringDigit(str)) {
+	
+	if (isStringDigit(str)) {
 		return Literals;
 	}
 	
 	return Identifiers;
 }
 
+// 符号表：构造时按TokenTable顺序登记预定义符号，使其编号等于表下标
+class GlobalSymbolTable : public StringInterner {
+	public:
+		GlobalSymbolTable() {
+			for (const TokenSpelling& spelling : TokenTable) {
+				intern(spelling.text);
+			}
+		}
+};
+
+// 每个线程一张符号表，并行编译时各线程登记符号互不加锁
+// 同一份源码的词法分析、AST、IR、优化和代码生成须在同一个线程内完成，Symbol只在产生它的线程中有意义
+thread_local GlobalSymbolTable SymbolTable;
+
+string_view symbolName(Symbol id) {
+	return SymbolTable.str(id);
+}
+
+// 一次编译的符号作用域：析构时撤销作用域内登记到本线程符号表的所有符号，长期运行的线程编译很多文件时表不会一直增长
+// 作用域内产生的Symbol在析构后失效；同一线程中的作用域须按后进先出的顺序嵌套
+class SymbolScope {
+		StringInterner::Mark start;
+		
+	public:
+		SymbolScope() : start(SymbolTable.mark()) {}
+		
+		SymbolScope(const SymbolScope&) = delete;
+		SymbolScope& operator=(const SymbolScope&) = delete;
+		
+		~SymbolScope() {
+			SymbolTable.release(start);
+		}
+};
+
+// 词法分析切分出、已分好类但还没有驻留的词素，不依赖符号表，可以在别的线程中产生（见TokenPipeline.h）
+// spelling为预定义符号在TokenTable中的下标，标识符为LEXEME_IDENTIFIER，字面量为LEXEME_LITERAL
+const int LEXEME_IDENTIFIER = -1;
+const int LEXEME_LITERAL = -2;
+
+struct Lexeme {
+	string_view content;
+	size_t offset;
+	int spelling;
+	
+	Lexeme() {}
+	
+	Lexeme(string_view content, size_t offset) : content(content), offset(offset) {
+		spelling = findTokenSpelling(content);
+		
+		if (spelling < 0)
+			spelling = isStringDigit(content) ? LEXEME_LITERAL : LEXEME_IDENTIFIER;
+	}
+};
+
+// Token不持有字符串，content指向源码缓冲区（通常是mmap的文件），c为其在文件中的字节偏移
+// symbol为词素的驻留编号，比较Token只需比较整数
 class Token {
 		TokenType type;
-		string content;
-		int c;
+		Symbol symbol;
+		string_view content;
+		size_t c;
 	public:
 		Token() {}
 		
-		Token(const string& content, int c) {
+		Token(string_view content, size_t c) {
 			this->content = content;
-			type = getTokenType(content);
 			this->c = c;
+			int idx = findTokenSpelling(content);
+			
+			if (idx >= 0) {
+				type = TokenTable[idx].type;
+				symbol = (Symbol)idx;
+			}
+			else {
+				type = isStringDigit(content) ? Literals : Identifiers;
+				symbol = SymbolTable.intern(content);
+			}
 		}
 		
-		pair<TokenType, string> getToken() {
+		// 由别的线程分好类的词素构造，只剩标识符和字面量的驻留在当前线程完成
+		Token(const Lexeme& lexeme) : content(lexeme.content), c(lexeme.offset) {
+			if (lexeme.spelling >= 0) {
+				type = TokenTable[lexeme.spelling].type;
+				symbol = (Symbol)lexeme.spelling;
+			}
+			else {
+				type = lexeme.spelling == LEXEME_LITERAL ? Literals : Identifiers;
+				symbol = SymbolTable.intern(content);
+			}
+		}
+		
+		pair<TokenType, string_view> getToken() const {
 			return {type, content};
 		}
 		
-		~Token() {
+		TokenType getType() const {
+			return type;
+		}
+		
+		string_view getContent() const {
+			return content;
+		}
+		
+		Symbol getSymbol() const {
+			return symbol;
+		}
+		
+		size_t getOffset() const {
+			return c;
 		}
 };
 
@@ -0,0 +1,121 @@
+#ifndef TOKEN_PIPELINE_H
+#define TOKEN_PIPELINE_H
+
+#include<exception>
+#include<string_view>
+#include<thread>
+#include<vector>
+#include"./Token.h"
+#include"./Lexer.h"
+#include"./RingBuffer.h"
+using namespace std;
+
+// 流水线式的词法分析：构造时启动词法线程，切分出的词素按批经环形队列交给解析线程，解析与词法分析（以及缺页读入源码）重叠进行
+// 同时存在的只有队列中的几批和解析器缓冲区中的一批，不再需要整个Token序列
+// 词法线程只切分、分类，不碰thread_local的符号表；标识符和字面量在解析线程调用fill()时驻留，Symbol仍属于解析线程
+class TokenPipeline {
+		static const uint32_t QUEUE_BATCHES = 16;
+		static const size_t BATCH_SIZE = 1024;
+		
+		struct Batch {
+			vector<Lexeme> lexemes; // 为空表示输入结束
+			exception_ptr error; // 词法错误，是队列中的最后一批
+		};
+		
+		RingBuffer<Batch> queue;
+		bool finished; // 已经取到最后一批（解析线程）
+		size_t tokenCount; // 已经交给解析线程的Token数
+		thread lexerThread;
+		
+		// 词法线程：批满或输入结束时发布，最后发布一个空批（或带着词法错误的批）
+		void lex(string_view source) {
+			Lexer lexer(source);
+			size_t start, length;
+			bool last = false;
+			
+			while (!last) {
+				Batch& batch = queue.acquire();
+				batch.lexemes.clear();
+				batch.error = nullptr;
+				
+				try {
+					while (batch.lexemes.size() < BATCH_SIZE && lexer.next(start, length)) {
+						batch.lexemes.emplace_back(source.substr(start, length), start);
+					}
+				}
+				catch (...) {
+					batch.error = current_exception();
+				}
+				
+				last = batch.error || batch.lexemes.empty(); // 发布之后batch归解析线程，不能再读
+				queue.publish();
+			}
+		}
+		
+		// batch是最后一批时标记结束并释放它，带有词法错误时抛出
+		bool finish(Batch& batch) {
+			if (!batch.error && !batch.lexemes.empty())
+				return false;
+				
+			exception_ptr error = batch.error;
+			finished = true;
+			queue.release();
+			
+			if (error)
+				rethrow_exception(error);
+				
+			return true;
+		}
+		
+	public:
+		explicit TokenPipeline(string_view source) : queue(QUEUE_BATCHES), finished(false), tokenCount(0) {
+			lexerThread = thread(&TokenPipeline::lex, this, source);
+		}
+		
+		TokenPipeline(const TokenPipeline&) = delete;
+		TokenPipeline& operator=(const TokenPipeline&) = delete;
+		
+		~TokenPipeline() {
+			try {
+				drain();
+			}
+			catch (...) {
+			}
+			
+			lexerThread.join();
+		}
+		
+		// 把下一批词素转成Token追加到tokens末尾；输入已经结束时返回false，词法错误在这里重新抛出
+		bool fill(vector<Token>& tokens) {
+			if (finished)
+				return false;
+				
+			Batch& batch = queue.front();
+			
+			if (finish(batch))
+				return false;
+				
+			for (const Lexeme& lexeme : batch.lexemes) {
+				tokens.emplace_back(lexeme);
+			}
+			
+			tokenCount += batch.lexemes.size();
+			queue.release();
+			return true;
+		}
+		
+		size_t getTokenCount() const {
+			return tokenCount;
+		}
+		
+		// 丢弃剩下的词素直到输入结束，让词法线程能够退出；后面有词法错误时抛出它
+		// 解析中途出错时调用，这样报告的错误与先完整词法分析再解析时相同
+		void drain() {
+			while (!finished) {
+				if (!finish(queue.front()))
+					queue.release();
+			}
+		}
+};
+
+#endif /*TOKEN_PIPELINE_H*/
@@ -0,0 +1,514 @@
+#ifndef VM_H
+#define VM_H
+
+#include<cstdint>
+#include<cstring>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include"../IR/IRbase.h"
+#include"../Token.h"
+using namespace std;
+
+// GCC/Clang支持取标签地址（&&label），用直接线索化分派；其余编译器退化为switch分派
+#if defined(__GNUC__)
+	#define VM_THREADED
+#endif
+
+// 基于寄存器的虚拟机：每个函数的虚拟寄存器就是值栈上一段连续的槽位
+// 加载时把IR翻译为VMInstr：去掉LABEL/FUNC/GLOBAL/ARRAY，标签和被调函数都解析成指令下标，
+// ARG直接写入被调函数帧的形参槽位（即一次寄存器拷贝），执行时不再做任何查找
+class VM {
+		struct VMInstr {
+			const void* handler; // 直接线索化：本条指令处理代码的地址，首次执行时链接
+			IROp op;
+			int dst;
+			int a;
+			int b;
+		};
+		
+		struct Frame {
+			const VMInstr* returnIp;
+			int* regs;
+			int dst; // 返回值写入调用方的哪个寄存器
+		};
+		
+		vector<VMInstr> code;
+		vector<int> stack; // 预分配的值栈
+		vector<Frame> frames; // 预分配的调用帧栈
+		vector<int> globals;
+		int globalCount;
+		vector<int> arrayData; // 所有数组的元素依次相接
+		vector<pair<int, int>> arrays; // 数组编号 -> (在arrayData中的起点, 长度)
+		int maxRegs; // 所有函数中最大的寄存器数，用于栈溢出检查的余量
+		size_t entry; // 顶层语句的入口
+		const void* const* linkedTable; // code中handler当前对应的分派表
+		
+		// 翻译一个函数[begin, end)：标签换成指令下标，ARG换成写入被调帧的ASSIGN
+		void loadFunction(const vector<IRInstr>& IR, size_t begin, size_t end, vector<size_t>& calls) {
+			int frameSize = IR[begin].dst;
+			size_t base = code.size();
+			vector<size_t> labelPos;
+			
+			// 第一遍：记录每个标签对应的指令下标
+			size_t pos = base;
+			
+			for (size_t i = begin + 1; i < end; i++) {
+				if (IR[i].op == LABEL) {
+					if ((size_t)IR[i].dst >= labelPos.size())
+						labelPos.resize(IR[i].dst + 1, SIZE_MAX);
+						
+					labelPos[IR[i].dst] = pos;
+				}
+				else {
+					pos++;
+				}
+			}
+			
+			// 第二遍：生成指令
+			int argIndex = 0;
+			
+			for (size_t i = begin + 1; i < end; i++) {
+				IRInstr instr = IR[i];
+				
+				switch (instr.op) {
+					case LABEL:
+						continue;
+						
+					case IF_GT:
+					case Goto:
+						if ((size_t)instr.dst >= labelPos.size() || labelPos[instr.dst] == SIZE_MAX)
+							throw runtime_error("Undefined label L" + to_string(instr.dst) + " in " + string(symbolName(IR[begin].a)));
+							
+						instr.dst = (int)labelPos[instr.dst];
+						break;
+						
+					case ARG: // 实参直接放进被调函数帧（紧跟在当前帧之后）的第argIndex个寄存器
+						instr.op = ASSIGN;
+						instr.dst = frameSize + argIndex++;
+						break;
+						
+					case CALL:
+						calls.push_back(code.size());
+						instr.b = frameSize; // 被调帧的起点相对当前帧的偏移
+						argIndex = 0;
+						break;
+						
+					case FUNC:
+					case GLOBAL:
+					case ARRAY:
+					case PHI: // 执行前须先退出SSA形式
+						throw runtime_error("Malformed IR: unexpected " + IROpToString[instr.op]);
+						
+					default:
+						break;
+				}
+				
+				code.push_back({nullptr, instr.op, instr.dst, instr.a, instr.b});
+			}
+		}
+		
+		template<bool COUNT>
+		int execute(uint64_t* executed);
+		
+	public:
+		VM(const vector<IRInstr>& IR, size_t stackSlots = 1 << 20)
+			: globalCount(0), maxRegs(1), entry(SIZE_MAX), linkedTable(nullptr) {
+			vector<size_t> functionEntry(SymbolTable.size(), SIZE_MAX); // 函数名 -> 入口
+			vector<size_t> calls;
+			Symbol topName = SymbolTable.intern(TOP_LEVEL_NAME);
+			
+			for (size_t i = 0; i < IR.size();) {
+				if (IR[i].op == GLOBAL) {
+					globalCount = max(globalCount, IR[i].dst + 1);
+					i++;
+					continue;
+				}
+				
+				if (IR[i].op == ARRAY) {
+					if ((size_t)IR[i].dst >= arrays.size())
+						arrays.resize(IR[i].dst + 1, {0, 0});
+						
+					arrays[IR[i].dst] = {(int)arrayData.size(), IR[i].b};
+					arrayData.resize(arrayData.size() + IR[i].b);
+					i++;
+					continue;
+				}
+				
+				if (IR[i].op != FUNC)
+					throw runtime_error("Malformed IR: instruction outside of a function");
+					
+				size_t end = irFunctionEnd(IR, i);
+				Symbol name = (Symbol)IR[i].a;
+				
+				if (name >= functionEntry.size())
+					functionEntry.resize(name + 1, SIZE_MAX);
+					
+				functionEntry[name] = code.size();
+				
+				if (name == topName)
+					entry = code.size();
+					
+				maxRegs = max(maxRegs, IR[i].dst);
+				loadFunction(IR, i, end, calls);
+				i = end;
+			}
+			
+			if (entry == SIZE_MAX)
+				throw runtime_error("Malformed IR: no top-level function");
+				
+			for (size_t i : calls) {
+				Symbol callee = (Symbol)code[i].a;
+				
+				if (callee >= functionEntry.size() || functionEntry[callee] == SIZE_MAX)
+					throw runtime_error("Undefined function: " + string(symbolName(callee)));
+					
+				code[i].a = (int)functionEntry[callee];
+			}
+			
+			stack.resize(stackSlots + 2 * maxRegs);
+			frames.resize(stackSlots / 8 + 1);
+			globals.resize(globalCount);
+		}
+		
+		VM(const VM&) = delete;
+		VM& operator=(const VM&) = delete;
+		
+		// 执行顶层语句，返回其返回值（没有return时为0）；每次运行前全局变量和数组清零
+		int run() {
+			return execute<false>(nullptr);
+		}
+		
+		// 同run()，并统计执行的指令条数
+		int run(uint64_t& executed) {
+			return execute<true>(&executed);
+		}
+		
+		size_t size() const {
+			return code.size();
+		}
+};
+
+// 32位整数运算按二进制补码回绕，避免有符号溢出
+#define VM_WRAP(expr) ((int)(uint32_t)(expr))
+
+template<bool COUNT>
+int VM::execute(uint64_t* executed) {
+	#ifdef VM_THREADED
+	// 与IROp的顺序一一对应，不会被执行的操作符指向op_BAD
+	static const void* const handlers[] = {
+		&&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_ASSIGN, &&op_IF_GT, &&op_Goto, &&op_INC,
+		&&op_CONST, &&op_EQ, &&op_NE, &&op_LT, &&op_LE, &&op_GT, &&op_GE, &&op_NOT,
+		&&op_BAD, &&op_BAD, &&op_CALL, &&op_RET, &&op_BAD, &&op_BAD, &&op_LOADG, &&op_STOREG,
+		&&op_BAD, &&op_BAD, &&op_LOADA, &&op_STOREA, &&op_VLOAD, &&op_VSTORE, &&op_VSPLAT, &&op_VADD,
+		&&op_VSUB, &&op_VMUL
+	};
+	static_assert(sizeof(handlers) / sizeof(handlers[0]) == VMUL + 1, "handlers must cover every IROp");
+	
+	if (linkedTable != handlers) {
+		for (VMInstr& instr : code) {
+			instr.handler = handlers[instr.op];
+		}
+		
+		linkedTable = handlers;
+	}
+	
+	#define VM_NEXT() do { if constexpr (COUNT) count++; goto *ip->handler; } while (0)
+	#else
+	#define VM_NEXT() do { if constexpr (COUNT) count++; goto dispatch; } while (0)
+	#endif
+	
+	const VMInstr* base = code.data();
+	const VMInstr* ip = base + entry;
+	int* regs = stack.data();
+	int* limit = stack.data() + stack.size() - 2 * maxRegs; // 新帧起点不得超过这里（留出本帧和实参的空间）
+	size_t depth = 0;
+	uint64_t count = 0;
+	int vregs[VECTOR_REGS][VECTOR_WIDTH]; // 向量寄存器，只在向量化的循环内使用，不随调用保存
+	fill(globals.begin(), globals.end(), 0);
+	fill(arrayData.begin(), arrayData.end(), 0);
+	
+	// 数组A中从index开始的count个元素，越界时报错
+	auto element = [&](int array, int index, int count) {
+		auto [start, length] = arrays[array];
+		
+		if (index < 0 || index > length - count)
+			throw runtime_error("Array index out of range");
+			
+		return arrayData.data() + start + index;
+	};
+	
+	VM_NEXT();
+	
+	#ifndef VM_THREADED
+dispatch:
+
+	switch (ip->op) {
+		case ADD:
+			goto op_ADD;
+			
+		case SUB:
+			goto op_SUB;
+			
+		case MUL:
+			goto op_MUL;
+			
+		case DIV:
+			goto op_DIV;
+			
+		case ASSIGN:
+			goto op_ASSIGN;
+			
+		case IF_GT:
+			goto op_IF_GT;
+			
+		case Goto:
+			goto op_Goto;
+			
+		case INC:
+			goto op_INC;
+			
+		case CONST:
+			goto op_CONST;
+			
+		case EQ:
+			goto op_EQ;
+			
+		case NE:
+			goto op_NE;
+			
+		case LT:
+			goto op_LT;
+			
+		case LE:
+			goto op_LE;
+			
+		case GT:
+			goto op_GT;
+			
+		case GE:
+			goto op_GE;
+			
+		case NOT:
+			goto op_NOT;
+			
+		case CALL:
+			goto op_CALL;
+			
+		case RET:
+			goto op_RET;
+			
+		case LOADG:
+			goto op_LOADG;
+			
+		case STOREG:
+			goto op_STOREG;
+			
+		case LOADA:
+			goto op_LOADA;
+			
+		case STOREA:
+			goto op_STOREA;
+			
+		case VLOAD:
+			goto op_VLOAD;
+			
+		case VSTORE:
+			goto op_VSTORE;
+			
+		case VSPLAT:
+			goto op_VSPLAT;
+			
+		case VADD:
+			goto op_VADD;
+			
+		case VSUB:
+			goto op_VSUB;
+			
+		case VMUL:
+			goto op_VMUL;
+			
+		default:
+			goto op_BAD;
+	}
+	
+	#endif
+	
+op_ADD:
+	regs[ip->dst] = VM_WRAP((uint32_t)regs[ip->a] + (uint32_t)regs[ip->b]);
+	ip++;
+	VM_NEXT();
+	
+op_SUB:
+	regs[ip->dst] = VM_WRAP((uint32_t)regs[ip->a] - (uint32_t)regs[ip->b]);
+	ip++;
+	VM_NEXT();
+	
+op_MUL:
+	regs[ip->dst] = VM_WRAP((uint32_t)regs[ip->a] * (uint32_t)regs[ip->b]);
+	ip++;
+	VM_NEXT();
+	
+op_DIV: {
+		int divisor = regs[ip->b];
+		
+		if (divisor == 0)
+			throw runtime_error("Division by zero");
+			
+		regs[ip->dst] = VM_WRAP((int64_t)regs[ip->a] / divisor);
+		ip++;
+		VM_NEXT();
+	}
+	
+op_ASSIGN:
+	regs[ip->dst] = regs[ip->a];
+	ip++;
+	VM_NEXT();
+	
+op_IF_GT:
+	ip = regs[ip->a] > regs[ip->b] ? base + ip->dst : ip + 1;
+	VM_NEXT();
+	
+op_Goto:
+	ip = base + ip->dst;
+	VM_NEXT();
+	
+op_INC:
+	regs[ip->dst] = VM_WRAP((uint32_t)regs[ip->a] + 1u);
+	ip++;
+	VM_NEXT();
+	
+op_CONST:
+	regs[ip->dst] = ip->a;
+	ip++;
+	VM_NEXT();
+	
+op_EQ:
+	regs[ip->dst] = regs[ip->a] == regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_NE:
+	regs[ip->dst] = regs[ip->a] != regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_LT:
+	regs[ip->dst] = regs[ip->a] < regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_LE:
+	regs[ip->dst] = regs[ip->a] <= regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_GT:
+	regs[ip->dst] = regs[ip->a] > regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_GE:
+	regs[ip->dst] = regs[ip->a] >= regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_NOT:
+	regs[ip->dst] = !regs[ip->a];
+	ip++;
+	VM_NEXT();
+	
+op_CALL:
+	if (regs + ip->b > limit || depth == frames.size())
+		throw runtime_error("Stack overflow");
+		
+	frames[depth++] = {ip + 1, regs, ip->dst};
+	regs += ip->b;
+	ip = base + ip->a;
+	VM_NEXT();
+	
+op_RET: {
+		int value = regs[ip->a];
+		
+		if (depth == 0) {
+			if constexpr (COUNT)
+				*executed = count;
+				
+			return value;
+		}
+		
+		const Frame& frame = frames[--depth];
+		regs = frame.regs;
+		regs[frame.dst] = value;
+		ip = frame.returnIp;
+		VM_NEXT();
+	}
+	
+op_LOADG:
+	regs[ip->dst] = globals[ip->a];
+	ip++;
+	VM_NEXT();
+	
+op_STOREG:
+	globals[ip->dst] = regs[ip->a];
+	ip++;
+	VM_NEXT();
+	
+op_LOADA:
+	regs[ip->dst] = *element(ip->b, regs[ip->a], 1);
+	ip++;
+	VM_NEXT();
+	
+op_STOREA:
+	*element(ip->dst, regs[ip->a], 1) = regs[ip->b];
+	ip++;
+	VM_NEXT();
+	
+op_VLOAD:
+	memcpy(vregs[ip->dst], element(ip->b, regs[ip->a], VECTOR_WIDTH), sizeof(vregs[0]));
+	ip++;
+	VM_NEXT();
+	
+op_VSTORE:
+	memcpy(element(ip->dst, regs[ip->a], VECTOR_WIDTH), vregs[ip->b], sizeof(vregs[0]));
+	ip++;
+	VM_NEXT();
+	
+op_VSPLAT:
+	fill(vregs[ip->dst], vregs[ip->dst] + VECTOR_WIDTH, regs[ip->a]);
+	ip++;
+	VM_NEXT();
+	
+op_VADD:
+	for (int k = 0; k < VECTOR_WIDTH; k++) {
+		vregs[ip->dst][k] = VM_WRAP((uint32_t)vregs[ip->a][k] + (uint32_t)vregs[ip->b][k]);
+	}
+	
+	ip++;
+	VM_NEXT();
+	
+op_VSUB:
+	for (int k = 0; k < VECTOR_WIDTH; k++) {
+		vregs[ip->dst][k] = VM_WRAP((uint32_t)vregs[ip->a][k] - (uint32_t)vregs[ip->b][k]);
+	}
+	
+	ip++;
+	VM_NEXT();
+	
+op_VMUL:
+	for (int k = 0; k < VECTOR_WIDTH; k++) {
+		vregs[ip->dst][k] = VM_WRAP((uint32_t)vregs[ip->a][k] * (uint32_t)vregs[ip->b][k]);
+	}
+	
+	ip++;
+	VM_NEXT();
+	
+op_BAD:
+	throw runtime_error("Malformed IR: " + IROpToString[ip->op] + " cannot be executed");
+	
+	#undef VM_NEXT
+}
+
+#undef VM_WRAP
+
+#endif /*VM_H*/
@@ -3,10 +3,101 @@
 #endif
 
 #include<bits/stdc++.h>
-#include"include/File.h"
+#include"include/Driver.h"
 using namespace std;
 
-int main() {
-	File file("code.txt");
-	return 0;
+// 不带参数时编译并执行code.txt
+// 带参数时把每个源文件编译为同名的.s汇编文件，多个文件在线程池上并行编译：
+//   MyG++ [-jN] [-O0] [--cache=目录] [--emit-binary] [--pipeline] 源文件...
+//   -jN 使用N个线程（默认为硬件线程数）  -O0 只做窥孔优化  --cache 把每个函数的IR缓存在目录中，没有改动的函数不再重新编译
+//   --emit-binary 另外把AST和IR写成二进制模块（源文件名.myb）  --pipeline 词法分析和语法分析在两个线程上流水线进行
+//   --time-report 编译结束后在标准错误上打印各阶段（所有文件合计）的耗时、内存分配和计数
+//   --time-report-json=文件 把每个文件和合计的计量结果写成JSON
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		File file("code.txt");
+		return file.run();
+	}
+	
+	DriverOptions options;
+	vector<string> inputs;
+	bool timeReport = false;
+	string timeReportJSON;
+	
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		
+		if (arg.compare(0, 2, "-j") == 0 && arg.size() > 2) {
+			options.jobs = stoul(arg.substr(2));
+		}
+		else if (arg == "-O0") {
+			options.optimize = false;
+		}
+		else if (arg == "--emit-binary") {
+			options.emitBinary = true;
+		}
+		else if (arg == "--pipeline") {
+			options.pipelined = true;
+		}
+		else if (arg == "--time-report") {
+			timeReport = true;
+		}
+		else if (arg.compare(0, 19, "--time-report-json=") == 0 && arg.size() > 19) {
+			timeReportJSON = arg.substr(19);
+		}
+		else if (arg.compare(0, 8, "--cache=") == 0 && arg.size() > 8) {
+			options.cacheDirectory = arg.substr(8);
+		}
+		else if (arg[0] == '-') {
+			cerr << "Unknown option: " << arg << endl;
+			return 2;
+		}
+		else {
+			inputs.push_back(arg);
+		}
+	}
+	
+	auto start = chrono::steady_clock::now();
+	vector<CompileResult> results = compileFiles(inputs, options);
+	double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	CompileStats total;
+	int failed = 0;
+	
+	for (const CompileResult& result : results) {
+		total.merge(result.stats);
+		
+		if (!result.ok) {
+			cerr << result.input << ": " << result.error << endl;
+			failed++;
+		}
+	}
+	
+	if (timeReport) {
+		total.print(cerr);
+		cerr << results.size() << " files, wall time " << wallMs << " ms" << endl;
+	}
+	
+	if (!timeReportJSON.empty()) {
+		ofstream out(timeReportJSON, ios::binary);
+		out << "{\"wallMs\": " << wallMs << ", \"files\": [";
+		
+		for (size_t i = 0; i < results.size(); i++) {
+			out << (i ? ", " : "") << "{\"input\": ";
+			writeJSONString(out, results[i].input);
+			out << ", \"ok\": " << (results[i].ok ? "true" : "false") << ", \"stats\": ";
+			results[i].stats.writeJSON(out);
+			out << "}";
+		}
+		
+		out << "], \"total\": ";
+		total.writeJSON(out);
+		out << "}\n";
+		
+		if (!out) {
+			cerr << "Cannot write " << timeReportJSON << endl;
+			return 1;
+		}
+	}
+	
+	return failed ? 1 : 0;
 }